@@ -0,0 +1,354 @@
+//-----------------------------------------------------------------------------
+///
+/// file: t_vtk-h_compositing.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <vtkh/rendering/Image.hpp>
+#include <vtkh/rendering/ImageCompositor.hpp>
+#include <vtkh/rendering/compositing/EmissionPartial.hpp>
+#include <vtkh/rendering/compositing/PartialSort.hpp>
+#include <vtkh/rendering/compositing/SparseImage.hpp>
+#include <vtkh/rendering/compositing/VolumePartial.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_image_codec.hpp>
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+
+// a compositing tile: background with a block of noisy surface in it
+void make_tile(const int width,
+               const int height,
+               std::vector<unsigned char> &pixels,
+               std::vector<float> &depths)
+{
+  pixels.assign(width * height * 4, 0);
+  depths.assign(width * height, 1.001f);
+  srand(7);
+  for(int y = height / 4; y < height / 2; ++y)
+  {
+    for(int x = width / 4; x < 3 * width / 4; ++x)
+    {
+      const int i = y * width + x;
+      for(int c = 0; c < 4; ++c)
+      {
+        pixels[i * 4 + c] = static_cast<unsigned char>(rand() % 256);
+      }
+      depths[i] = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    }
+  }
+}
+
+// an image over 'bounds' that is background except for a random
+// 'coverage' of the pixels inside 'active'
+vtkh::Image make_image(const vtkm::Bounds &bounds,
+                       const vtkm::Bounds &active,
+                       const float coverage,
+                       const unsigned int seed)
+{
+  vtkh::Image image(bounds);
+  std::fill(image.m_pixels.begin(), image.m_pixels.end(), 0);
+  std::fill(image.m_depths.begin(), image.m_depths.end(), 1.001f);
+  srand(seed);
+  const int dx = bounds.X.Max - bounds.X.Min + 1;
+  for(int y = active.Y.Min; y <= active.Y.Max; ++y)
+  {
+    for(int x = active.X.Min; x <= active.X.Max; ++x)
+    {
+      if(static_cast<float>(rand()) / static_cast<float>(RAND_MAX) >= coverage)
+      {
+        continue;
+      }
+      const int i = (y - bounds.Y.Min) * dx + x - bounds.X.Min;
+      for(int c = 0; c < 4; ++c)
+      {
+        image.m_pixels[i * 4 + c] = static_cast<unsigned char>(rand() % 256);
+      }
+      image.m_depths[i] = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+    }
+  }
+  return image;
+}
+
+int active_pixels(const vtkh::Image &image)
+{
+  return static_cast<int>(std::count_if(image.m_depths.begin(),
+                                        image.m_depths.end(),
+                                        [](const float depth) { return depth <= 1.f; }));
+}
+
+// restores the process wide codec settings
+struct CodecSettings
+{
+  bool m_enabled;
+  int  m_depth_bits;
+  CodecSettings()
+    : m_enabled(vtkh::ImageCodec::Enabled()),
+      m_depth_bits(vtkh::ImageCodec::DepthBits())
+  {}
+  ~CodecSettings()
+  {
+    vtkh::ImageCodec::Enabled() = m_enabled;
+    vtkh::ImageCodec::DepthBits() = m_depth_bits;
+  }
+};
+
+void round_trip(const std::vector<unsigned char> &pixels,
+                const std::vector<float> &depths,
+                std::vector<unsigned char> &out_pixels,
+                std::vector<float> &out_depths,
+                size_t &bytes)
+{
+  vtkhdiy::MemoryBuffer buffer;
+  vtkh::ImageCodec::SavePayload(buffer, pixels, depths);
+  bytes = buffer.size();
+  buffer.reset();
+  vtkh::ImageCodec::LoadPayload(buffer, out_pixels, out_depths);
+  EXPECT_EQ(buffer.position, buffer.size());
+}
+
+// the radix sort has to give exactly the order of std::stable_sort,
+// including which of two equal partials comes first
+template<typename PartialType>
+void check_partial_sort(const std::vector<PartialType> &partials)
+{
+  std::vector<PartialType> expected = partials;
+  std::stable_sort(expected.begin(), expected.end());
+  std::vector<PartialType> sorted = partials;
+  vtkh::detail::RadixSortPartials(sorted);
+
+  ASSERT_EQ(sorted.size(), expected.size());
+  for(size_t i = 0; i < sorted.size(); ++i)
+  {
+    EXPECT_EQ(sorted[i].m_pixel_id, expected[i].m_pixel_id);
+    EXPECT_EQ(sorted[i].m_depth, expected[i].m_depth);
+    EXPECT_TRUE(sorted[i].m_bins == expected[i].m_bins);
+  }
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+TEST(vtkh_compositing, vtkh_partial_sort)
+{
+  // enough partials that every chunk of a threaded sort gets some, few
+  // enough pixels and depths that most of them share both
+  const int size = 20000;
+  std::vector<vtkh::VolumePartial<float>> volume(size);
+  std::vector<vtkh::EmissionPartial<double>> emission(size);
+  srand(5);
+  for(int i = 0; i < size; ++i)
+  {
+    const int pixel = 1000 + rand() % 300;
+    volume[i].m_pixel_id = pixel;
+    volume[i].m_depth = static_cast<float>(rand() % 8) * .25f - 1.f;
+    volume[i].m_alpha = static_cast<float>(i);
+
+    emission[i].m_pixel_id = pixel;
+    // depths that differ past float precision, in descending order for
+    // part of the input, plus exact duplicates
+    const double tiny = static_cast<double>(rand() % 4) * 1e-12;
+    emission[i].m_depth = (i % 3 == 0) ? .5 : (i % 3 == 1 ? .5 - tiny : -2. + tiny);
+    emission[i].m_bins.push_back(static_cast<double>(i));
+  }
+
+  // the volume partials carry their index in alpha instead of bins
+  std::vector<vtkh::VolumePartial<float>> expected = volume;
+  std::stable_sort(expected.begin(), expected.end());
+  vtkh::detail::RadixSortPartials(volume);
+  for(int i = 0; i < size; ++i)
+  {
+    EXPECT_EQ(volume[i].m_pixel_id, expected[i].m_pixel_id);
+    EXPECT_EQ(volume[i].m_depth, expected[i].m_depth);
+    EXPECT_EQ(volume[i].m_alpha, expected[i].m_alpha);
+  }
+
+  check_partial_sort(emission);
+
+  // all in one pixel, and the same depth everywhere
+  for(int i = 0; i < size; ++i)
+  {
+    emission[i].m_pixel_id = 7;
+  }
+  check_partial_sort(emission);
+  for(int i = 0; i < size; ++i)
+  {
+    emission[i].m_depth = 1.;
+  }
+  check_partial_sort(emission);
+
+  std::vector<vtkh::EmissionPartial<double>> empty;
+  vtkh::detail::RadixSortPartials(empty);
+  EXPECT_TRUE(empty.empty());
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_compositing, vtkh_sparse_image)
+{
+  const vtkm::Bounds bounds(1, 96, 1, 64, 0, 0);
+  const vtkh::Image front = make_image(bounds, bounds, .5f, 3);
+  vtkh::ImageCompositor compositor;
+
+  // partly empty images, sparse enough to run length encode or not
+  const vtkm::Bounds active(20, 70, 10, 40, 0, 0);
+  const float coverage[2] = {.2f, 1.f};
+  for(int c = 0; c < 2; ++c)
+  {
+    const vtkh::Image back = make_image(bounds, active, coverage[c], 5 + c);
+    vtkh::Image expected = front;
+    compositor.ZBufferComposite(expected, back);
+
+    for(int rle = 0; rle < 2; ++rle)
+    {
+      vtkh::SparseImage sparse;
+      sparse.Encode(back, rle == 1);
+      EXPECT_FALSE(sparse.IsEmpty());
+      EXPECT_EQ(sparse.IsRunLengthEncoded(), rle == 1 && c == 0);
+      EXPECT_GE(sparse.m_active_bounds.X.Min, active.X.Min);
+      EXPECT_LE(sparse.m_active_bounds.X.Max, active.X.Max);
+      EXPECT_GE(sparse.m_active_bounds.Y.Min, active.Y.Min);
+      EXPECT_LE(sparse.m_active_bounds.Y.Max, active.Y.Max);
+      if(sparse.IsRunLengthEncoded())
+      {
+        // only the active pixels are kept
+        EXPECT_EQ(static_cast<int>(sparse.m_depths.size()), active_pixels(back));
+      }
+
+      vtkh::Image result = front;
+      sparse.CompositeInto(result);
+      EXPECT_TRUE(result.m_pixels == expected.m_pixels);
+      EXPECT_TRUE(result.m_depths == expected.m_depths);
+    }
+  }
+
+  // a tile composited into the larger image it belongs to
+  const vtkm::Bounds tile_bounds(33, 64, 17, 48, 0, 0);
+  const vtkh::Image tile = make_image(tile_bounds, vtkm::Bounds(40, 60, 20, 30, 0, 0), .3f, 9);
+  vtkh::Image padded = make_image(bounds, bounds, 0.f, 0);
+  tile.SubsetTo(padded);
+  vtkh::Image expected = front;
+  compositor.ZBufferComposite(expected, padded);
+
+  vtkh::SparseImage sparse;
+  sparse.Encode(tile, true);
+  EXPECT_TRUE(sparse.IsRunLengthEncoded());
+  vtkh::Image result = front;
+  sparse.CompositeInto(result);
+  EXPECT_TRUE(result.m_pixels == expected.m_pixels);
+  EXPECT_TRUE(result.m_depths == expected.m_depths);
+
+  // nothing active, nothing changes
+  sparse.Encode(make_image(bounds, bounds, 0.f, 0), true);
+  EXPECT_TRUE(sparse.IsEmpty());
+  EXPECT_TRUE(sparse.m_depths.empty());
+  result = front;
+  sparse.CompositeInto(result);
+  EXPECT_TRUE(result.m_pixels == front.m_pixels);
+  EXPECT_TRUE(result.m_depths == front.m_depths);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_compositing, vtkh_image_codec_round_trip)
+{
+  CodecSettings settings;
+  const int width = 128;
+  const int height = 64;
+  std::vector<unsigned char> pixels;
+  std::vector<float> depths;
+  make_tile(width, height, pixels, depths);
+
+  vtkh::ImageCodec::Enabled() = false;
+  std::vector<unsigned char> out_pixels;
+  std::vector<float> out_depths;
+  size_t plain_bytes;
+  round_trip(pixels, depths, out_pixels, out_depths, plain_bytes);
+  EXPECT_TRUE(out_pixels == pixels);
+  EXPECT_TRUE(out_depths == depths);
+
+  vtkh::ImageCodec::Enabled() = true;
+  const int bits[3] = {32, 24, 16};
+  for(int b = 0; b < 3; ++b)
+  {
+    vtkh::ImageCodec::DepthBits() = bits[b];
+    size_t bytes;
+    round_trip(pixels, depths, out_pixels, out_depths, bytes);
+    // most of the tile is background, so runs have to pay off
+    EXPECT_LT(bytes, plain_bytes);
+
+    // colors are always lossless
+    EXPECT_TRUE(out_pixels == pixels);
+    ASSERT_EQ(out_depths.size(), depths.size());
+    if(bits[b] == 32)
+    {
+      EXPECT_TRUE(out_depths == depths);
+      continue;
+    }
+
+    const float step = 1.f / static_cast<float>((1u << bits[b]) - 2u);
+    for(size_t i = 0; i < depths.size(); ++i)
+    {
+      if(depths[i] > 1.f)
+      {
+        EXPECT_GT(out_depths[i], 1.f);
+      }
+      else
+      {
+        EXPECT_LE(fabs(out_depths[i] - depths[i]), step);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_compositing, vtkh_image_codec_stream_modes)
+{
+  std::vector<uint32_t> runs(1000, 5u);
+  std::fill(runs.begin() + 500, runs.end(), 9u);
+  std::vector<uint32_t> noise(1000);
+  srand(11);
+  for(size_t i = 0; i < noise.size(); ++i)
+  {
+    noise[i] = static_cast<uint32_t>(rand()) & 0xffffff;
+  }
+  EXPECT_EQ(vtkh::ImageCodec::CountRuns(runs), 2);
+
+  const int widths[3] = {4, 3, 2};
+  for(int w = 0; w < 3; ++w)
+  {
+    const std::vector<uint32_t> *inputs[2] = {&runs, &noise};
+    for(int i = 0; i < 2; ++i)
+    {
+      std::vector<uint32_t> codes = *inputs[i];
+      const uint32_t mask = widths[w] == 4 ? 0xffffffffu : (1u << (8 * widths[w])) - 1u;
+      for(size_t c = 0; c < codes.size(); ++c)
+      {
+        codes[c] &= mask;
+      }
+
+      vtkhdiy::MemoryBuffer buffer;
+      vtkh::ImageCodec::SaveStream(buffer, codes, widths[w]);
+      // the first byte records which encoding the stream picked
+      const unsigned char mode = static_cast<unsigned char>(buffer.buffer[0]);
+      EXPECT_EQ(mode, i == 0 ? vtkh::ImageCodec::RUN_LENGTH : vtkh::ImageCodec::RAW);
+
+      buffer.reset();
+      std::vector<uint32_t> decoded;
+      vtkh::ImageCodec::LoadStream(buffer, decoded, widths[w]);
+      EXPECT_TRUE(decoded == codes);
+    }
+  }
+
+  // empty streams are legal, e.g. a rank with nothing in a tile
+  std::vector<uint32_t> empty, decoded(3, 1u);
+  vtkhdiy::MemoryBuffer buffer;
+  vtkh::ImageCodec::SaveStream(buffer, empty, 4);
+  buffer.reset();
+  vtkh::ImageCodec::LoadStream(buffer, decoded, 4);
+  EXPECT_TRUE(decoded.empty());
+}
@@ -0,0 +1,237 @@
+//-----------------------------------------------------------------------------
+///
+/// file: t_vtk-h_compositing_par.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <mpi.h>
+#include <vtkh/vtkh.hpp>
+#include <vtkh/rendering/Image.hpp>
+#include <vtkh/rendering/compositing/MPICollect.hpp>
+#include <vtkh/rendering/compositing/RadixKCompositor.hpp>
+#include <vtkh/rendering/compositing/SparseImage.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_collect.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_image_block.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_utils.hpp>
+
+#include <diy/decomposition.hpp>
+#include <diy/master.hpp>
+#include <diy/mpi.hpp>
+
+#include <iostream>
+
+namespace
+{
+
+// the tile this rank holds after compositing, filled with values that
+// depend on the pixel so misplaced tiles show up
+vtkh::Image make_tile(const vtkm::Bounds &global_bounds,
+                      const vtkhdiy::RegularDecomposer<vtkhdiy::DiscreteBounds> &decomposer,
+                      const int rank)
+{
+  vtkhdiy::DiscreteBounds tile_bounds;
+  decomposer.fill_bounds(tile_bounds, rank);
+
+  vtkh::Image tile(vtkh::DIYBoundsToVTKM(tile_bounds));
+  tile.m_orig_bounds = global_bounds;
+  tile.m_orig_rank = rank;
+
+  const int x0 = tile.m_bounds.X.Min;
+  const int y0 = tile.m_bounds.Y.Min;
+  const int dx = tile.m_bounds.X.Max - x0 + 1;
+  const int pixels = tile.GetNumberOfPixels();
+  for(int i = 0; i < pixels; ++i)
+  {
+    const int x = x0 + i % dx;
+    const int y = y0 + i / dx;
+    tile.m_pixels[i * 4 + 0] = static_cast<unsigned char>(x);
+    tile.m_pixels[i * 4 + 1] = static_cast<unsigned char>(y);
+    tile.m_pixels[i * 4 + 2] = static_cast<unsigned char>(rank);
+    tile.m_pixels[i * 4 + 3] = 255;
+    tile.m_depths[i] = static_cast<float>(x + y) / 1000.f;
+  }
+  return tile;
+}
+
+// a full image from one rank: a depth pattern that differs per rank
+// and some background, so the z-buffer winner changes from pixel to pixel
+vtkh::Image make_surface(const vtkm::Bounds &bounds, const int rank)
+{
+  vtkh::Image image(bounds);
+  image.m_orig_rank = rank;
+  const int dx = bounds.X.Max - bounds.X.Min + 1;
+  const int pixels = image.GetNumberOfPixels();
+  for(int i = 0; i < pixels; ++i)
+  {
+    const int x = i % dx;
+    const int y = i / dx;
+    const bool background = (x + y + rank) % 5 == 0;
+    image.m_depths[i] = background ? 1.001f
+                                   : ((x + 3 * y + 17 * rank) % 97) / 100.f + rank * 1e-4f;
+    for(int c = 0; c < 4; ++c)
+    {
+      image.m_pixels[i * 4 + c] = background ? 0 : static_cast<unsigned char>(rank * 40 + c + 1);
+    }
+  }
+  return image;
+}
+
+// the diy all_to_all gather the compositors used before MPICollect
+void diy_collect(vtkh::Image &image,
+                 vtkhdiy::mpi::communicator &diy_comm,
+                 const vtkhdiy::DiscreteBounds &global_bounds)
+{
+  const int num_blocks = diy_comm.size();
+  vtkhdiy::Master master(diy_comm, 1);
+  vtkhdiy::ContiguousAssigner assigner(num_blocks, num_blocks);
+
+  const int dims = 2;
+  vtkhdiy::RegularDecomposer<vtkhdiy::DiscreteBounds> decomposer(dims, global_bounds, num_blocks);
+  vtkh::AddImageBlock all_create(master, image);
+  decomposer.decompose(diy_comm.rank(), assigner, all_create);
+  MPI_Barrier(diy_comm);
+
+  vtkhdiy::all_to_all(master,
+                      assigner,
+                      vtkh::CollectImages(decomposer),
+                      8);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+TEST(vtkh_compositing_par, vtkh_radix_k_cost_model)
+{
+  typedef vtkhdiy::RegularPartners Partners;
+  vtkh::Compositor::NetworkModel model;
+  model.m_latency = 1.;
+  model.m_byte_time = .1;
+  model.m_pixel_time = .2;
+
+  // one round of 4: pieces of 100 pixels, half of them active. Sending
+  // a piece (41) is slower than compositing it (20), so the compositing
+  // hides behind all but the last piece
+  Partners::KVSVector kvs;
+  kvs.push_back(Partners::DimK(0, 4));
+  EXPECT_DOUBLE_EQ(vtkh::RadixKCompositor::EstimateCost(kvs, 400., .5, model), 143.);
+  // a second round of 2 on 50 pixel pieces adds 21 + 10
+  kvs.push_back(Partners::DimK(1, 2));
+  EXPECT_DOUBLE_EQ(vtkh::RadixKCompositor::EstimateCost(kvs, 400., .5, model), 174.);
+
+  vtkhdiy::DiscreteBounds image_bounds = vtkh::VTKMBoundsToDIY(vtkm::Bounds(1, 1024, 1, 1024, 0, 0));
+  const double pixels = 1024. * 1024.;
+  // send and composite speeds that are balanced on full images
+  model.m_byte_time = 1. / 5e9;
+  model.m_pixel_time = 8. / 5e9;
+
+  const int ranks[5] = {1, 2, 16, 64, 256};
+  const int max_division[5] = {2, 2, 4, 8, 16};
+  for(int i = 0; i < 5; ++i)
+  {
+    vtkhdiy::RegularDecomposer<vtkhdiy::DiscreteBounds> decomposer(2, image_bounds, ranks[i]);
+    // every extra message costs more than it hides, so binary swap
+    model.m_latency = 1e-2;
+    EXPECT_EQ(vtkh::RadixKCompositor::ChooseRadixK(decomposer.divisions, pixels, 1., model), 2);
+    // free messages, so one round per dimension
+    model.m_latency = 0.;
+    EXPECT_EQ(vtkh::RadixKCompositor::ChooseRadixK(decomposer.divisions, pixels, 1., model),
+              max_division[i]);
+  }
+
+  // in between the two extremes
+  vtkhdiy::RegularDecomposer<vtkhdiy::DiscreteBounds> decomposer(2, image_bounds, 64);
+  model.m_latency = 1e-4;
+  EXPECT_EQ(vtkh::RadixKCompositor::ChooseRadixK(decomposer.divisions, pixels, 1., model), 4);
+  model.m_latency = 1e-5;
+  EXPECT_EQ(vtkh::RadixKCompositor::ChooseRadixK(decomposer.divisions, pixels, 1., model), 8);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_compositing_par, vtkh_parallel_compositing)
+{
+  MPI_Init(NULL, NULL);
+  int comm_size, rank;
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  vtkh::SetMPICommHandle(MPI_Comm_c2f(MPI_COMM_WORLD));
+
+  vtkhdiy::mpi::communicator diy_comm(MPI_COMM_WORLD);
+
+  // odd sizes so the tiles are not all the same shape
+  vtkm::Bounds global_bounds;
+  global_bounds.X = vtkm::Range(1, 101);
+  global_bounds.Y = vtkm::Range(1, 77);
+  vtkhdiy::DiscreteBounds diy_bounds = vtkh::VTKMBoundsToDIY(global_bounds);
+  vtkhdiy::RegularDecomposer<vtkhdiy::DiscreteBounds> decomposer(2, diy_bounds, comm_size);
+
+  vtkh::Image reference = make_tile(global_bounds, decomposer, rank);
+  diy_collect(reference, diy_comm, diy_bounds);
+
+  vtkh::Image collected = make_tile(global_bounds, decomposer, rank);
+  vtkh::MPICollect(collected, MPI_COMM_WORLD);
+
+  vtkh::Image color_only = make_tile(global_bounds, decomposer, rank);
+  const vtkh::Image own_tile = color_only;
+  vtkh::MPICollect(color_only, MPI_COMM_WORLD, false);
+
+  if(rank == 0)
+  {
+    EXPECT_EQ(collected.m_bounds, reference.m_bounds);
+    EXPECT_TRUE(collected.m_pixels == reference.m_pixels);
+    EXPECT_TRUE(collected.m_depths == reference.m_depths);
+
+    EXPECT_TRUE(color_only.m_pixels == reference.m_pixels);
+    // rank 0 keeps its own depths, the rest is background
+    vtkh::Image expected_depths(global_bounds);
+    std::fill(expected_depths.m_depths.begin(), expected_depths.m_depths.end(), 1.001f);
+    own_tile.SubsetTo(expected_depths);
+    EXPECT_TRUE(color_only.m_depths == expected_depths.m_depths);
+  }
+  else
+  {
+    EXPECT_EQ(collected.GetNumberOfPixels(), 0);
+    EXPECT_EQ(color_only.GetNumberOfPixels(), 0);
+  }
+
+  // ranks with nothing to send still take part
+  vtkh::Image empty = rank == 0 ? make_tile(global_bounds, decomposer, rank) : vtkh::Image();
+  if(rank != 0)
+  {
+    empty.m_orig_bounds = global_bounds;
+  }
+  vtkh::MPICollect(empty, MPI_COMM_WORLD);
+  if(rank == 0)
+  {
+    vtkh::Image expected(global_bounds);
+    make_tile(global_bounds, decomposer, 0).SubsetTo(expected);
+    EXPECT_TRUE(empty.m_pixels == expected.m_pixels);
+  }
+
+  // binary swap, direct send and the model's choice of k all have to
+  // give the plain z-buffer composite of every rank's image
+  vtkh::Image expected_surface = make_surface(global_bounds, 0);
+  for(int i = 1; i < comm_size; ++i)
+  {
+    vtkh::SparseImage other;
+    other.Encode(make_surface(global_bounds, i), false);
+    other.CompositeInto(expected_surface);
+  }
+
+  for(int algorithm = 0; algorithm < 3; ++algorithm)
+  {
+    vtkh::Image surface = make_surface(global_bounds, rank);
+    vtkh::RadixKCompositor compositor;
+    compositor.SetRadixK(algorithm == 0 ? 2 : 0);
+    compositor.SetDirectSend(algorithm == 1);
+    compositor.CompositeSurface(diy_comm, surface);
+    if(rank == 0)
+    {
+      EXPECT_TRUE(surface.m_pixels == expected_surface.m_pixels);
+      EXPECT_TRUE(surface.m_depths == expected_surface.m_depths);
+    }
+  }
+
+  MPI_Finalize();
+}
@@ -13,6 +13,7 @@
 #include "t_test_utils.hpp"
 
 #include <iostream>
+#include <set>
 
 
 
@@ -86,3 +87,54 @@ TEST(vtkh_mesh_renderer, vtkh_serial_render_no_field)
   scene.Render();
 
 }
+
+//----------------------------------------------------------------------------
+TEST(vtkh_mesh_renderer, vtkh_serial_render_cell_field)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 16;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+  camera.SetPosition(vtkm::Vec<vtkm::Float64,3>(16, 36, -36));
+
+  // cell fields are colored on the edges, both with and without the
+  // hidden line pass over the external faces
+  for(int internal = 0; internal < 2; ++internal)
+  {
+    vtkh::Render render = vtkh::MakeRender(512,
+                                           512,
+                                           camera,
+                                           data_set,
+                                           "mesh_render_cell_field_" + std::to_string(internal));
+    render.SetImageFormat(vtkh::Render::MEMORY);
+    vtkh::MeshRenderer renderer;
+    renderer.SetInput(&data_set);
+    renderer.SetField("cell_data_Float64");
+    renderer.SetShowInternal(internal == 1);
+
+    vtkh::Scene scene;
+    scene.AddRenderer(&renderer);
+    scene.AddRender(render);
+    scene.Render();
+
+    // the edges have to show up in more than one color
+    const std::vector<unsigned char> &pixels = render.GetImage().m_pixels;
+    ASSERT_FALSE(pixels.empty());
+    std::set<int> colors;
+    for(size_t i = 0; i < pixels.size(); i += 4)
+    {
+      colors.insert((pixels[i] << 16) | (pixels[i + 1] << 8) | pixels[i + 2]);
+    }
+    EXPECT_GT(colors.size(), 2u);
+  }
+}
@@ -12,8 +12,11 @@
 #include <vtkm/io/writer/VTKDataSetWriter.h>
 #include <vtkm/cont/DataSet.h>
 #include <vtkm/cont/DataSetFieldAdd.h>
+#include <vtkm/VectorAnalysis.h>
 #include "t_test_utils.hpp"
+#include <cmath>
 #include <iostream>
+#include <map>
 #include <mpi.h>
 
 void checkValidity(vtkh::DataSet *data, const int maxSteps)
@@ -48,6 +51,74 @@ void writeDataSet(vtkh::DataSet *data, std::string fName, int rank)
   }
 }
 
+// the test mesh with a uniform flow along x whose speed is 1 + time
+vtkm::cont::DataSet makePathlineDomain(int block, int num_blocks, int base_size, double time)
+{
+  vtkm::cont::DataSet dom = CreateTestDataRectilinear(block, num_blocks, base_size);
+  const vtkm::Id num_points = dom.GetCoordinateSystem().GetNumberOfPoints();
+  vtkm::cont::ArrayHandle<vtkm::Vec<vtkm::Float64,3>> velocity;
+  velocity.Allocate(num_points);
+  auto portal = velocity.GetPortalControl();
+  for(vtkm::Id i = 0; i < num_points; ++i)
+  {
+    portal.Set(i, vtkm::Vec<vtkm::Float64,3>(1. + time, 0., 0.));
+  }
+  vtkm::cont::DataSetFieldAdd dsf;
+  dsf.AddPointField(dom, "pathline_velocity", velocity);
+  return dom;
+}
+
+// the particles of every rank, by id
+std::map<int, vtkh::Particle> gatherParticles(const std::vector<vtkh::Particle> &particles)
+{
+  int comm_size;
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+  std::vector<int> ids;
+  std::vector<double> values;
+  for(const auto &p : particles)
+  {
+    ids.push_back(p.id);
+    values.push_back(p.coords[0]);
+    values.push_back(p.coords[1]);
+    values.push_back(p.coords[2]);
+    values.push_back(p.time);
+  }
+
+  int count = static_cast<int>(ids.size());
+  std::vector<int> counts(comm_size), offsets(comm_size, 0);
+  MPI_Allgather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+  for(int i = 1; i < comm_size; ++i)
+  {
+    offsets[i] = offsets[i - 1] + counts[i - 1];
+  }
+  const int total = offsets[comm_size - 1] + counts[comm_size - 1];
+
+  std::vector<int> all_ids(total);
+  MPI_Allgatherv(ids.data(), count, MPI_INT,
+                 all_ids.data(), counts.data(), offsets.data(), MPI_INT, MPI_COMM_WORLD);
+  for(int i = 0; i < comm_size; ++i)
+  {
+    counts[i] *= 4;
+    offsets[i] *= 4;
+  }
+  std::vector<double> all_values(total * 4);
+  MPI_Allgatherv(values.data(), count * 4, MPI_DOUBLE,
+                 all_values.data(), counts.data(), offsets.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+
+  std::map<int, vtkh::Particle> res;
+  for(int i = 0; i < total; ++i)
+  {
+    vtkh::Particle p(vtkm::Vec<double,3>(all_values[i * 4 + 0],
+                                         all_values[i * 4 + 1],
+                                         all_values[i * 4 + 2]), all_ids[i]);
+    p.time = all_values[i * 4 + 3];
+    EXPECT_EQ(res.count(p.id), 0u);
+    res[p.id] = p;
+  }
+  return res;
+}
+
 //----------------------------------------------------------------------------
 TEST(vtkh_particle_advection, vtkh_serial_particle_advection)
 {
@@ -83,6 +154,101 @@ TEST(vtkh_particle_advection, vtkh_serial_particle_advection)
   checkValidity(streamline_output, maxAdvSteps);
   writeDataSet(streamline_output, "advection_SeedsRandomWhole", rank);
 
+  // stop particles early once they have traveled a short distance
+  const double maxArcLength = 1.0;
+  vtkh::ParticleAdvection shortStreamline;
+  shortStreamline.SetInput(&data_set);
+  shortStreamline.SetField("vector_data_Float64");
+  shortStreamline.SetMaxSteps(maxAdvSteps);
+  shortStreamline.SetStepSize(0.1);
+  shortStreamline.SetMaxArcLength(maxArcLength);
+  shortStreamline.SetSeedsRandomWhole(500);
+  shortStreamline.Update();
+  vtkh::DataSet *short_output = shortStreamline.GetOutput();
+  checkValidity(short_output, maxAdvSteps);
+
+  // a step moves a particle stepSize times its speed, which is at most
+  // sqrt(3) in the test field, so it overshoots by less than one step
+  const double maxStepLength = 0.1 * std::sqrt(3.);
+  int arcLengthTerminated = 0;
+  for(const auto &p : shortStreamline.GetTerminatedParticles())
+  {
+    EXPECT_NE(p.termReason, vtkh::TerminationCriteria::NOT_TERMINATED);
+    if(p.termReason == vtkh::TerminationCriteria::MAX_ARC_LENGTH)
+    {
+      EXPECT_GE(p.arcLength, maxArcLength);
+      EXPECT_LE(p.arcLength, maxArcLength + maxStepLength);
+      ++arcLengthTerminated;
+    }
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &arcLengthTerminated, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  EXPECT_GT(arcLengthTerminated, 0);
+
+  // pathlines: a flow that speeds up between cycles, particles persist.
+  // Over [t - 1, t] the flow interpolated in time moves a particle by
+  // the mean of the two speeds, t + 0.5. Using either end's field alone
+  // would move it by t or t + 1.
+  const int numPathlineSeeds = 100;
+  vtkh::ParticleAdvection pathlines;
+  pathlines.SetField("pathline_velocity");
+  pathlines.SetMaxSteps(maxAdvSteps);
+  pathlines.SetStepSize(0.1);
+  pathlines.SetSeedsRandomWhole(numPathlineSeeds);
+  pathlines.SetUnsteady(true);
+  std::map<int, vtkh::Particle> previous;
+  for(int cycle = 0; cycle < 3; ++cycle)
+  {
+    const double time = cycle * 1.0;
+    vtkh::DataSet cycle_data;
+    for(int i = 0; i < blocks_per_rank; ++i)
+    {
+      int domain_id = rank * blocks_per_rank + i;
+      cycle_data.AddDomain(makePathlineDomain(domain_id, num_blocks, base_size, time), domain_id);
+    }
+    pathlines.SetInput(&cycle_data);
+    pathlines.SetTime(time);
+    pathlines.Update();
+    vtkh::DataSet *pathline_output = pathlines.GetOutput();
+    checkValidity(pathline_output, maxAdvSteps);
+
+    std::map<int, vtkh::Particle> current = gatherParticles(pathlines.GetPathlineParticles());
+    std::map<int, vtkh::Particle> done = gatherParticles(pathlines.GetTerminatedParticles());
+
+    if(cycle == 0)
+    {
+      // the first cycle only seeds: no segments and nothing advected
+      EXPECT_EQ(pathline_output->GetNumberOfDomains(), 0);
+      EXPECT_TRUE(done.empty());
+      EXPECT_EQ(current.size(), static_cast<size_t>(numPathlineSeeds));
+    }
+    else
+    {
+      // every particle of the last cycle either carries on or stops,
+      // and the ones that carry on moved with the interpolated flow
+      EXPECT_FALSE(current.empty());
+      EXPECT_EQ(current.size() + done.size(), previous.size());
+      for(const auto &p : current)
+      {
+        auto prev = previous.find(p.first);
+        ASSERT_TRUE(prev != previous.end());
+        const vtkm::Vec<double,3> moved = p.second.coords - prev->second.coords;
+        EXPECT_NEAR(moved[0], time + 0.5, 0.05);
+        EXPECT_NEAR(moved[1], 0., 1e-6);
+        EXPECT_NEAR(moved[2], 0., 1e-6);
+      }
+      for(const auto &p : done)
+      {
+        EXPECT_TRUE(previous.find(p.first) != previous.end());
+      }
+    }
+    // particles that carry on always end exactly at the interval end
+    for(const auto &p : current)
+    {
+      EXPECT_EQ(p.second.time, time);
+    }
+    previous = current;
+  }
+
   MPI_Barrier(MPI_COMM_WORLD);
   MPI_Finalize();
 }
@@ -0,0 +1,124 @@
+//-----------------------------------------------------------------------------
+///
+/// file: t_vtk-h_pixel_kernels.cpp
+///
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <vtkh/utils/PixelKernels.hpp>
+
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+
+struct Pixels
+{
+  std::vector<unsigned char> m_front;
+  std::vector<unsigned char> m_back;
+  std::vector<float>         m_front_depths;
+  std::vector<float>         m_back_depths;
+  std::vector<float>         m_colors;
+
+  Pixels(const int size)
+    : m_front(size * 4),
+      m_back(size * 4),
+      m_front_depths(size),
+      m_back_depths(size),
+      m_colors(size * 4)
+  {
+    srand(0);
+    for(int i = 0; i < size * 4; ++i)
+    {
+      m_front[i] = static_cast<unsigned char>(rand() % 256);
+      m_back[i] = static_cast<unsigned char>(rand() % 256);
+      m_colors[i] = static_cast<float>(rand() % 10001) / 10000.f;
+    }
+    // about a third of the depths are background
+    for(int i = 0; i < size; ++i)
+    {
+      m_front_depths[i] = static_cast<float>(rand() % 300) / 200.f;
+      m_back_depths[i] = static_cast<float>(rand() % 300) / 200.f;
+    }
+  }
+};
+
+struct Results
+{
+  std::vector<unsigned char> m_blend;
+  std::vector<float>         m_blend_depths;
+  std::vector<unsigned char> m_zbuffer;
+  std::vector<float>         m_zbuffer_depths;
+  std::vector<unsigned char> m_background;
+  std::vector<unsigned char> m_uchar;
+  std::vector<float>         m_float;
+};
+
+Results run_kernels(const Pixels &pixels, const int size)
+{
+  Results res;
+  const unsigned char bg[4] = {25, 50, 200, 255};
+
+  res.m_blend = pixels.m_front;
+  res.m_blend_depths = pixels.m_front_depths;
+  vtkh::PixelKernels::BlendUnder(res.m_blend.data(),
+                                 res.m_blend_depths.data(),
+                                 pixels.m_back.data(),
+                                 pixels.m_back_depths.data(),
+                                 size);
+
+  res.m_zbuffer = pixels.m_front;
+  res.m_zbuffer_depths = pixels.m_front_depths;
+  vtkh::PixelKernels::ZBufferComposite(res.m_zbuffer.data(),
+                                       res.m_zbuffer_depths.data(),
+                                       pixels.m_back.data(),
+                                       pixels.m_back_depths.data(),
+                                       size);
+
+  res.m_background = pixels.m_front;
+  vtkh::PixelKernels::BlendBackground(res.m_background.data(), bg, size);
+
+  res.m_uchar.resize(size * 4);
+  vtkh::PixelKernels::FloatToUChar(pixels.m_colors.data(), res.m_uchar.data(), size * 4);
+
+  res.m_float.resize(size * 4);
+  vtkh::PixelKernels::UCharToFloat(pixels.m_front.data(), res.m_float.data(), size * 4);
+  return res;
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------
+TEST(vtkh_pixel_kernels, vtkh_pixel_kernels_match_scalar)
+{
+  // odd size to exercise the scalar tails
+  const int size = 1027;
+  Pixels pixels(size);
+
+  const vtkh::PixelKernels::InstructionSet best = vtkh::PixelKernels::GetInstructionSet();
+  ASSERT_TRUE(vtkh::PixelKernels::SetInstructionSet(vtkh::PixelKernels::SCALAR));
+  Results expected = run_kernels(pixels, size);
+
+  const vtkh::PixelKernels::InstructionSet sets[2] = {vtkh::PixelKernels::SSE2,
+                                                      vtkh::PixelKernels::AVX2};
+  for(int i = 0; i < 2; ++i)
+  {
+    if(!vtkh::PixelKernels::SetInstructionSet(sets[i]))
+    {
+      std::cout<<vtkh::PixelKernels::GetName(sets[i])<<" not supported\n";
+      continue;
+    }
+    Results res = run_kernels(pixels, size);
+    EXPECT_TRUE(res.m_blend == expected.m_blend);
+    EXPECT_TRUE(res.m_blend_depths == expected.m_blend_depths);
+    EXPECT_TRUE(res.m_zbuffer == expected.m_zbuffer);
+    EXPECT_TRUE(res.m_zbuffer_depths == expected.m_zbuffer_depths);
+    EXPECT_TRUE(res.m_background == expected.m_background);
+    EXPECT_TRUE(res.m_uchar == expected.m_uchar);
+    EXPECT_TRUE(res.m_float == expected.m_float);
+  }
+  vtkh::PixelKernels::SetInstructionSet(best);
+}
@@ -12,7 +12,54 @@
 #include <vtkh/rendering/Scene.hpp>
 #include "t_test_utils.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+// the largest distance in pixels from a pixel covered in a to the
+// nearest pixel covered in b, or -1 if b is empty
+int max_coverage_distance(const vtkh::Image &a, const vtkh::Image &b, const int size)
+{
+  int res = 0;
+  for(int y = 0; y < size; ++y)
+  {
+    for(int x = 0; x < size; ++x)
+    {
+      // background keeps the canvas clear depth, which is past 1
+      if(a.m_depths[y * size + x] > 1.f)
+      {
+        continue;
+      }
+      int nearest = -1;
+      for(int r = 0; r < size && nearest < 0; ++r)
+      {
+        for(int by = std::max(y - r, 0); by <= std::min(y + r, size - 1) && nearest < 0; ++by)
+        {
+          for(int bx = std::max(x - r, 0); bx <= std::min(x + r, size - 1); ++bx)
+          {
+            if(b.m_depths[by * size + bx] <= 1.f)
+            {
+              nearest = r;
+              break;
+            }
+          }
+        }
+      }
+      if(nearest < 0)
+      {
+        return -1;
+      }
+      res = std::max(res, nearest);
+    }
+  }
+  return res;
+}
+
+} // namespace
 
 
 
@@ -88,3 +135,75 @@ TEST(vtkh_point_renderer, vtkh_variable_point_render)
   scene.Render();
 
 }
+
+TEST(vtkh_point_renderer, vtkh_point_render_lod)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  // the far cameras see several points per pixel, the near one does not
+  const int size = 128;
+  const vtkm::Float32 pixel_error = 2.f;
+  const vtkm::Float64 distances[3] = {48., 400., 420.};
+  std::vector<vtkh::Render> renders[2];
+  for(int lod = 0; lod < 2; ++lod)
+  {
+    vtkh::Scene scene;
+    for(int i = 0; i < 3; ++i)
+    {
+      vtkm::rendering::Camera camera;
+      camera.ResetToBounds(bounds);
+      camera.SetPosition(vtkm::Vec<vtkm::Float64,3>(16, 16, -distances[i]));
+      std::ostringstream name;
+      name<<"render_points_lod_"<<lod<<"_"<<i;
+      vtkh::Render render = vtkh::MakeRender(size,
+                                             size,
+                                             camera,
+                                             data_set,
+                                             name.str());
+      render.SetImageFormat(vtkh::Render::MEMORY);
+      // only the points, so coverage can be read from the depths
+      render.DoRenderAnnotations(false);
+      renders[lod].push_back(render);
+      scene.AddRender(render);
+    }
+
+    vtkh::PointRenderer renderer;
+    renderer.SetInput(&data_set);
+    renderer.SetField("point_data_Float64");
+    renderer.SetLevelOfDetail(lod == 1, pixel_error);
+    EXPECT_THROW(renderer.SetLevelOfDetail(true, 0.f), vtkh::Error);
+
+    scene.AddRenderer(&renderer);
+    scene.Render();
+  }
+
+  // the near camera draws every point either way
+  const vtkh::Image &near_full = renders[0][0].GetImage();
+  const vtkh::Image &near_lod = renders[1][0].GetImage();
+  EXPECT_TRUE(near_full.m_pixels == near_lod.m_pixels);
+
+  for(int i = 1; i < 3; ++i)
+  {
+    const vtkh::Image &full = renders[0][i].GetImage();
+    const vtkh::Image &lod = renders[1][i].GetImage();
+    // fewer points were drawn, but every point that was dropped is
+    // within the pixel error of one that was kept
+    EXPECT_FALSE(full.m_pixels == lod.m_pixels);
+    const int kept = max_coverage_distance(lod, full, size);
+    const int dropped = max_coverage_distance(full, lod, size);
+    EXPECT_GE(kept, 0);
+    EXPECT_LE(kept, 1);
+    EXPECT_GE(dropped, 0);
+    EXPECT_LE(dropped, static_cast<int>(pixel_error) + 1);
+  }
+}
@@ -9,10 +9,15 @@
 #include <vtkh/vtkh.hpp>
 #include <vtkh/DataSet.hpp>
 #include <vtkh/rendering/RayTracer.hpp>
+#include <vtkh/rendering/RayTracerMapper.hpp>
 #include <vtkh/rendering/Scene.hpp>
+#include <vtkh/rendering/TopologyCache.hpp>
 #include "t_test_utils.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <vector>
 
 
 
@@ -49,3 +54,211 @@ TEST(vtkh_raytracer, vtkh_serial_render)
   scene.AddRenderer(&tracer);
   scene.Render();
 }
+
+//----------------------------------------------------------------------------
+TEST(vtkh_raytracer, vtkh_topology_cache)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  vtkm::rendering::Camera camera;
+  camera.SetPosition(vtkm::Vec<vtkm::Float64,3>(-16, -16, -16));
+  camera.ResetToBounds(bounds);
+
+  vtkh::TopologyCache::Clear();
+  typedef vtkh::RayTracerMapper::Geometry Geometry;
+  std::vector<std::shared_ptr<Geometry>> cached[2];
+  vtkh::Render cached_render;
+  {
+    // the tracer has to live across cycles for its entries to be reused
+    vtkh::RayTracer tracer;
+    tracer.SetCacheTopology(true);
+    tracer.SetInput(&data_set);
+
+    // two cycles over the same mesh, the second only remaps the field
+    for(int cycle = 0; cycle < 2; ++cycle)
+    {
+      cached_render = vtkh::MakeRender(512,
+                                       512,
+                                       camera,
+                                       data_set,
+                                       "ray_tracer_cached_" + std::to_string(cycle));
+      cached_render.SetImageFormat(vtkh::Render::MEMORY);
+      tracer.SetField(cycle == 0 ? "point_data_Float64" : "cell_data_Float64");
+
+      vtkh::Scene scene;
+      scene.AddRender(cached_render);
+      scene.AddRenderer(&tracer);
+      scene.Render();
+
+      EXPECT_EQ(vtkh::TopologyCache::GetNumberOfEntries(), num_blocks);
+      for(int i = 0; i < num_blocks; ++i)
+      {
+        vtkm::cont::DataSet &dom = data_set.GetDomain(i);
+        cached[cycle].push_back(
+          vtkh::TopologyCache::Find<Geometry>(tracer.GetCacheOwner(),
+                                              i,
+                                              dom.GetCellSet(),
+                                              dom.GetCoordinateSystem()));
+        ASSERT_TRUE(cached[cycle].back() != nullptr);
+      }
+    }
+
+    // a hit hands back the geometry built in the first cycle
+    for(int i = 0; i < num_blocks; ++i)
+    {
+      EXPECT_EQ(cached[0][i].get(), cached[1][i].get());
+    }
+
+    // another instance never sees the entries of the first one
+    vtkh::RayTracer other;
+    EXPECT_NE(other.GetCacheOwner(), tracer.GetCacheOwner());
+    vtkm::cont::DataSet &dom = data_set.GetDomain(0);
+    EXPECT_TRUE(vtkh::TopologyCache::Find<Geometry>(other.GetCacheOwner(),
+                                                    0,
+                                                    dom.GetCellSet(),
+                                                    dom.GetCoordinateSystem()) == nullptr);
+  }
+  // entries are dropped with their renderer
+  EXPECT_EQ(vtkh::TopologyCache::GetNumberOfEntries(), 0);
+
+  // the cached geometry has to render the same as a fresh build
+  vtkh::Render uncached_render = vtkh::MakeRender(512,
+                                                  512,
+                                                  camera,
+                                                  data_set,
+                                                  "ray_tracer_uncached");
+  uncached_render.SetImageFormat(vtkh::Render::MEMORY);
+  vtkh::RayTracer uncached;
+  uncached.SetInput(&data_set);
+  uncached.SetField("cell_data_Float64");
+
+  vtkh::Scene scene;
+  scene.AddRender(uncached_render);
+  scene.AddRenderer(&uncached);
+  scene.Render();
+
+  EXPECT_TRUE(cached_render.GetImage().m_pixels == uncached_render.GetImage().m_pixels);
+  vtkh::TopologyCache::Clear();
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_raytracer, vtkh_mapper_drops_built_geometry)
+{
+  vtkh::DataSet data_set;
+  const int num_blocks = 2;
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, 32), i);
+  }
+
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(data_set.GetGlobalBounds());
+  const vtkm::Range range =
+    data_set.GetGlobalRange("point_data_Float64").GetPortalConstControl().Get(0);
+  vtkm::cont::ColorTable color_table("Cool to Warm");
+
+  auto render = [&](vtkh::RayTracerMapper &mapper,
+                    vtkm::rendering::CanvasRayTracer &canvas,
+                    const int domain)
+  {
+    vtkm::cont::DataSet &dom = data_set.GetDomain(domain);
+    canvas.Clear();
+    mapper.SetActiveColorTable(color_table);
+    mapper.SetCanvas(&canvas);
+    mapper.RenderCells(dom.GetCellSet(),
+                       dom.GetCoordinateSystem(),
+                       dom.GetField("point_data_Float64"),
+                       color_table,
+                       camera,
+                       range);
+  };
+
+  // without SetGeometry each call traces the cell set it is given
+  vtkh::RayTracerMapper reused;
+  vtkm::rendering::CanvasRayTracer first(128, 128);
+  vtkm::rendering::CanvasRayTracer second(128, 128);
+  render(reused, first, 0);
+  EXPECT_FALSE(reused.HasGeometry());
+  render(reused, second, 1);
+
+  vtkh::RayTracerMapper fresh;
+  vtkm::rendering::CanvasRayTracer expected(128, 128);
+  render(fresh, expected, 1);
+
+  auto colors = second.GetColorBuffer().GetPortalConstControl();
+  auto expected_colors = expected.GetColorBuffer().GetPortalConstControl();
+  ASSERT_EQ(colors.GetNumberOfValues(), expected_colors.GetNumberOfValues());
+  for(vtkm::Id i = 0; i < colors.GetNumberOfValues(); ++i)
+  {
+    ASSERT_EQ(colors.Get(i), expected_colors.Get(i)) << "pixel " << i;
+  }
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_raytracer, vtkh_batched_cameras)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  // the batched trace has to match rendering the cameras one at a time
+  std::vector<vtkh::Render> renders[2];
+  for(int batch = 0; batch < 2; ++batch)
+  {
+    vtkh::RayTracer tracer;
+    tracer.SetBatchCameras(batch == 1);
+    tracer.SetInput(&data_set);
+    tracer.SetField("point_data_Float64");
+
+    vtkh::Scene scene;
+    for(int i = 0; i < 3; ++i)
+    {
+      vtkm::rendering::Camera camera;
+      camera.ResetToBounds(bounds);
+      camera.Azimuth(30.f * i);
+      vtkh::Render render = vtkh::MakeRender(512,
+                                             512,
+                                             camera,
+                                             data_set,
+                                             "ray_tracer_batched_" + std::to_string(i));
+      render.SetImageFormat(vtkh::Render::MEMORY);
+      // mix shaded and flat renders in one launch
+      render.SetShadingOn(i != 1);
+      scene.AddRender(render);
+      renders[batch].push_back(render);
+    }
+    scene.AddRenderer(&tracer);
+    scene.Render();
+  }
+
+  for(int i = 0; i < 3; ++i)
+  {
+    const std::vector<unsigned char> &single = renders[0][i].GetImage().m_pixels;
+    const std::vector<unsigned char> &batched = renders[1][i].GetImage().m_pixels;
+    ASSERT_EQ(single.size(), batched.size());
+    int max_diff = 0;
+    for(size_t p = 0; p < single.size(); ++p)
+    {
+      max_diff = std::max(max_diff, std::abs(int(single[p]) - int(batched[p])));
+    }
+    EXPECT_LE(max_diff, 2) << "camera " << i;
+  }
+}
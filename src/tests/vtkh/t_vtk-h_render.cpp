@@ -8,11 +8,24 @@
 
 #include <vtkh/vtkh.hpp>
 #include <vtkh/DataSet.hpp>
+#include <vtkh/rendering/CameraSweep.hpp>
 #include <vtkh/rendering/RayTracer.hpp>
 #include <vtkh/rendering/Scene.hpp>
+#include <vtkh/utils/AsyncQueue.hpp>
+#include <vtkh/utils/ImageEncoders.hpp>
+#include <vtkh/utils/PNGEncoder.hpp>
 #include "t_test_utils.hpp"
 
+#include <lodepng.h>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 
 
 
@@ -123,3 +136,686 @@ TEST(vtkh_render, vtkh_bg_color)
   scene.AddRenderer(&tracer);
   scene.Render();
 }
+
+TEST(vtkh_render, vtkh_single_canvas)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 4;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  vtkm::rendering::Camera camera;
+  camera.SetPosition(vtkm::Vec<vtkm::Float64,3>(-16, -16, -16));
+  camera.ResetToBounds(bounds);
+  vtkh::Render render = vtkh::MakeRender(512,
+                                         512,
+                                         camera,
+                                         data_set,
+                                         "single_canvas");
+  EXPECT_EQ(render.GetNumberOfCanvases(), num_blocks);
+  render.SetSingleCanvas(true);
+  EXPECT_EQ(render.GetNumberOfCanvases(), 1);
+  // every domain maps to the shared canvas
+  EXPECT_EQ(render.GetDomainCanvas(0), render.GetDomainCanvas(num_blocks - 1));
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  vtkh::Scene scene;
+  scene.AddRender(render);
+  scene.AddRenderer(&tracer);
+  scene.Render();
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_async_save)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  vtkh::Scene scene;
+  const int num_images = 6;
+  for(int i = 0; i < num_images; ++i)
+  {
+    vtkm::rendering::Camera camera;
+    camera.ResetToBounds(bounds);
+    camera.Azimuth(i * 60.f);
+    std::ostringstream name;
+    name<<"async_save_"<<i;
+    vtkh::Render render = vtkh::MakeRender(512,
+                                           512,
+                                           camera,
+                                           data_set,
+                                           name.str());
+    scene.AddRender(render);
+  }
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  EXPECT_TRUE(vtkh::Render::GetAsyncSave());
+  vtkh::Render::SetSaveQueueSize(2);
+  scene.SetRenderBatchSize(2);
+  scene.AddRenderer(&tracer);
+  scene.Render();
+
+  // the scene flushes the writer before returning
+  EXPECT_EQ(vtkh::Render::GetSaveQueue().GetSize(), 0);
+  for(int i = 0; i < num_images; ++i)
+  {
+    std::ostringstream name;
+    name<<"async_save_"<<i<<".png";
+    FILE *file = fopen(name.str().c_str(), "rb");
+    EXPECT_TRUE(file != NULL);
+    if(file != NULL) fclose(file);
+  }
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_sync_save)
+{
+  vtkh::DataSet data_set;
+  data_set.AddDomain(CreateTestData(0, 1, 8), 0);
+
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(data_set.GetGlobalBounds());
+  vtkh::Render render = vtkh::MakeRender(64, 64, camera, data_set, "sync_save");
+  render.GetCanvas(0)->Clear();
+  remove("sync_save.png");
+
+  // outside of Scene the file is there as soon as Save returns
+  render.Save();
+  EXPECT_EQ(vtkh::Render::GetSaveQueue().GetSize(), 0);
+  FILE *file = fopen("sync_save.png", "rb");
+  EXPECT_TRUE(file != NULL);
+  if(file != NULL) fclose(file);
+
+  // and a failed write is thrown right away
+  vtkh::Render bad = vtkh::MakeRender(64, 64, camera, data_set, "no_such_dir/sync_save");
+  bad.GetCanvas(0)->Clear();
+  EXPECT_THROW(bad.Save(), vtkh::Error);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_parallel_png)
+{
+  const int width = 1024;
+  const int height = 768;
+  std::vector<unsigned char> pixels(width * height * 4);
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      const int offset = (y * width + x) * 4;
+      pixels[offset + 0] = static_cast<unsigned char>(x % 256);
+      pixels[offset + 1] = static_cast<unsigned char>(128 + 127 * sin(x * 0.01 + y * 0.02));
+      pixels[offset + 2] = static_cast<unsigned char>(y % 256);
+      pixels[offset + 3] = 255;
+    }
+  }
+
+  const int levels[3] = {1, 6, 9};
+  for(int l = 0; l < 3; ++l)
+  {
+    // the chunked stream has to decode to the same image as a serial one
+    vtkh::PNGEncoder encoder;
+    encoder.SetCompressionLevel(levels[l]);
+    encoder.SetNumThreads(4);
+    encoder.Encode(&pixels[0], width, height);
+    ASSERT_TRUE(encoder.PngBufferSize() > 0);
+
+    unsigned char *decoded = NULL;
+    unsigned decoded_width, decoded_height;
+    unsigned error = vtkh::lodepng_decode32(&decoded,
+                                            &decoded_width,
+                                            &decoded_height,
+                                            (unsigned char*)encoder.PngBuffer(),
+                                            encoder.PngBufferSize());
+    ASSERT_EQ(error, 0u);
+    ASSERT_EQ(decoded_width, (unsigned)width);
+    ASSERT_EQ(decoded_height, (unsigned)height);
+    // the encoder flips rows
+    bool same = true;
+    for(int y = 0; y < height && same; ++y)
+    {
+      same = memcmp(decoded + y * width * 4,
+                    &pixels[(height - y - 1) * width * 4],
+                    width * 4) == 0;
+    }
+    EXPECT_TRUE(same);
+    free(decoded);
+  }
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_image_formats)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+
+  const int width = 320;
+  const int height = 240;
+  vtkh::Render qoi = vtkh::MakeRender(width, height, camera, data_set, "format_qoi");
+  qoi.SetImageFormat(vtkh::Render::QOI);
+  vtkh::Render raw = vtkh::MakeRender(width, height, camera, data_set, "format_raw");
+  raw.SetImageFormat(vtkh::Render::RAW);
+  vtkh::Render memory = vtkh::MakeRender(width, height, camera, data_set, "format_memory");
+  memory.SetImageFormat(vtkh::Render::MEMORY);
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  vtkh::Scene scene;
+  scene.AddRender(qoi);
+  scene.AddRender(raw);
+  scene.AddRender(memory);
+  scene.AddRenderer(&tracer);
+  scene.Render();
+
+  // all three renders see the same view, so the pixels must match
+  const vtkh::Image &image = memory.GetImage();
+  ASSERT_EQ(image.GetNumberOfPixels(), width * height);
+
+  std::ifstream qoi_file("format_qoi.qoi", std::ios::binary);
+  std::vector<unsigned char> qoi_bytes((std::istreambuf_iterator<char>(qoi_file)),
+                                       std::istreambuf_iterator<char>());
+  std::vector<unsigned char> decoded;
+  int decoded_width, decoded_height;
+  ASSERT_TRUE(vtkh::QOIEncoder::Decode(qoi_bytes.data(),
+                                       qoi_bytes.size(),
+                                       decoded,
+                                       decoded_width,
+                                       decoded_height));
+  ASSERT_EQ(decoded_width, width);
+  ASSERT_EQ(decoded_height, height);
+
+  std::ifstream raw_file("format_raw.raw", std::ios::binary);
+  std::vector<unsigned char> raw_bytes((std::istreambuf_iterator<char>(raw_file)),
+                                       std::istreambuf_iterator<char>());
+  const size_t header_size = 24;
+  ASSERT_EQ(raw_bytes.size(), header_size + width * height * (4 + sizeof(float)));
+  EXPECT_EQ(memcmp(&raw_bytes[0], "VTKHRAW1", 8), 0);
+
+  // files are top down, the in memory image is bottom up
+  bool same = true;
+  for(int y = 0; y < height && same; ++y)
+  {
+    const unsigned char *row = &image.m_pixels[(height - y - 1) * width * 4];
+    same = memcmp(&decoded[y * width * 4], row, width * 4) == 0 &&
+           memcmp(&raw_bytes[header_size + y * width * 4], row, width * 4) == 0;
+  }
+  EXPECT_TRUE(same);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_memory_budget)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  const int width = 256;
+  const int height = 256;
+  vtkh::Scene scene;
+  for(int i = 0; i < 5; ++i)
+  {
+    vtkm::rendering::Camera camera;
+    camera.ResetToBounds(bounds);
+    camera.Azimuth(i * 72.f);
+    std::ostringstream name;
+    name<<"memory_budget_"<<i;
+    vtkh::Render render = vtkh::MakeRender(width, height, camera, data_set, name.str());
+    scene.AddRender(render);
+  }
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+  scene.AddRenderer(&tracer);
+
+  // without a budget the batch size stays fixed
+  scene.Render();
+  EXPECT_EQ(scene.GetRenderBatchSize(), 10);
+
+  // surfaces share one canvas (rgba + depth floats) per render. The
+  // compositing images and the canvases waiting to be saved come off
+  // the top, leaving room for exactly two renders
+  const size_t pixels = width * height;
+  const size_t canvas = pixels * 5 * sizeof(float);
+  const int queue_size = 4;
+  vtkh::Render::SetSaveQueueSize(queue_size);
+  scene.SetMemoryBudget(pixels * 16 + queue_size * canvas + 2 * canvas + canvas / 2);
+  scene.Render();
+  EXPECT_EQ(scene.GetRenderBatchSize(), 2);
+
+  // a fixed batch size wins over the budget
+  scene.SetRenderBatchSize(3);
+  scene.Render();
+  EXPECT_EQ(scene.GetRenderBatchSize(), 3);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_pipelined_scene)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  const int num_images = 4;
+  vtkh::Scene scene;
+  vtkh::Scene sequential;
+  std::vector<vtkh::Render> renders;
+  std::vector<vtkh::Render> references;
+  for(int i = 0; i < num_images; ++i)
+  {
+    vtkm::rendering::Camera camera;
+    camera.ResetToBounds(bounds);
+    camera.Azimuth(i * 90.f);
+    vtkh::Render render = vtkh::MakeRender(256, 256, camera, data_set, "pipelined");
+    render.SetImageFormat(vtkh::Render::MEMORY);
+    scene.AddRender(render);
+    renders.push_back(render);
+    vtkh::Render reference = vtkh::MakeRender(256, 256, camera, data_set, "sequential");
+    reference.SetImageFormat(vtkh::Render::MEMORY);
+    sequential.AddRender(reference);
+    references.push_back(reference);
+  }
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  // one render per batch, so every batch overlaps with the next
+  scene.SetPipelined(true);
+  scene.SetRenderBatchSize(1);
+  scene.AddRenderer(&tracer);
+  scene.Render();
+
+  sequential.SetRenderBatchSize(1);
+  sequential.AddRenderer(&tracer);
+  sequential.Render();
+
+  // overlapping batches must not change the images
+  for(int i = 0; i < num_images; ++i)
+  {
+    EXPECT_TRUE(renders[i].GetImage().m_pixels == references[i].GetImage().m_pixels);
+  }
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_camera_sweep)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  const int num_phi = 3;
+  const int num_theta = 2;
+  vtkh::CameraSweep sweep(data_set, num_phi, num_theta, 64, 64);
+  sweep.SetOutputPath("camera_sweep");
+  // more than one scene
+  sweep.SetChunkSize(4);
+  sweep.AddRenderer(&tracer);
+  EXPECT_EQ(sweep.GetNumberOfRenders(), num_phi * num_theta);
+  EXPECT_EQ(sweep.GetPhi(0), -180.);
+  EXPECT_EQ(sweep.GetTheta(0), -45.);
+  EXPECT_EQ(sweep.GetImageName(5), "60_45");
+  sweep.Execute();
+
+  // the sweep restores the renderer's own setting
+  EXPECT_FALSE(tracer.GetCacheTopology());
+
+  std::ifstream index("camera_sweep/data.csv");
+  EXPECT_TRUE(index.is_open());
+  std::string line;
+  std::getline(index, line);
+  EXPECT_EQ(line, "phi,theta,FILE");
+  int rows = 0;
+  while(std::getline(index, line))
+  {
+    std::string file_name = "camera_sweep/" + line.substr(line.rfind(',') + 1);
+    FILE *file = fopen(file_name.c_str(), "rb");
+    EXPECT_TRUE(file != NULL);
+    if(file != NULL) fclose(file);
+    rows++;
+  }
+  EXPECT_EQ(rows, num_phi * num_theta);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_camera_sweep_errors)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  vtkh::CameraSweep bad_path(data_set, 2, 2, 64, 64);
+  bad_path.SetOutputPath("no_such_dir/camera_sweep");
+  bad_path.AddRenderer(&tracer);
+  EXPECT_THROW(bad_path.Execute(), vtkh::Error);
+
+  // a file where the directory should be passes the mkdir check, but
+  // no image can be written, so the sweep fails part way through and
+  // the renderer still has to get its own setting back
+  std::ofstream blocker("camera_sweep_file");
+  blocker<<"not a directory\n";
+  blocker.close();
+  vtkh::CameraSweep sweep(data_set, 2, 2, 64, 64);
+  sweep.SetOutputPath("camera_sweep_file");
+  sweep.AddRenderer(&tracer);
+  EXPECT_THROW(sweep.Execute(), vtkh::Error);
+  EXPECT_FALSE(tracer.GetCacheTopology());
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_tiled_png_writer)
+{
+  const int width = 300;
+  const int height = 200;
+  std::vector<unsigned char> pixels(width * height * 4);
+  for(int i = 0; i < width * height * 4; ++i)
+  {
+    pixels[i] = static_cast<unsigned char>((i * 7 + (i / (width * 4)) * 13) % 256);
+  }
+
+  const int levels[3] = {0, 1, 6};
+  for(int l = 0; l < 3; ++l)
+  {
+    // bands go in from the top, rows bottom up within each band
+    vtkh::TiledPNGWriter writer;
+    writer.SetCompressionLevel(levels[l]);
+    ASSERT_TRUE(writer.Open("tiled_writer.png", width, height));
+    const int band_height = 64;
+    for(int top = height; top > 0; top -= band_height)
+    {
+      const int rows = std::min(band_height, top);
+      EXPECT_TRUE(writer.AddBand(&pixels[(top - rows) * width * 4], rows));
+    }
+    ASSERT_TRUE(writer.Close());
+
+    unsigned char *decoded = NULL;
+    unsigned decoded_width, decoded_height;
+    unsigned error = vtkh::lodepng_decode32_file(&decoded,
+                                                 &decoded_width,
+                                                 &decoded_height,
+                                                 "tiled_writer.png");
+    ASSERT_EQ(error, 0u);
+    ASSERT_EQ(decoded_width, (unsigned)width);
+    ASSERT_EQ(decoded_height, (unsigned)height);
+    bool same = true;
+    for(int y = 0; y < height && same; ++y)
+    {
+      same = memcmp(decoded + y * width * 4,
+                    &pixels[(height - y - 1) * width * 4],
+                    width * 4) == 0;
+    }
+    EXPECT_TRUE(same);
+    free(decoded);
+  }
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_tiled_render)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+  camera.Azimuth(30.f);
+  camera.Elevation(20.f);
+
+  // neither side is a multiple of the tile size
+  const int width = 300;
+  const int height = 200;
+  vtkh::Render tiled = vtkh::MakeRender(width, height, camera, data_set, "tiled_render");
+  tiled.DoRenderAnnotations(false);
+  tiled.SetTileSize(64);
+  EXPECT_TRUE(tiled.IsTiled());
+  EXPECT_EQ(tiled.GetNumberOfTiles(), 5 * 4);
+  int x, y, tile_width, tile_height;
+  tiled.GetTileViewport(19, x, y, tile_width, tile_height);
+  EXPECT_EQ(x, 256);
+  EXPECT_EQ(y, 0);
+  EXPECT_EQ(tile_width, 44);
+  EXPECT_EQ(tile_height, 8);
+
+  vtkh::Render whole = vtkh::MakeRender(width, height, camera, data_set, "untiled_render");
+  whole.DoRenderAnnotations(false);
+  whole.SetImageFormat(vtkh::Render::MEMORY);
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  vtkh::Scene scene;
+  scene.AddRender(tiled);
+  scene.AddRender(whole);
+  scene.AddRenderer(&tracer);
+  scene.Render();
+
+  if(vtkh::GetMPIRank() != 0)
+  {
+    return;
+  }
+
+  unsigned char *decoded = NULL;
+  unsigned decoded_width, decoded_height;
+  unsigned error = vtkh::lodepng_decode32_file(&decoded,
+                                               &decoded_width,
+                                               &decoded_height,
+                                               "tiled_render.png");
+  ASSERT_EQ(error, 0u);
+  ASSERT_EQ(decoded_width, (unsigned)width);
+  ASSERT_EQ(decoded_height, (unsigned)height);
+
+  // the tiles have to line up into the image rendered whole
+  const std::vector<unsigned char> &expected = whole.GetImage().m_pixels;
+  ASSERT_EQ(expected.size(), size_t(width * height * 4));
+  double diff = 0.;
+  for(int row = 0; row < height; ++row)
+  {
+    for(int i = 0; i < width * 4; ++i)
+    {
+      diff += abs(int(decoded[row * width * 4 + i]) -
+                  int(expected[(height - row - 1) * width * 4 + i]));
+    }
+  }
+  free(decoded);
+  EXPECT_LT(diff / (width * height * 4), 1.0);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_annotation_cache)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+
+  vtkh::Render::ClearAnnotationCache();
+
+  // one scene per cycle, the second draws the cached color bar
+  std::vector<vtkh::Render> renders;
+  const vtkm::Float64 maxes[3] = {1000., 1000., 500.};
+  for(int i = 0; i < 3; ++i)
+  {
+    vtkh::Render render = vtkh::MakeRender(256, 256, camera, data_set, "annotation_cache");
+    render.SetImageFormat(vtkh::Render::MEMORY);
+    renders.push_back(render);
+
+    vtkh::RayTracer tracer;
+    tracer.SetInput(&data_set);
+    tracer.SetField("point_data_Float64");
+    tracer.SetRange(vtkm::Range(0., maxes[i]));
+
+    vtkh::Scene scene;
+    scene.AddRender(render);
+    scene.AddRenderer(&tracer);
+    scene.Render();
+  }
+
+  if(vtkh::GetMPIRank() != 0)
+  {
+    return;
+  }
+
+  EXPECT_TRUE(renders[0].GetImage().m_pixels == renders[1].GetImage().m_pixels);
+  // a new range is a new color bar
+  EXPECT_FALSE(renders[0].GetImage().m_pixels == renders[2].GetImage().m_pixels);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_async_save_error)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+
+  // the directory does not exist, so the background write fails
+  vtkh::Render render = vtkh::MakeRender(64, 64, camera, data_set, "no_such_dir/async_error");
+
+  vtkh::RayTracer tracer;
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  EXPECT_TRUE(vtkh::Render::GetAsyncSave());
+  vtkh::Scene scene;
+  scene.AddRender(render);
+  scene.AddRenderer(&tracer);
+  if(vtkh::GetMPIRank() == 0)
+  {
+    EXPECT_THROW(scene.Render(), vtkh::Error);
+  }
+  else
+  {
+    scene.Render();
+  }
+  // the failure is only reported once
+  vtkh::Render::FlushSaves();
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_render, vtkh_async_queue_error)
+{
+  // a throwing job (e.g. a failed composite on the pipeline thread) must
+  // reach the caller, and must not stop the jobs queued behind it
+  vtkh::AsyncQueue queue;
+  queue.SetMaxSize(1);
+  int finished = 0;
+  queue.Push([&finished]() { finished++; });
+  queue.Push([]() { throw vtkh::Error("first"); });
+  queue.Push([]() { throw vtkh::Error("second"); });
+  queue.Push([&finished]() { finished++; });
+
+  bool caught = false;
+  try
+  {
+    queue.Flush();
+  }
+  catch(const vtkh::Error &e)
+  {
+    caught = true;
+    // only the first failure is kept
+    EXPECT_EQ(e.GetMessage(), "first");
+  }
+  EXPECT_TRUE(caught);
+  EXPECT_EQ(finished, 2);
+  EXPECT_EQ(queue.GetSize(), 0);
+
+  // reported once
+  EXPECT_NO_THROW(queue.Flush());
+}
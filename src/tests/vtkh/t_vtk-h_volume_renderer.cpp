@@ -13,6 +13,7 @@
 #include "t_test_utils.hpp"
 
 #include <iostream>
+#include <stdlib.h>
 
 
 
@@ -59,3 +60,179 @@ TEST(vtkh_volume_renderer, vtkh_parallel_render)
   scene.AddRenderer(&tracer);
   scene.Render();
 }
+
+//----------------------------------------------------------------------------
+TEST(vtkh_volume_renderer, vtkh_partial_composite)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 4;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+  camera.Azimuth(30.f);
+  camera.Elevation(20.f);
+
+  const int width = 256;
+  const int height = 256;
+  vtkh::Render images[2];
+  for(int i = 0; i < 2; ++i)
+  {
+    images[i] = vtkh::MakeRender(width, height, camera, data_set, "partial");
+    images[i].SetImageFormat(vtkh::Render::MEMORY);
+  }
+
+  vtkm::cont::ColorTable color_map("Cool to Warm");
+  color_map.AddPointAlpha(0.0, .05);
+  color_map.AddPointAlpha(1.0, .5);
+
+  // the sparse path has to blend the same as the full image path
+  for(int i = 0; i < 2; ++i)
+  {
+    vtkh::VolumeRenderer tracer;
+    tracer.SetColorTable(color_map);
+    tracer.SetInput(&data_set);
+    tracer.SetField("point_data_Float64");
+    tracer.SetUsePartialCompositing(i == 0);
+
+    vtkh::Scene scene;
+    scene.AddRender(images[i]);
+    scene.AddRenderer(&tracer);
+    scene.Render();
+  }
+
+  const vtkh::Image &partial = images[0].GetImage();
+  const vtkh::Image &full = images[1].GetImage();
+  ASSERT_EQ(partial.m_pixels.size(), full.m_pixels.size());
+  // the full image path blends in bytes, partials blend in float
+  int max_diff = 0;
+  for(size_t i = 0; i < partial.m_pixels.size(); ++i)
+  {
+    const int diff = abs(int(partial.m_pixels[i]) - int(full.m_pixels[i]));
+    max_diff = diff > max_diff ? diff : max_diff;
+  }
+  EXPECT_LE(max_diff, 4);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_volume_renderer, vtkh_empty_space_skipping)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 4;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+  camera.Azimuth(30.f);
+  camera.Elevation(20.f);
+
+  const int width = 256;
+  const int height = 256;
+  vtkh::Render images[2];
+  for(int i = 0; i < 2; ++i)
+  {
+    images[i] = vtkh::MakeRender(width, height, camera, data_set, "empty_space");
+    images[i].SetImageFormat(vtkh::Render::MEMORY);
+  }
+
+  // the field grows away from the origin, so the blocks near it are
+  // fully transparent
+  vtkm::cont::ColorTable color_map("Cool to Warm");
+  color_map.ClearAlpha();
+  color_map.AddPointAlpha(0.0, 0.0);
+  color_map.AddPointAlpha(0.6, 0.0);
+  color_map.AddPointAlpha(1.0, 0.5);
+
+  for(int i = 0; i < 2; ++i)
+  {
+    vtkh::VolumeRenderer tracer;
+    tracer.SetColorTable(color_map);
+    tracer.SetInput(&data_set);
+    tracer.SetField("point_data_Float64");
+    tracer.SetEmptySpaceSkipping(i == 0);
+
+    vtkh::Scene scene;
+    scene.AddRender(images[i]);
+    scene.AddRenderer(&tracer);
+    scene.Render();
+  }
+
+  const vtkh::Image &skipped = images[0].GetImage();
+  const vtkh::Image &full = images[1].GetImage();
+  ASSERT_EQ(skipped.m_pixels.size(), full.m_pixels.size());
+  // cropped rays start sampling at a different offset, so allow
+  // small differences
+  double total_diff = 0.;
+  for(size_t i = 0; i < skipped.m_pixels.size(); ++i)
+  {
+    total_diff += abs(int(skipped.m_pixels[i]) - int(full.m_pixels[i]));
+  }
+  EXPECT_LT(total_diff / skipped.m_pixels.size(), 1.0);
+}
+
+//----------------------------------------------------------------------------
+TEST(vtkh_volume_renderer, vtkh_progressive)
+{
+  vtkh::DataSet data_set;
+
+  const int base_size = 32;
+  const int num_blocks = 2;
+
+  for(int i = 0; i < num_blocks; ++i)
+  {
+    data_set.AddDomain(CreateTestData(i, num_blocks, base_size), i);
+  }
+
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+
+  vtkm::rendering::Camera camera;
+  camera.ResetToBounds(bounds);
+  camera.Azimuth(30.f);
+  vtkh::Render render = vtkh::MakeRender(512,
+                                         512,
+                                         camera,
+                                         data_set,
+                                         "volume_progressive");
+
+  vtkm::cont::ColorTable color_map("Cool to Warm");
+  color_map.AddPointAlpha(0.0, .05);
+  color_map.AddPointAlpha(1.0, .5);
+
+  vtkh::VolumeRenderer tracer;
+  tracer.SetColorTable(color_map);
+  tracer.SetInput(&data_set);
+  tracer.SetField("point_data_Float64");
+
+  const int num_passes = 3;
+  int passes_seen = 0;
+  tracer.SetProgressive(num_passes, 10);
+  tracer.SetPassCallback([&](const int pass, std::vector<vtkh::Render> &renders)
+  {
+    EXPECT_EQ(pass, passes_seen);
+    EXPECT_EQ(renders.size(), 1);
+    passes_seen++;
+  });
+
+  vtkh::Scene scene;
+  scene.AddRender(render);
+  scene.AddRenderer(&tracer);
+  scene.Render();
+
+  EXPECT_EQ(passes_seen, num_passes);
+}
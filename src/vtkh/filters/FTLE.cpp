@@ -0,0 +1,684 @@
+#include <vtkh/filters/FTLE.hpp>
+#include <vtkh/Error.hpp>
+#include <vtkh/filters/communication/BoundsMap.hpp>
+#include <vtkh/utils/vtkm_dataset_info.hpp>
+
+#include <vtkm/Math.h>
+#include <vtkm/VectorAnalysis.h>
+#include <vtkm/cont/ArrayHandleIndex.h>
+#include <vtkm/worklet/DispatcherMapField.h>
+#include <vtkm/worklet/WorkletMapField.h>
+
+#include <algorithm>
+#include <numeric>
+
+#ifdef VTKH_PARALLEL
+#include <mpi.h>
+#endif
+
+namespace vtkh
+{
+
+namespace detail
+{
+
+typedef vtkm::Vec<vtkm::Float64,3> Vec3d;
+
+struct CopyVec3
+{
+  std::vector<Vec3d> &m_out;
+  CopyVec3(std::vector<Vec3d> &out)
+    : m_out(out)
+  {}
+
+  template<typename T, typename S>
+  void operator()(const vtkm::cont::ArrayHandle<T,S> &array) const
+  {
+    const vtkm::Id size = array.GetNumberOfValues();
+    auto portal = array.GetPortalConstControl();
+    m_out.resize(size);
+    for(vtkm::Id i = 0; i < size; ++i)
+    {
+      auto v = portal.Get(i);
+      m_out[i] = Vec3d(v[0], v[1], v[2]);
+    }
+  }
+};
+
+// largest eigenvalue of a symmetric 3x3 matrix (closed form)
+VTKM_EXEC_CONT
+inline vtkm::Float64 max_eigenvalue(const vtkm::Float64 c00,
+                                    const vtkm::Float64 c01,
+                                    const vtkm::Float64 c02,
+                                    const vtkm::Float64 c11,
+                                    const vtkm::Float64 c12,
+                                    const vtkm::Float64 c22)
+{
+  const vtkm::Float64 p1 = c01 * c01 + c02 * c02 + c12 * c12;
+  if(p1 == 0.)
+  {
+    return vtkm::Max(c00, vtkm::Max(c11, c22));
+  }
+
+  const vtkm::Float64 q = (c00 + c11 + c22) / 3.;
+  const vtkm::Float64 d0 = c00 - q;
+  const vtkm::Float64 d1 = c11 - q;
+  const vtkm::Float64 d2 = c22 - q;
+  const vtkm::Float64 p2 = d0 * d0 + d1 * d1 + d2 * d2 + 2. * p1;
+  const vtkm::Float64 p = vtkm::Sqrt(p2 / 6.);
+  const vtkm::Float64 inv_p = 1. / p;
+
+  // B = (C - qI) / p, r = det(B) / 2
+  const vtkm::Float64 b00 = d0 * inv_p;
+  const vtkm::Float64 b11 = d1 * inv_p;
+  const vtkm::Float64 b22 = d2 * inv_p;
+  const vtkm::Float64 b01 = c01 * inv_p;
+  const vtkm::Float64 b02 = c02 * inv_p;
+  const vtkm::Float64 b12 = c12 * inv_p;
+  vtkm::Float64 r = 0.5 * (b00 * (b11 * b22 - b12 * b12) -
+                           b01 * (b01 * b22 - b12 * b02) +
+                           b02 * (b01 * b12 - b11 * b02));
+  r = vtkm::Min(vtkm::Max(r, -1.), 1.);
+  const vtkm::Float64 phi = vtkm::ACos(r) / 3.;
+  return q + 2. * p * vtkm::Cos(phi);
+}
+
+class FTLEField : public vtkm::worklet::WorkletMapField
+{
+protected:
+  vtkm::Id3 m_dims;
+  vtkm::Id3 m_pdims;
+  vtkm::Id3 m_offset;
+  vtkm::Float64 m_inv_time;
+public:
+  VTKM_CONT
+  FTLEField(const vtkm::Id3 &dims,
+            const vtkm::Id3 &pdims,
+            const vtkm::Id3 &offset,
+            const vtkm::Float64 time)
+    : m_dims(dims),
+      m_pdims(pdims),
+      m_offset(offset),
+      m_inv_time(1. / vtkm::Abs(time))
+  {
+  }
+
+  typedef void ControlSignature(FieldIn, WholeArrayIn, WholeArrayIn, FieldOut);
+  typedef void ExecutionSignature(_1, _2, _3, _4);
+
+  VTKM_EXEC
+  vtkm::Id Flat(const vtkm::Id3 &p) const
+  {
+    return p[0] + m_pdims[0] * (p[1] + m_pdims[1] * p[2]);
+  }
+
+  template<typename PortalType>
+  VTKM_EXEC
+  void operator()(const vtkm::Id &index,
+                  const PortalType &coords,
+                  const PortalType &flow,
+                  vtkm::Float64 &ftle) const
+  {
+    vtkm::Id3 p;
+    p[0] = index % m_dims[0] + m_offset[0];
+    p[1] = (index / m_dims[0]) % m_dims[1] + m_offset[1];
+    p[2] = index / (m_dims[0] * m_dims[1]) + m_offset[2];
+
+    // columns of the flow map gradient, d(phi) / d(x_b)
+    Vec3d jac[3];
+    for(vtkm::IdComponent b = 0; b < 3; ++b)
+    {
+      jac[b] = Vec3d(0.);
+      if(m_dims[b] < 2)
+      {
+        continue;
+      }
+      vtkm::Id3 lo = p;
+      vtkm::Id3 hi = p;
+      lo[b] -= 1;
+      hi[b] += 1;
+      const vtkm::Id lo_idx = Flat(lo);
+      const vtkm::Id hi_idx = Flat(hi);
+      const vtkm::Float64 dx = coords.Get(hi_idx)[b] - coords.Get(lo_idx)[b];
+      if(dx != 0.)
+      {
+        jac[b] = (flow.Get(hi_idx) - flow.Get(lo_idx)) * (1. / dx);
+      }
+    }
+
+    // right Cauchy-Green tensor C = J^T J
+    const vtkm::Float64 lambda = max_eigenvalue(vtkm::dot(jac[0], jac[0]),
+                                                vtkm::dot(jac[0], jac[1]),
+                                                vtkm::dot(jac[0], jac[2]),
+                                                vtkm::dot(jac[1], jac[1]),
+                                                vtkm::dot(jac[1], jac[2]),
+                                                vtkm::dot(jac[2], jac[2]));
+    ftle = 0.;
+    if(lambda > 0.)
+    {
+      ftle = 0.5 * vtkm::Log(lambda) * m_inv_time;
+    }
+  }
+}; //class FTLEField
+
+//
+// The seed grid of one domain padded by a ghost layer on each side of
+// every non-degenerate axis. Ghosts default to copies of the boundary
+// layer, which turns central differences into one sided differences,
+// and are replaced by the neighbor's adjacent layer when one is found.
+//
+struct FlowBlock
+{
+  vtkm::Id m_id;
+  vtkm::Id3 m_dims;
+  vtkm::Id3 m_pdims;
+  vtkm::Id3 m_offset;
+  vtkm::Bounds m_bounds;
+  std::vector<Vec3d> m_coords;
+  std::vector<Vec3d> m_flow;
+  // original point index for each grid position
+  std::vector<vtkm::Id> m_order;
+
+  vtkm::Id Flat(const vtkm::Id3 &p) const
+  {
+    return p[0] + m_pdims[0] * (p[1] + m_pdims[1] * p[2]);
+  }
+
+  vtkm::Id NumPoints() const
+  {
+    return m_dims[0] * m_dims[1] * m_dims[2];
+  }
+
+  static void Tangents(const int axis, int &t0, int &t1)
+  {
+    t0 = axis == 0 ? 1 : 0;
+    t1 = axis == 2 ? 1 : 2;
+  }
+
+  vtkm::Id LayerSize(const int axis) const
+  {
+    int t0, t1;
+    Tangents(axis, t0, t1);
+    return m_dims[t0] * m_dims[t1];
+  }
+
+  void Init(const std::vector<Vec3d> &coords, const std::vector<Vec3d> &flow)
+  {
+    for(int a = 0; a < 3; ++a)
+    {
+      m_offset[a] = m_dims[a] > 1 ? 1 : 0;
+      m_pdims[a] = m_dims[a] + 2 * m_offset[a];
+    }
+
+    const vtkm::Id psize = m_pdims[0] * m_pdims[1] * m_pdims[2];
+    m_coords.resize(psize);
+    m_flow.resize(psize);
+
+    vtkm::Id n = 0;
+    for(vtkm::Id k = 0; k < m_dims[2]; ++k)
+      for(vtkm::Id j = 0; j < m_dims[1]; ++j)
+        for(vtkm::Id i = 0; i < m_dims[0]; ++i, ++n)
+        {
+          const vtkm::Id idx = Flat(vtkm::Id3(i, j, k) + m_offset);
+          m_coords[idx] = coords[m_order[n]];
+          m_flow[idx] = flow[m_order[n]];
+        }
+
+    // default ghosts are copies of the boundary layers
+    for(int a = 0; a < 3; ++a)
+    {
+      if(m_dims[a] < 2)
+      {
+        continue;
+      }
+      std::vector<vtkm::Float64> layer;
+      GetLayer(a, 0, layer);
+      SetGhost(a, 0, &layer[0], LayerSize(a));
+      layer.clear();
+      GetLayer(a, m_dims[a] - 1, layer);
+      SetGhost(a, 1, &layer[0], LayerSize(a));
+    }
+  }
+
+  // appends the coords and flow of layer 'index' along 'axis'
+  void GetLayer(const int axis, const vtkm::Id index, std::vector<vtkm::Float64> &buff) const
+  {
+    int t0, t1;
+    Tangents(axis, t0, t1);
+    const vtkm::Id size = LayerSize(axis);
+    const size_t start = buff.size();
+    buff.resize(start + size * 6);
+    vtkm::Float64 *coords = &buff[start];
+    vtkm::Float64 *flow = &buff[start + size * 3];
+    vtkm::Id n = 0;
+    for(vtkm::Id v = 0; v < m_dims[t1]; ++v)
+      for(vtkm::Id u = 0; u < m_dims[t0]; ++u, ++n)
+      {
+        vtkm::Id3 p = m_offset;
+        p[axis] += index;
+        p[t0] += u;
+        p[t1] += v;
+        const vtkm::Id idx = Flat(p);
+        for(int c = 0; c < 3; ++c)
+        {
+          coords[n * 3 + c] = m_coords[idx][c];
+          flow[n * 3 + c] = m_flow[idx][c];
+        }
+      }
+  }
+
+  // side 0 is the low ghost layer, side 1 the high one
+  void SetGhost(const int axis, const int side, const vtkm::Float64 *data, const vtkm::Id size)
+  {
+    if(size != LayerSize(axis) || m_dims[axis] < 2)
+    {
+      // mismatched seed resolution, keep the one sided difference
+      return;
+    }
+    int t0, t1;
+    Tangents(axis, t0, t1);
+    const vtkm::Float64 *coords = data;
+    const vtkm::Float64 *flow = data + size * 3;
+    vtkm::Id n = 0;
+    for(vtkm::Id v = 0; v < m_dims[t1]; ++v)
+      for(vtkm::Id u = 0; u < m_dims[t0]; ++u, ++n)
+      {
+        vtkm::Id3 p(0, 0, 0);
+        p[axis] = side == 0 ? 0 : m_pdims[axis] - 1;
+        p[t0] = u + m_offset[t0];
+        p[t1] = v + m_offset[t1];
+        const vtkm::Id idx = Flat(p);
+        m_coords[idx] = Vec3d(coords[n * 3 + 0], coords[n * 3 + 1], coords[n * 3 + 2]);
+        m_flow[idx] = Vec3d(flow[n * 3 + 0], flow[n * 3 + 1], flow[n * 3 + 2]);
+      }
+  }
+
+  vtkm::Float64 Spacing(const int axis, const int side) const
+  {
+    vtkm::Id3 p0 = m_offset;
+    vtkm::Id3 p1 = m_offset;
+    if(side == 0)
+    {
+      p1[axis] += 1;
+    }
+    else
+    {
+      p0[axis] += m_dims[axis] - 2;
+      p1[axis] += m_dims[axis] - 1;
+    }
+    return vtkm::Abs(m_coords[Flat(p1)][axis] - m_coords[Flat(p0)][axis]);
+  }
+};
+
+// Determines the grid dimensions and an x fastest ordering of the points.
+void build_grid(const vtkm::cont::DataSet &dom,
+                const std::vector<Vec3d> &coords,
+                FlowBlock &block)
+{
+  const vtkm::Id num_points = static_cast<vtkm::Id>(coords.size());
+  block.m_order.resize(num_points);
+  std::iota(block.m_order.begin(), block.m_order.end(), 0);
+
+  int dims[3] = {1, 1, 1};
+  if(VTKMDataSetInfo::GetPointDims(dom, dims))
+  {
+    block.m_dims = vtkm::Id3(dims[0], dims[1], dims[2]);
+    return;
+  }
+
+  // unstructured seeds (e.g. Lagrangian basis flows): infer the grid.
+  // Seeds computed in floating point may not repeat a coordinate
+  // exactly, so values closer than a small fraction of the extent are
+  // treated as one grid line.
+  vtkm::Float64 extent = 0.;
+  for(int a = 0; a < 3; ++a)
+  {
+    vtkm::Float64 lo = vtkm::Infinity64();
+    vtkm::Float64 hi = vtkm::NegativeInfinity64();
+    for(vtkm::Id i = 0; i < num_points; ++i)
+    {
+      lo = std::min(lo, coords[i][a]);
+      hi = std::max(hi, coords[i][a]);
+    }
+    if(num_points > 0)
+    {
+      extent = std::max(extent, hi - lo);
+    }
+  }
+  const vtkm::Float64 tolerance = extent * 1e-6;
+
+  // grid line of each point along each axis
+  std::vector<vtkm::Id3> lines(num_points);
+  for(int a = 0; a < 3; ++a)
+  {
+    std::vector<vtkm::Float64> vals(num_points);
+    for(vtkm::Id i = 0; i < num_points; ++i)
+    {
+      vals[i] = coords[i][a];
+    }
+    std::sort(vals.begin(), vals.end());
+    // the smallest value of each line
+    std::vector<vtkm::Float64> starts;
+    for(vtkm::Id i = 0; i < num_points; ++i)
+    {
+      if(i == 0 || vals[i] - vals[i - 1] > tolerance)
+      {
+        starts.push_back(vals[i]);
+      }
+    }
+    block.m_dims[a] = static_cast<vtkm::Id>(starts.size());
+    for(vtkm::Id i = 0; i < num_points; ++i)
+    {
+      lines[i][a] = (std::upper_bound(starts.begin(), starts.end(), coords[i][a]) - starts.begin()) - 1;
+    }
+  }
+
+  if(block.NumPoints() != num_points)
+  {
+    throw Error("FTLE: domain points do not form a seed grid");
+  }
+
+  std::sort(block.m_order.begin(), block.m_order.end(),
+            [&lines](const vtkm::Id &a, const vtkm::Id &b)
+            {
+              const vtkm::Id3 &la = lines[a];
+              const vtkm::Id3 &lb = lines[b];
+              if(la[2] != lb[2]) return la[2] < lb[2];
+              if(la[1] != lb[1]) return la[1] < lb[1];
+              return la[0] < lb[0];
+            });
+}
+
+//
+// Sends the layer adjacent to each shared face to the neighboring domain.
+// Domains are neighbors when their bounds meet (shared seed plane) or are
+// separated by at most one seed spacing, and they span the same range on
+// the tangential axes. Messages are
+//   [dest domain, axis, side, layer size, coords..., flow...]
+//
+void exchange_ghosts(std::vector<FlowBlock> &blocks, BoundsMap &bounds_map)
+{
+  int procs = 1;
+#ifdef VTKH_PARALLEL
+  MPI_Comm mpi_comm = MPI_Comm_f2c(vtkh::GetMPICommHandle());
+  MPI_Comm_size(mpi_comm, &procs);
+#endif
+
+  const vtkm::Bounds &global = bounds_map.globalBounds;
+  const vtkm::Float64 extent = vtkm::Max(global.X.Length(),
+                                         vtkm::Max(global.Y.Length(), global.Z.Length()));
+  const vtkm::Float64 tol = 1e-6 * (extent > 0. ? extent : 1.);
+
+  std::vector<std::vector<vtkm::Float64>> send(procs);
+  for(size_t b = 0; b < blocks.size(); ++b)
+  {
+    const FlowBlock &block = blocks[b];
+    const vtkm::Bounds &bs = block.m_bounds;
+    for(auto it = bounds_map.bm.begin(); it != bounds_map.bm.end(); ++it)
+    {
+      if(it->first == block.m_id)
+      {
+        continue;
+      }
+      const vtkm::Bounds &br = it->second;
+      const vtkm::Range srange[3] = {bs.X, bs.Y, bs.Z};
+      const vtkm::Range rrange[3] = {br.X, br.Y, br.Z};
+
+      for(int a = 0; a < 3; ++a)
+      {
+        if(block.m_dims[a] < 2)
+        {
+          continue;
+        }
+        int t0, t1;
+        FlowBlock::Tangents(a, t0, t1);
+        bool aligned = true;
+        for(int t : {t0, t1})
+        {
+          aligned &= vtkm::Abs(srange[t].Min - rrange[t].Min) <= tol &&
+                     vtkm::Abs(srange[t].Max - rrange[t].Max) <= tol;
+        }
+        if(!aligned)
+        {
+          continue;
+        }
+
+        for(int side = 0; side < 2; ++side)
+        {
+          const vtkm::Float64 gap = side == 0 ? srange[a].Min - rrange[a].Max
+                                              : rrange[a].Min - srange[a].Max;
+          const vtkm::Float64 h = block.Spacing(a, side);
+          if(gap < -tol || gap > 1.5 * h)
+          {
+            continue;
+          }
+          // a shared seed plane means the neighbor needs the next layer in
+          const bool shared = gap <= tol;
+          vtkm::Id layer = side == 0 ? 0 : block.m_dims[a] - 1;
+          if(shared)
+          {
+            layer += side == 0 ? 1 : -1;
+          }
+
+          int dest = 0;
+#ifdef VTKH_PARALLEL
+          dest = bounds_map.GetRank(it->first);
+#endif
+          std::vector<vtkm::Float64> &buff = send[dest];
+          buff.push_back(it->first);
+          buff.push_back(a);
+          // our low side is the neighbor's high side
+          buff.push_back(side == 0 ? 1 : 0);
+          buff.push_back(block.LayerSize(a));
+          block.GetLayer(a, layer, buff);
+        }
+      }
+    }
+  }
+
+  std::vector<vtkm::Float64> recv;
+#ifdef VTKH_PARALLEL
+  std::vector<int> send_counts(procs), recv_counts(procs);
+  std::vector<int> send_offsets(procs, 0), recv_offsets(procs, 0);
+  for(int i = 0; i < procs; ++i)
+  {
+    send_counts[i] = static_cast<int>(send[i].size());
+  }
+  MPI_Alltoall(&send_counts[0], 1, MPI_INT, &recv_counts[0], 1, MPI_INT, mpi_comm);
+
+  std::vector<vtkm::Float64> send_buff;
+  for(int i = 0; i < procs; ++i)
+  {
+    if(i > 0)
+    {
+      send_offsets[i] = send_offsets[i-1] + send_counts[i-1];
+      recv_offsets[i] = recv_offsets[i-1] + recv_counts[i-1];
+    }
+    send_buff.insert(send_buff.end(), send[i].begin(), send[i].end());
+  }
+  recv.resize(recv_offsets[procs-1] + recv_counts[procs-1]);
+  MPI_Alltoallv(send_buff.data(), &send_counts[0], &send_offsets[0], MPI_DOUBLE,
+                recv.data(), &recv_counts[0], &recv_offsets[0], MPI_DOUBLE,
+                mpi_comm);
+#else
+  recv.swap(send[0]);
+#endif
+
+  size_t pos = 0;
+  while(pos < recv.size())
+  {
+    const vtkm::Id dest = static_cast<vtkm::Id>(recv[pos + 0]);
+    const int axis = static_cast<int>(recv[pos + 1]);
+    const int side = static_cast<int>(recv[pos + 2]);
+    const vtkm::Id size = static_cast<vtkm::Id>(recv[pos + 3]);
+    pos += 4;
+    for(size_t b = 0; b < blocks.size(); ++b)
+    {
+      if(blocks[b].m_id == dest)
+      {
+        blocks[b].SetGhost(axis, side, &recv[pos], size);
+      }
+    }
+    pos += size * 6;
+  }
+}
+
+} // namespace detail
+
+FTLE::FTLE()
+  : m_result_name("ftle"),
+    m_integration_time(0.),
+    m_is_displacement(false)
+{
+}
+
+FTLE::~FTLE()
+{
+}
+
+void
+FTLE::SetField(const std::string &field_name)
+{
+  m_field_name = field_name;
+}
+
+void
+FTLE::SetFieldIsDisplacement(bool on)
+{
+  m_is_displacement = on;
+}
+
+void
+FTLE::SetIntegrationTime(const double &time)
+{
+  m_integration_time = time;
+}
+
+void
+FTLE::SetResultField(const std::string &field_name)
+{
+  m_result_name = field_name;
+}
+
+std::string
+FTLE::GetField() const
+{
+  return m_field_name;
+}
+
+std::string
+FTLE::GetResultField() const
+{
+  return m_result_name;
+}
+
+void FTLE::PreExecute()
+{
+  Filter::PreExecute();
+  Filter::CheckForRequiredField(m_field_name);
+
+  if(m_integration_time == 0.)
+  {
+    throw Error("FTLE: integration time must be non-zero");
+  }
+}
+
+void FTLE::PostExecute()
+{
+  Filter::PostExecute();
+}
+
+void FTLE::DoExecute()
+{
+  this->m_output = new DataSet();
+  // shallow copy input data set and bump internal ref counts
+  *m_output = *m_input;
+
+  const int num_domains = this->m_output->GetNumberOfDomains();
+
+  std::vector<detail::FlowBlock> blocks;
+  std::vector<int> block_domains;
+  BoundsMap bounds_map;
+
+  for(int i = 0; i < num_domains; ++i)
+  {
+    vtkm::Id domain_id;
+    vtkm::cont::DataSet dom;
+    this->m_output->GetDomain(i, dom, domain_id);
+
+    if(!dom.HasField(m_field_name))
+    {
+      continue;
+    }
+
+    vtkm::cont::Field field = dom.GetField(m_field_name);
+    if(field.GetAssociation() != vtkm::cont::Field::Association::POINTS)
+    {
+      throw Error("FTLE: flow map field must be nodal");
+    }
+
+    std::vector<detail::Vec3d> coords, flow;
+    detail::CopyVec3 coord_copy(coords);
+    coord_copy(dom.GetCoordinateSystem().GetData());
+    field.GetData().ResetTypes(vtkm::TypeListTagFieldVec3()).CastAndCall(detail::CopyVec3(flow));
+
+    if(m_is_displacement)
+    {
+      for(size_t p = 0; p < flow.size(); ++p)
+      {
+        flow[p] = flow[p] + coords[p];
+      }
+    }
+
+    detail::FlowBlock block;
+    block.m_id = domain_id;
+    block.m_bounds = dom.GetCoordinateSystem().GetBounds();
+    detail::build_grid(dom, coords, block);
+    block.Init(coords, flow);
+
+    bounds_map.AddBlock(domain_id, block.m_bounds);
+    blocks.push_back(block);
+    block_domains.push_back(i);
+  }
+
+  // collective even if this rank has no flow map
+  bounds_map.Build();
+  detail::exchange_ghosts(blocks, bounds_map);
+
+  for(size_t b = 0; b < blocks.size(); ++b)
+  {
+    detail::FlowBlock &block = blocks[b];
+    const vtkm::Id num_points = block.NumPoints();
+
+    vtkm::cont::ArrayHandle<detail::Vec3d> coords = vtkm::cont::make_ArrayHandle(block.m_coords);
+    vtkm::cont::ArrayHandle<detail::Vec3d> flow = vtkm::cont::make_ArrayHandle(block.m_flow);
+    vtkm::cont::ArrayHandle<vtkm::Float64> grid_ftle;
+
+    vtkm::worklet::DispatcherMapField<detail::FTLEField>(
+      detail::FTLEField(block.m_dims, block.m_pdims, block.m_offset, m_integration_time))
+      .Invoke(vtkm::cont::ArrayHandleIndex(num_points), coords, flow, grid_ftle);
+
+    // back to the original point order
+    vtkm::cont::ArrayHandle<vtkm::Float64> ftle;
+    ftle.Allocate(num_points);
+    auto in_portal = grid_ftle.GetPortalConstControl();
+    auto out_portal = ftle.GetPortalControl();
+    for(vtkm::Id p = 0; p < num_points; ++p)
+    {
+      out_portal.Set(block.m_order[p], in_portal.Get(p));
+    }
+
+    vtkm::cont::DataSet &dom = this->m_output->GetDomain(block_domains[b]);
+    dom.AddField(vtkm::cont::Field(m_result_name,
+                                   vtkm::cont::Field::Association::POINTS,
+                                   ftle));
+  }
+}
+
+std::string
+FTLE::GetName() const
+{
+  return "vtkh::FTLE";
+}
+
+} //  namespace vtkh
@@ -0,0 +1,48 @@
+#ifndef VTK_H_FTLE_HPP
+#define VTK_H_FTLE_HPP
+
+#include <vtkh/vtkh_exports.h>
+#include <vtkh/vtkh.hpp>
+#include <vtkh/filters/Filter.hpp>
+#include <vtkh/DataSet.hpp>
+
+namespace vtkh
+{
+
+//
+// Computes the finite-time Lyapunov exponent from a flow map sampled on
+// a seed grid, e.g. the basis flows produced by Lagrangian or the end
+// points of ParticleAdvection seeds. Each domain must either be
+// structured or have points that form an axis aligned grid. Boundary
+// derivatives use the adjacent seed layer of neighboring domains when
+// one exists.
+//
+class VTKH_API FTLE : public Filter
+{
+public:
+  FTLE();
+  virtual ~FTLE();
+  std::string GetName() const override;
+
+  // point field holding the advected position of each seed
+  void SetField(const std::string &field_name);
+  // the field holds displacements instead of end positions (Lagrangian output)
+  void SetFieldIsDisplacement(bool on);
+  void SetIntegrationTime(const double &time);
+  void SetResultField(const std::string &field_name);
+
+  std::string GetField() const;
+  std::string GetResultField() const;
+protected:
+  void PreExecute() override;
+  void PostExecute() override;
+  void DoExecute() override;
+
+  std::string m_field_name;
+  std::string m_result_name;
+  double m_integration_time;
+  bool m_is_displacement;
+};
+
+} //namespace vtkh
+#endif
@@ -9,14 +9,170 @@
 #include <vector>
 #include <string>
 
+#include <vtkm/Math.h>
+#include <vtkm/cont/Algorithm.h>
+#include <vtkm/cont/ArrayHandleConstant.h>
+#include <vtkm/cont/CellSetExplicit.h>
 #include <vtkm/cont/DataSet.h>
+#include <vtkm/worklet/DispatcherMapField.h>
 #include <vtkm/worklet/ParticleAdvection.h>
+#include <vtkm/worklet/WorkletMapField.h>
 #include <vtkm/worklet/particleadvection/GridEvaluators.h>
 #include <vtkm/worklet/particleadvection/Integrators.h>
 #include <vtkm/worklet/particleadvection/Particles.h>
+#include <vtkm/worklet/particleadvection/TemporalGridEvaluators.h>
 
 #include <vtkh/vtkh_exports.h>
 #include <vtkh/filters/Particle.hpp>
+#include <vtkh/filters/TerminationCriteria.hpp>
+
+namespace vtkh
+{
+namespace detail
+{
+
+//
+// Advects each particle until it leaves the domain, hits max steps,
+// or one of the termination predicates fires. This mirrors the vtk-m
+// particle advection worklet, but evaluates the predicates per step so
+// stalled particles do not keep integrating until max steps.
+// The status written is in the vtk-m ParticleStatus bit encoding.
+// If 'm_stride' is non-zero every position is recorded into 'history'
+// at offset index * m_stride. With a temporal evaluator, particles that
+// reach the end of the time interval take a partial step to 'end_time'
+// and stop with END_OF_INTERVAL.
+//
+class TerminatingAdvect : public vtkm::worklet::WorkletMapField
+{
+public:
+  using ParticleStatus = vtkm::worklet::particleadvection::ParticleStatus;
+
+  TerminatingAdvect(const vtkm::Id max_steps,
+                    const vtkm::Float64 step_size,
+                    const vtkh::TerminationCriteria &criteria,
+                    const vtkm::Id stride,
+                    const vtkm::Float64 end_time = vtkm::Infinity64())
+    : m_max_steps(max_steps),
+      m_step_size(step_size),
+      m_criteria(criteria),
+      m_stride(stride),
+      m_end_time(end_time)
+  {}
+
+  using ControlSignature = void(FieldInOut pos,
+                                FieldInOut steps,
+                                FieldInOut arc_length,
+                                FieldInOut time,
+                                FieldOut status,
+                                FieldOut reason,
+                                FieldOut num_points,
+                                ExecObject integrator,
+                                WholeArrayOut history);
+  using ExecutionSignature = void(WorkIndex, _1, _2, _3, _4, _5, _6, _7, _8, _9);
+
+  template<typename IntegratorType, typename HistoryPortal>
+  VTKM_EXEC void operator()(const vtkm::Id &index,
+                            vtkm::Vec<vtkm::Float64,3> &pos,
+                            vtkm::Id &steps,
+                            vtkm::Float64 &arc_length,
+                            vtkm::Float64 &time,
+                            vtkm::Id &status,
+                            vtkm::Id &reason,
+                            vtkm::Id &num_points,
+                            const IntegratorType *integrator,
+                            HistoryPortal &history) const
+  {
+    const vtkm::Id success = static_cast<vtkm::Id>(ParticleStatus::SUCCESS);
+    const vtkm::Id boundary = static_cast<vtkm::Id>(ParticleStatus::AT_SPATIAL_BOUNDARY);
+    const vtkm::Id temporal = static_cast<vtkm::Id>(ParticleStatus::AT_TEMPORAL_BOUNDARY) |
+                              static_cast<vtkm::Id>(ParticleStatus::EXIT_TEMPORAL_BOUNDARY);
+
+    status = success;
+    reason = vtkh::TerminationCriteria::NOT_TERMINATED;
+    num_points = 0;
+    Record(index, num_points, pos, history);
+
+    vtkm::Vec<vtkm::Float64,3> out;
+    while(steps < m_max_steps)
+    {
+      vtkm::Id res = static_cast<vtkm::Id>(integrator->Step(pos, time, out));
+      if((res & success) != 0)
+      {
+        arc_length += vtkm::Magnitude(out - pos);
+        reason = m_criteria.Evaluate(pos, out, m_step_size, arc_length);
+        pos = out;
+        steps++;
+        status |= static_cast<vtkm::Id>(ParticleStatus::TOOK_ANY_STEPS);
+        Record(index, num_points, pos, history);
+        if(reason != vtkh::TerminationCriteria::NOT_TERMINATED)
+        {
+          status |= static_cast<vtkm::Id>(ParticleStatus::TERMINATED);
+          break;
+        }
+      }
+      else if((res & temporal) != 0)
+      {
+        // a full step would pass the end of the interval, so step just
+        // far enough to reach it
+        if(time < m_end_time)
+        {
+          integrator->SmallStep(pos, time, out);
+          arc_length += vtkm::Magnitude(out - pos);
+          pos = out;
+          steps++;
+          status |= static_cast<vtkm::Id>(ParticleStatus::TOOK_ANY_STEPS);
+          Record(index, num_points, pos, history);
+        }
+        time = m_end_time;
+        reason = vtkh::TerminationCriteria::END_OF_INTERVAL;
+        status |= static_cast<vtkm::Id>(ParticleStatus::TERMINATED);
+        break;
+      }
+      else if((res & boundary) != 0)
+      {
+        // nudge the particle just outside so the next domain picks it up
+        integrator->SmallStep(pos, time, out);
+        arc_length += vtkm::Magnitude(out - pos);
+        pos = out;
+        steps++;
+        status |= static_cast<vtkm::Id>(ParticleStatus::TOOK_ANY_STEPS);
+        Record(index, num_points, pos, history);
+        status |= static_cast<vtkm::Id>(ParticleStatus::EXIT_SPATIAL_BOUNDARY);
+        break;
+      }
+      else
+      {
+        // the integrator could not step, the particle did not leave
+        reason = vtkh::TerminationCriteria::FAILED;
+        status |= static_cast<vtkm::Id>(ParticleStatus::TERMINATED);
+        break;
+      }
+    }
+  }
+
+private:
+  template<typename HistoryPortal>
+  VTKM_EXEC void Record(const vtkm::Id &index,
+                        vtkm::Id &num_points,
+                        const vtkm::Vec<vtkm::Float64,3> &pos,
+                        HistoryPortal &history) const
+  {
+    if(m_stride > 0 && num_points < m_stride)
+    {
+      history.Set(index * m_stride + num_points, pos);
+    }
+    num_points++;
+  }
+
+  vtkm::Id m_max_steps;
+  vtkm::Float64 m_step_size;
+  vtkh::TerminationCriteria m_criteria;
+  vtkm::Id m_stride;
+  vtkm::Float64 m_end_time;
+};
+
+} // namespace detail
+} // namespace vtkh
 
 class VTKH_API Integrator
 {
@@ -25,16 +181,47 @@ class VTKH_API Integrator
 
     using GridEvalType = vtkm::worklet::particleadvection::GridEvaluator<FieldHandle>;
     using RK4Type = vtkm::worklet::particleadvection::RK4Integrator<GridEvalType>;
+    using TemporalGridEvalType = vtkm::worklet::particleadvection::TemporalGridEvaluator<FieldHandle>;
+    using TemporalRK4Type = vtkm::worklet::particleadvection::RK4Integrator<TemporalGridEvalType>;
     using vtkmParticleStatus = vtkm::worklet::particleadvection::ParticleStatus;
 
 public:
-    Integrator(vtkm::cont::DataSet *ds, const std::string &fieldName, FieldType _stepSize) : stepSize(_stepSize)
+    Integrator(vtkm::cont::DataSet *ds, const std::string &fieldName, FieldType _stepSize)
+      : stepSize(_stepSize), temporal(false), endTime(vtkm::Infinity64())
     {
         vecField = ds->GetField(fieldName).GetData().Cast<FieldHandle>();
         gridEval = GridEvalType(ds->GetCoordinateSystem(), ds->GetCellSet(), vecField);
         rk4 = RK4Type(gridEval, stepSize);
     }
 
+    // Pathline integrator: the field is interpolated in time between
+    // 'prevDs' at 'prevTime' and 'ds' at 'time'.
+    Integrator(vtkm::cont::DataSet *prevDs,
+               FieldType prevTime,
+               vtkm::cont::DataSet *ds,
+               FieldType time,
+               const std::string &fieldName,
+               FieldType _stepSize)
+      : stepSize(_stepSize), temporal(true), endTime(time)
+    {
+        vecField = ds->GetField(fieldName).GetData().Cast<FieldHandle>();
+        FieldHandle prevField = prevDs->GetField(fieldName).GetData().Cast<FieldHandle>();
+        TemporalGridEvalType temporalEval(prevDs->GetCoordinateSystem(),
+                                          prevDs->GetCellSet(),
+                                          prevField,
+                                          prevTime,
+                                          ds->GetCoordinateSystem(),
+                                          ds->GetCellSet(),
+                                          vecField,
+                                          time);
+        temporalRk4 = TemporalRK4Type(temporalEval, stepSize);
+    }
+
+    void SetTerminationCriteria(const vtkh::TerminationCriteria &criteria)
+    {
+        termCriteria = criteria;
+    }
+
     int Advect(std::vector<vtkh::Particle> &particles,
                const vtkm::Id &maxSteps,
                std::vector<vtkh::Particle> &I,
@@ -48,10 +235,20 @@ public:
 
         int steps0 = SeedPrep(particles, seedArray, stepsTakenArray);
 
-        vtkm::worklet::ParticleAdvection particleAdvection;
         vtkm::worklet::ParticleAdvectionResult result;
-
-        result = particleAdvection.Run(rk4, seedArray, stepsTakenArray, maxSteps);
+        if (UseTerminatingAdvect())
+        {
+            vtkm::cont::ArrayHandle<vtkm::Vec<FieldType,3>> history;
+            RunTerminatingAdvect(particles, seedArray, stepsTakenArray, maxSteps, 0, history);
+            result.positions = seedArray;
+            result.stepsTaken = stepsTakenArray;
+            result.status = statusArray;
+        }
+        else
+        {
+            vtkm::worklet::ParticleAdvection particleAdvection;
+            result = particleAdvection.Run(rk4, seedArray, stepsTakenArray, maxSteps);
+        }
         auto posPortal = result.positions.GetPortalConstControl();
         auto statusPortal = result.status.GetPortalConstControl();
         auto stepsPortal = result.stepsTaken.GetPortalConstControl();
@@ -63,6 +260,7 @@ public:
         {
             particles[i].coords = posPortal.Get(i);
             particles[i].nSteps = stepsPortal.Get(i);
+            UpdateTermination(particles[i], i);
             UpdateStatus(particles[i], statusPortal.Get(i), maxSteps, I,T,A);
             steps1 += stepsPortal.Get(i);
         }
@@ -101,9 +299,22 @@ public:
 
         int steps0 = SeedPrep(particles, seedArray, stepsTakenArray);
 
-        vtkm::worklet::Streamline streamline;
         vtkm::worklet::StreamlineResult result;
-        result = streamline.Run(rk4, seedArray, stepsTakenArray, maxSteps);
+        if (UseTerminatingAdvect())
+        {
+            // record every step so the polylines can be built afterwards
+            vtkm::cont::ArrayHandle<vtkm::Vec<FieldType,3>> history;
+            const vtkm::Id stride = maxSteps + 1;
+            RunTerminatingAdvect(particles, seedArray, stepsTakenArray, maxSteps, stride, history);
+            BuildPolyLines(history, stride, result);
+            result.stepsTaken = stepsTakenArray;
+            result.status = statusArray;
+        }
+        else
+        {
+            vtkm::worklet::Streamline streamline;
+            result = streamline.Run(rk4, seedArray, stepsTakenArray, maxSteps);
+        }
         auto posPortal = result.positions.GetPortalConstControl();
         auto statusPortal = result.status.GetPortalConstControl();
         auto stepsPortal = result.stepsTaken.GetPortalConstControl();
@@ -121,6 +332,7 @@ public:
               particles[i].coords = posPortal.Get(idPortal.Get(nPts-1));
             particles[i].nSteps = stepsPortal.Get(i);
             steps1 += stepsPortal.Get(i);
+            UpdateTermination(particles[i], i);
             UpdateStatus(particles[i], statusPortal.Get(i), maxSteps, I,T,A);
 
             /*
@@ -163,11 +375,25 @@ private:
                       std::vector<vtkh::Particle> &A)
     {
 
-        if (p.nSteps >= maxSteps || Terminated(status))
+        if (p.termReason == vtkh::TerminationCriteria::END_OF_INTERVAL)
         {
+            // counted as finished for this interval, resumed next time
             p.status = vtkh::Particle::TERMINATE;
             T.push_back(p);
         }
+        else if (p.nSteps >= maxSteps || Terminated(status))
+        {
+            if (p.termReason == vtkh::TerminationCriteria::NOT_TERMINATED)
+                p.termReason = vtkh::TerminationCriteria::MAX_STEPS;
+            p.status = vtkh::Particle::TERMINATE;
+            T.push_back(p);
+        }
+        else if (ExitSpatialBoundary(status))
+        {
+            // left the domain, hand it to the one it entered
+            p.status = vtkh::Particle::OUTOFBOUNDS;
+            I.push_back(p);
+        }
         else if (OK(status))
         {
             if (TookAnySteps(status))
@@ -188,6 +414,98 @@ private:
         }
     }
 
+    // The vtk-m worklets know nothing about time or our predicates.
+    bool UseTerminatingAdvect() const
+    {
+        return temporal || termCriteria.IsActive();
+    }
+
+    // Copies the arc length, time and termination reason produced by the
+    // last terminating advection back into the particle.
+    void UpdateTermination(vtkh::Particle &p, const vtkm::Id &index)
+    {
+        if (!UseTerminatingAdvect())
+            return;
+        p.arcLength = arcLengthArray.GetPortalConstControl().Get(index);
+        p.time = timeArray.GetPortalConstControl().Get(index);
+        p.termReason = static_cast<int>(reasonArray.GetPortalConstControl().Get(index));
+    }
+
+    void RunTerminatingAdvect(const std::vector<vtkh::Particle> &particles,
+                              vtkm::cont::ArrayHandle<vtkm::Vec<FieldType,3>> &seedArray,
+                              vtkm::cont::ArrayHandle<vtkm::Id> &stepArray,
+                              const vtkm::Id &maxSteps,
+                              const vtkm::Id &stride,
+                              vtkm::cont::ArrayHandle<vtkm::Vec<FieldType,3>> &history)
+    {
+        const vtkm::Id nSeeds = static_cast<vtkm::Id>(particles.size());
+        arcLengthArray.Allocate(nSeeds);
+        timeArray.Allocate(nSeeds);
+        auto arcPortal = arcLengthArray.GetPortalControl();
+        auto timePortal = timeArray.GetPortalControl();
+        for (vtkm::Id i = 0; i < nSeeds; i++)
+        {
+            arcPortal.Set(i, particles[i].arcLength);
+            timePortal.Set(i, particles[i].time);
+        }
+
+        history.Allocate(nSeeds * stride);
+
+        vtkh::detail::TerminatingAdvect worklet(maxSteps, stepSize, termCriteria, stride, endTime);
+        vtkm::worklet::DispatcherMapField<vtkh::detail::TerminatingAdvect> dispatcher(worklet);
+        if (temporal)
+            dispatcher.Invoke(seedArray, stepArray, arcLengthArray, timeArray,
+                              statusArray, reasonArray, numPointsArray,
+                              temporalRk4, history);
+        else
+            dispatcher.Invoke(seedArray, stepArray, arcLengthArray, timeArray,
+                              statusArray, reasonArray, numPointsArray,
+                              rk4, history);
+    }
+
+    // Compacts the per particle position history into one polyline per particle.
+    void BuildPolyLines(const vtkm::cont::ArrayHandle<vtkm::Vec<FieldType,3>> &history,
+                        const vtkm::Id &stride,
+                        vtkm::worklet::StreamlineResult &result)
+    {
+        const vtkm::Id nSeeds = numPointsArray.GetNumberOfValues();
+        auto numPortal = numPointsArray.GetPortalConstControl();
+        vtkm::Id totalPts = 0;
+        for (vtkm::Id i = 0; i < nSeeds; i++)
+            totalPts += vtkm::Min(numPortal.Get(i), stride);
+
+        vtkm::cont::ArrayHandle<vtkm::Vec<FieldType,3>> positions;
+        vtkm::cont::ArrayHandle<vtkm::Id> connectivity;
+        vtkm::cont::ArrayHandle<vtkm::IdComponent> cellCounts;
+        positions.Allocate(totalPts);
+        connectivity.Allocate(totalPts);
+        cellCounts.Allocate(nSeeds);
+        auto histPortal = history.GetPortalConstControl();
+        auto posPortal = positions.GetPortalControl();
+        auto connPortal = connectivity.GetPortalControl();
+        auto cntPortal = cellCounts.GetPortalControl();
+
+        vtkm::Id idx = 0;
+        for (vtkm::Id i = 0; i < nSeeds; i++)
+        {
+            const vtkm::Id n = vtkm::Min(numPortal.Get(i), stride);
+            for (vtkm::Id j = 0; j < n; j++, idx++)
+            {
+                posPortal.Set(idx, histPortal.Get(i * stride + j));
+                connPortal.Set(idx, idx);
+            }
+            cntPortal.Set(i, static_cast<vtkm::IdComponent>(n));
+        }
+
+        vtkm::cont::ArrayHandle<vtkm::UInt8> cellTypes;
+        vtkm::cont::ArrayHandleConstant<vtkm::UInt8> polyLineShape(vtkm::CELL_SHAPE_POLY_LINE, nSeeds);
+        vtkm::cont::Algorithm::Copy(polyLineShape, cellTypes);
+
+        auto offsets = vtkm::cont::ConvertNumIndicesToOffsets(cellCounts);
+        result.polyLines.Fill(totalPts, cellTypes, connectivity, offsets);
+        result.positions = positions;
+    }
+
     int SeedPrep(const std::vector<vtkh::Particle> &particles,
                  vtkm::cont::ArrayHandle<vtkm::Vec<FieldType,3>> &seedArray,
                  vtkm::cont::ArrayHandle<vtkm::Id> &stepArray)
@@ -208,6 +526,15 @@ private:
     }
 
     FieldType stepSize;
+    vtkh::TerminationCriteria termCriteria;
+    vtkm::cont::ArrayHandle<vtkm::Id> statusArray;
+    vtkm::cont::ArrayHandle<vtkm::Id> reasonArray;
+    vtkm::cont::ArrayHandle<vtkm::Id> numPointsArray;
+    vtkm::cont::ArrayHandle<FieldType> arcLengthArray;
+    vtkm::cont::ArrayHandle<FieldType> timeArray;
+    bool temporal;
+    FieldType endTime;
+    TemporalRK4Type temporalRk4;
     GridEvalType gridEval;
     RK4Type rk4;
     FieldHandle vecField;
@@ -16,19 +16,25 @@ class Particle
 public:
     enum Status {ACTIVE, TERMINATE, OUTOFBOUNDS, WRONG_DOMAIN};
 
-    Particle() : coords(), id(-1), nSteps(0), status(ACTIVE), blockIds() {}
-    Particle(const std::vector<float> &c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds() {}
-    Particle(const std::vector<double> &c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds() {}
-    Particle(const double *c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds() {}
-    Particle(const float *c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds() {}
-    Particle(const vtkm::Vec<double,3> &c, int _id) : coords(c), id(_id), nSteps(0), status(ACTIVE), blockIds() {}
-    Particle(const vtkm::Vec<float,3> &c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds() {}
-    Particle(const Particle &p) : coords(p.coords), nSteps(p.nSteps), id(p.id), status(p.status), blockIds(p.blockIds) {}
+    Particle() : coords(), id(-1), nSteps(0), status(ACTIVE), blockIds(), arcLength(0), termReason(0), time(0) {}
+    Particle(const std::vector<float> &c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds(), arcLength(0), termReason(0), time(0) {}
+    Particle(const std::vector<double> &c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds(), arcLength(0), termReason(0), time(0) {}
+    Particle(const double *c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds(), arcLength(0), termReason(0), time(0) {}
+    Particle(const float *c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds(), arcLength(0), termReason(0), time(0) {}
+    Particle(const vtkm::Vec<double,3> &c, int _id) : coords(c), id(_id), nSteps(0), status(ACTIVE), blockIds(), arcLength(0), termReason(0), time(0) {}
+    Particle(const vtkm::Vec<float,3> &c, int _id) : coords(c[0],c[1],c[2]), id(_id), nSteps(0), status(ACTIVE), blockIds(), arcLength(0), termReason(0), time(0) {}
+    Particle(const Particle &p) : coords(p.coords), nSteps(p.nSteps), id(p.id), status(p.status), blockIds(p.blockIds), arcLength(p.arcLength), termReason(p.termReason), time(p.time) {}
 
     vtkm::Vec<double,3> coords;
     int id, nSteps;
     std::vector<int> blockIds;
     Status status;
+    // distance traveled so far and why the particle stopped
+    // (a TerminationCriteria::Reason)
+    double arcLength;
+    int termReason;
+    // simulation time of the particle, used by pathlines
+    double time;
 
     friend std::ostream &operator<<(std::ostream &os, const vtkh::Particle p)
     {
@@ -39,6 +45,7 @@ public:
         else if (p.status == Particle::TERMINATE) os<<"TERM";
         else if (p.status == Particle::OUTOFBOUNDS) os<<"OOB";
         else if (p.status == Particle::WRONG_DOMAIN) os<<"WRONG_DOMAIN";
+        if (p.termReason != 0) os<<" reason "<<p.termReason;
         os<<" bid = "<<p.blockIds;
         os<<")";
         return os;
@@ -57,6 +64,9 @@ struct Serialization<vtkh::Particle>
     vtkh::write(memstream, data.nSteps);
     vtkh::write(memstream, data.status);
     vtkh::write(memstream, data.blockIds);
+    vtkh::write(memstream, data.arcLength);
+    vtkh::write(memstream, data.termReason);
+    vtkh::write(memstream, data.time);
   }
 
   static void read(MemStream &memstream, vtkh::Particle &data)
@@ -68,6 +78,9 @@ struct Serialization<vtkh::Particle>
     vtkh::read(memstream, data.nSteps);
     vtkh::read(memstream, data.status);
     vtkh::read(memstream, data.blockIds);
+    vtkh::read(memstream, data.arcLength);
+    vtkh::read(memstream, data.termReason);
+    vtkh::read(memstream, data.time);
   }
 };
 } //namespace vtkh
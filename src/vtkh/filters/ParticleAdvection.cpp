@@ -52,7 +52,11 @@ ParticleAdvection::ParticleAdvection()
       useThreadedVersion(false),
       gatherTraces(true),
       dumpOutputFiles(false),
-      sleepUS(100)
+      sleepUS(100),
+      unsteady(false),
+      hasPrevious(false),
+      currentTime(0.),
+      previousTime(0.)
 {
 #ifdef VTKH_PARALLEL
   rank = vtkh::GetMPIRank();
@@ -71,7 +75,13 @@ void ParticleAdvection::PreExecute()
 {
   Filter::PreExecute();
 
+  if (unsteady && hasPrevious && currentTime <= previousTime)
+    throw Error("ParticleAdvection: pathline time must increase between executes");
+
   //Create the bounds map and dataBlocks list.
+  for (auto p : dataBlocks)
+    delete p;
+  dataBlocks.clear();
   boundsMap.Clear();
   const int nDoms = this->m_input->GetNumberOfDomains();
 
@@ -81,7 +91,17 @@ void ParticleAdvection::PreExecute()
     vtkm::cont::DataSet dom;
     this->m_input->GetDomain(i, dom, id);
 
-    dataBlocks.push_back(new DataBlockIntegrator(id, &dom, m_field_name, stepSize));
+    auto prev = previousDomains.find(id);
+    if (unsteady && hasPrevious)
+    {
+      if (prev == previousDomains.end())
+        throw Error("ParticleAdvection: domains changed between pathline executes");
+      dataBlocks.push_back(new DataBlockIntegrator(id, &prev->second, previousTime,
+                                                   &dom, currentTime,
+                                                   m_field_name, stepSize, termCriteria));
+    }
+    else
+      dataBlocks.push_back(new DataBlockIntegrator(id, &dom, m_field_name, stepSize, termCriteria));
     boundsMap.AddBlock(id, dom.GetCoordinateSystem().GetBounds());
   }
 
@@ -104,6 +124,7 @@ void ParticleAdvection::TraceMultiThread(std::vector<ResultT> &traces)
   task->Init(active, totalNumSeeds, sleepUS);
   task->Go();
   task->results.Get(traces);
+  task->terminated.Get(terminated);
 #endif
 }
 
@@ -217,7 +238,25 @@ void ParticleAdvection::TraceSeeds(std::vector<ResultT> &traces)
 void ParticleAdvection::DoExecute()
 {
   this->Init();
-  this->CreateSeeds();
+  if (unsteady && hasPrevious)
+  {
+    ResumePathlines();
+  }
+  else
+  {
+    this->CreateSeeds();
+    if (unsteady)
+    {
+      // nothing to advect until the next interval
+      for (auto &p : active)
+        p.time = currentTime;
+      pathlineParticles = active;
+      active.clear();
+      SavePathlineState();
+      this->m_output = new DataSet();
+      return;
+    }
+  }
 
   if(!gatherTraces)
   {
@@ -315,6 +354,73 @@ void ParticleAdvection::DoExecute()
             this->DumpSLOutput(NULL, rank, 0);
     }
   }
+
+  if (unsteady)
+    SavePathlineState();
+}
+
+void
+ParticleAdvection::ResumePathlines()
+{
+    active.clear();
+    inactive.clear();
+    terminated.clear();
+
+    for (auto &p : pathlineParticles)
+    {
+        p.status = Particle::ACTIVE;
+        p.termReason = TerminationCriteria::NOT_TERMINATED;
+        active.push_back(p);
+    }
+    pathlineParticles.clear();
+
+    totalNumSeeds = active.size();
+#ifdef VTKH_PARALLEL
+    MPI_Comm mpiComm = MPI_Comm_f2c(vtkh::GetMPICommHandle());
+    MPI_Allreduce(MPI_IN_PLACE, &totalNumSeeds, 1, MPI_INT, MPI_SUM, mpiComm);
+#endif
+}
+
+void
+ParticleAdvection::SavePathlineState()
+{
+    using FieldHandle = vtkm::cont::ArrayHandle<vtkm::Vec<vtkm::Float64, 3>>;
+
+    //Particles that reached the end of the interval continue next time.
+    std::vector<Particle> done;
+    for (auto &p : terminated)
+    {
+        if (p.termReason == TerminationCriteria::END_OF_INTERVAL)
+            pathlineParticles.push_back(p);
+        else
+            done.push_back(p);
+    }
+    terminated.swap(done);
+
+    //Keep a copy of the vector field. The mesh is shared with the
+    //simulation, only the field values are expected to change.
+    previousDomains.clear();
+    const int nDoms = this->m_input->GetNumberOfDomains();
+    for (int i = 0; i < nDoms; i++)
+    {
+        vtkm::Id id;
+        vtkm::cont::DataSet dom;
+        this->m_input->GetDomain(i, dom, id);
+
+        FieldHandle field;
+        vtkm::cont::Algorithm::Copy(dom.GetField(m_field_name).GetData().Cast<FieldHandle>(), field);
+
+        vtkm::cont::DataSet prev;
+        prev.AddCoordinateSystem(dom.GetCoordinateSystem());
+        prev.SetCellSet(dom.GetCellSet());
+        prev.AddField(vtkm::cont::Field(m_field_name,
+                                        vtkm::cont::Field::Association::POINTS,
+                                        field));
+        previousDomains[id] = prev;
+    }
+
+    previousTime = currentTime;
+    hasPrevious = true;
 }
 
 
@@ -14,6 +14,7 @@
 #include <vtkh/filters/Particle.hpp>
 #include <vtkh/filters/communication/BoundsMap.hpp>
 #include <vtkh/filters/Integrator.hpp>
+#include <vtkh/filters/TerminationCriteria.hpp>
 #include <vtkh/DataSet.hpp>
 
 #ifdef VTKH_PARALLEL
@@ -74,9 +75,34 @@ public:
 
   void SetField(const std::string &field_name) {m_field_name = field_name;}
   void SetStepSize(const double &v) { stepSize = v;}
+  // Step limit per particle. Step counts carry over between pathline
+  // executes, so in unsteady mode this caps a particle's whole lifetime,
+  // not each interval.
   void SetMaxSteps(const int &n) { maxSteps = n;}
   int  GetMaxSteps() const { return maxSteps; }
 
+  // Optional termination predicates evaluated per step during advection.
+  // Each one is off until set.
+  void SetMinimumSpeed(const double &v) { termCriteria.SetMinimumSpeed(v); }
+  void SetMaxArcLength(const double &v) { termCriteria.SetMaximumArcLength(v); }
+  void SetTargetRegion(const vtkm::Bounds &box) { termCriteria.SetTargetRegion(box); }
+  void SetTerminationCriteria(const TerminationCriteria &criteria) { termCriteria = criteria; }
+
+  // Pathline mode: each execute advects the particles kept from the
+  // previous execute across [previous time, time], interpolating between
+  // a copy of the previous vector field and the current one. The first
+  // execute only seeds. The output holds the pathline segments of the
+  // current interval. Particles still inside the domain end each execute
+  // exactly at 'time'.
+  void SetUnsteady(bool on) { unsteady = on; }
+  void SetTime(const double &t) { currentTime = t; }
+  // Particles still advecting that will resume on the next execute.
+  const std::vector<Particle>& GetPathlineParticles() const { return pathlineParticles; }
+
+  // Particles terminated on this rank during the last execute. Each
+  // particle records a TerminationCriteria::Reason in termReason.
+  const std::vector<Particle>& GetTerminatedParticles() const { return terminated; }
+
   DataBlockIntegrator * GetBlock(int blockId);
 
   template <typename ResultT>
@@ -94,6 +120,8 @@ protected:
 
   void Init();
   void CreateSeeds();
+  void ResumePathlines();
+  void SavePathlineState();
 
   template <typename ResultT>
   void TraceSeeds(std::vector<ResultT> &traces);
@@ -122,6 +150,14 @@ protected:
   vtkm::Vec<double,3> seedPoint;
 
   float stepSize;
+  TerminationCriteria termCriteria;
+
+  //pathline state kept between executes
+  bool unsteady;
+  bool hasPrevious;
+  double currentTime, previousTime;
+  std::map<vtkm::Id, vtkm::cont::DataSet> previousDomains;
+  std::vector<Particle> pathlineParticles;
 
   BoundsMap boundsMap;
   std::vector<DataBlockIntegrator*> dataBlocks;
@@ -140,10 +176,28 @@ protected:
 class DataBlockIntegrator
 {
 public:
-    DataBlockIntegrator(int _id, vtkm::cont::DataSet *_ds, const std::string &fieldName, float advectStep)
+    DataBlockIntegrator(int _id,
+                        vtkm::cont::DataSet *_ds,
+                        const std::string &fieldName,
+                        float advectStep,
+                        const TerminationCriteria &criteria = TerminationCriteria())
         : id(_id), ds(_ds),
           integrator(_ds, fieldName, advectStep)
     {
+        integrator.SetTerminationCriteria(criteria);
+    }
+    DataBlockIntegrator(int _id,
+                        vtkm::cont::DataSet *_prevDs,
+                        double prevTime,
+                        vtkm::cont::DataSet *_ds,
+                        double time,
+                        const std::string &fieldName,
+                        float advectStep,
+                        const TerminationCriteria &criteria = TerminationCriteria())
+        : id(_id), ds(_ds),
+          integrator(_prevDs, prevTime, _ds, time, fieldName, advectStep)
+    {
+        integrator.SetTerminationCriteria(criteria);
     }
     ~DataBlockIntegrator() {}
 
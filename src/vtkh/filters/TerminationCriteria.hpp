@@ -0,0 +1,101 @@
+#ifndef VTK_H_TERMINATION_CRITERIA_HPP
+#define VTK_H_TERMINATION_CRITERIA_HPP
+
+#include <vtkm/Bounds.h>
+#include <vtkm/Types.h>
+#include <vtkm/VectorAnalysis.h>
+
+namespace vtkh
+{
+
+//
+// Termination predicates that are evaluated per step inside the advection
+// worklet. Each predicate is disabled until it is given a value, so the
+// default criteria never terminate a particle early. The struct is plain
+// data so it can be copied straight into the execution environment.
+//
+class TerminationCriteria
+{
+public:
+  // Reasons a particle stopped. Values are stored per particle and
+  // are ordered so the first predicate that fires wins.
+  enum Reason
+  {
+    NOT_TERMINATED = 0,
+    MAX_STEPS,
+    STALLED,
+    REACHED_TARGET,
+    MAX_ARC_LENGTH,
+    // not a termination: the particle reached the end of the current
+    // time interval and resumes with the next one (pathlines)
+    END_OF_INTERVAL,
+    // the integrator failed to take a step inside the domain
+    FAILED
+  };
+
+  VTKM_EXEC_CONT
+  TerminationCriteria()
+    : m_min_speed(-1.),
+      m_max_arc_length(-1.),
+      m_use_target(false)
+  {
+  }
+
+  // stop particles whose speed over a step drops below 'speed'
+  VTKM_CONT void SetMinimumSpeed(const vtkm::Float64 &speed) { m_min_speed = speed; }
+  // stop particles once the traveled distance exceeds 'length'
+  VTKM_CONT void SetMaximumArcLength(const vtkm::Float64 &length) { m_max_arc_length = length; }
+  // stop particles that enter the box
+  VTKM_CONT void SetTargetRegion(const vtkm::Bounds &region)
+  {
+    m_target = region;
+    m_use_target = true;
+  }
+
+  VTKM_EXEC_CONT bool IsActive() const
+  {
+    return m_min_speed > 0. || m_max_arc_length > 0. || m_use_target;
+  }
+
+  //
+  // Evaluates all enabled predicates for a step from 'p0' to 'p1' taken
+  // with step size 'step_size'. 'arc_length' is the total distance traveled
+  // including this step.
+  //
+  template<typename T>
+  VTKM_EXEC_CONT vtkm::Id Evaluate(const vtkm::Vec<T,3> &p0,
+                                   const vtkm::Vec<T,3> &p1,
+                                   const T &step_size,
+                                   const T &arc_length) const
+  {
+    if(m_min_speed > 0. && step_size > 0)
+    {
+      const T speed = vtkm::Magnitude(p1 - p0) / step_size;
+      if(speed < m_min_speed)
+      {
+        return STALLED;
+      }
+    }
+
+    if(m_use_target && m_target.Contains(p1))
+    {
+      return REACHED_TARGET;
+    }
+
+    if(m_max_arc_length > 0. && arc_length >= m_max_arc_length)
+    {
+      return MAX_ARC_LENGTH;
+    }
+
+    return NOT_TERMINATED;
+  }
+
+protected:
+  vtkm::Float64 m_min_speed;
+  vtkm::Float64 m_max_arc_length;
+  vtkm::Bounds  m_target;
+  bool          m_use_target;
+};
+
+} //namespace vtkh
+#endif
@@ -0,0 +1,246 @@
+#include "CameraSweep.hpp"
+
+#include <vtkh/vtkh.hpp>
+#include <vtkh/Error.hpp>
+#include <vtkh/Logger.hpp>
+#include <vtkh/rendering/Scene.hpp>
+
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#ifdef VTKH_PARALLEL
+#include <mpi.h>
+#endif
+
+namespace vtkh
+{
+
+namespace detail
+{
+
+bool make_directory(const std::string &path)
+{
+#ifdef _WIN32
+  int res = _mkdir(path.c_str());
+#else
+  int res = mkdir(path.c_str(), 0755);
+#endif
+  return res == 0 || errno == EEXIST;
+}
+
+// rank 0 creates the directory and every rank learns the outcome, so
+// a failure throws everywhere instead of leaving the others waiting in
+// the first composite
+void make_output_directory(const std::string &path)
+{
+  int ok = 1;
+  if(vtkh::GetMPIRank() == 0)
+  {
+    ok = make_directory(path) ? 1 : 0;
+  }
+#ifdef VTKH_PARALLEL
+  MPI_Comm comm = MPI_Comm_f2c(vtkh::GetMPICommHandle());
+  MPI_Bcast(&ok, 1, MPI_INT, 0, comm);
+#endif
+  if(!ok)
+  {
+    throw Error("CameraSweep: could not create directory '" + path + "'");
+  }
+}
+
+// turns topology caching on for the sweep and restores the previous
+// settings however the sweep ends
+class CacheTopologyGuard
+{
+public:
+  CacheTopologyGuard(std::vector<vtkh::Renderer*> &renderers)
+    : m_renderers(renderers)
+  {
+    for(size_t i = 0; i < m_renderers.size(); ++i)
+    {
+      m_cache_topology.push_back(m_renderers[i]->GetCacheTopology());
+      m_renderers[i]->SetCacheTopology(true);
+    }
+  }
+
+  ~CacheTopologyGuard()
+  {
+    for(size_t i = 0; i < m_renderers.size(); ++i)
+    {
+      m_renderers[i]->SetCacheTopology(m_cache_topology[i]);
+    }
+  }
+private:
+  std::vector<vtkh::Renderer*> &m_renderers;
+  std::vector<bool>             m_cache_topology;
+};
+
+} // namespace detail
+
+CameraSweep::CameraSweep(vtkh::DataSet &data_set,
+                         const int num_phi,
+                         const int num_theta,
+                         const int width,
+                         const int height)
+  : m_path("cinema"),
+    m_num_phi(num_phi),
+    m_num_theta(num_theta),
+    m_chunk_size(64)
+{
+  if(num_phi < 1 || num_theta < 1)
+  {
+    throw Error("CameraSweep: phi and theta counts must be at least 1");
+  }
+  // the only collective call, every view reuses these bounds
+  vtkm::Bounds bounds = data_set.GetGlobalBounds();
+  m_template = vtkh::MakeRender(width,
+                                height,
+                                bounds,
+                                data_set.GetDomainIds(),
+                                "");
+}
+
+CameraSweep::~CameraSweep()
+{
+
+}
+
+void
+CameraSweep::SetOutputPath(const std::string &path)
+{
+  m_path = path;
+}
+
+void
+CameraSweep::SetBackgroundColor(float bg_color[4])
+{
+  m_template.SetBackgroundColor(bg_color);
+}
+
+void
+CameraSweep::SetForegroundColor(float fg_color[4])
+{
+  m_template.SetForegroundColor(fg_color);
+}
+
+void
+CameraSweep::SetChunkSize(const int chunk_size)
+{
+  if(chunk_size < 1)
+  {
+    throw Error("CameraSweep: chunk size must be at least 1");
+  }
+  m_chunk_size = chunk_size;
+}
+
+void
+CameraSweep::AddRenderer(vtkh::Renderer *renderer)
+{
+  m_renderers.push_back(renderer);
+}
+
+int
+CameraSweep::GetNumberOfRenders() const
+{
+  return m_num_phi * m_num_theta;
+}
+
+double
+CameraSweep::GetPhi(const int index) const
+{
+  const int phi = index / m_num_theta;
+  return -180. + 360. * phi / m_num_phi;
+}
+
+double
+CameraSweep::GetTheta(const int index) const
+{
+  // band centers keep the cameras off the poles, where up is undefined
+  const int theta = index % m_num_theta;
+  return -90. + 180. * (theta + 0.5) / m_num_theta;
+}
+
+std::string
+CameraSweep::GetImageName(const int index) const
+{
+  std::stringstream ss;
+  ss<<GetPhi(index)<<"_"<<GetTheta(index);
+  return ss.str();
+}
+
+vtkh::Render
+CameraSweep::GetRender(const int index) const
+{
+  assert(index >= 0 && index < GetNumberOfRenders());
+  vtkh::Render render = m_template;
+  vtkm::rendering::Camera camera = m_template.GetCamera();
+  camera.Azimuth(static_cast<vtkm::Float32>(GetPhi(index)));
+  camera.Elevation(static_cast<vtkm::Float32>(GetTheta(index)));
+  render.SetCamera(camera);
+  render.SetImageName(m_path + "/" + GetImageName(index));
+  return render;
+}
+
+void
+CameraSweep::Execute()
+{
+  if(m_renderers.size() == 0)
+  {
+    throw Error("CameraSweep: no renderers were added");
+  }
+
+  detail::make_output_directory(m_path);
+
+  detail::CacheTopologyGuard guard(m_renderers);
+
+  const int total = GetNumberOfRenders();
+  VTKH_DATA_OPEN("camera_sweep");
+  VTKH_DATA_ADD("renders", total);
+  for(int start = 0; start < total; start += m_chunk_size)
+  {
+    const int end = std::min(start + m_chunk_size, total);
+    vtkh::Scene scene;
+    for(int i = start; i < end; ++i)
+    {
+      vtkh::Render render = GetRender(i);
+      scene.AddRender(render);
+    }
+    for(size_t i = 0; i < m_renderers.size(); ++i)
+    {
+      scene.AddRenderer(m_renderers[i]);
+    }
+    scene.Render();
+  }
+  VTKH_DATA_CLOSE();
+
+  if(vtkh::GetMPIRank() == 0)
+  {
+    WriteIndex();
+  }
+}
+
+void
+CameraSweep::WriteIndex() const
+{
+  const std::string file_name = m_path + "/data.csv";
+  std::ofstream index(file_name.c_str());
+  if(!index.is_open())
+  {
+    throw Error("CameraSweep: could not write '" + file_name + "'");
+  }
+  index<<"phi,theta,FILE\n";
+  const int total = GetNumberOfRenders();
+  for(int i = 0; i < total; ++i)
+  {
+    index<<GetPhi(i)<<","<<GetTheta(i)<<","<<GetImageName(i)<<".png\n";
+  }
+}
+
+} // namespace vtkh
@@ -0,0 +1,62 @@
+#ifndef VTKH_CAMERA_SWEEP_HPP
+#define VTKH_CAMERA_SWEEP_HPP
+
+#include <string>
+#include <vector>
+#include <vtkh/vtkh_exports.h>
+#include <vtkh/DataSet.hpp>
+#include <vtkh/rendering/Render.hpp>
+#include <vtkh/rendering/Renderer.hpp>
+
+namespace vtkh
+{
+//
+// Renders a data set from a grid of cameras around it and writes a
+// Cinema (spec D) database: one png per view and a data.csv index with
+// the phi and theta of each image. Phi is the azimuth in [-180, 180)
+// and theta the elevation, centered in bands between the poles.
+//
+// Bounds and domains are looked up once and every render is a copy of
+// the same template, made only when its batch is about to be rendered.
+// Renderers keep their geometry for the whole sweep (see
+// Renderer::SetCacheTopology), so it is built once and not per batch.
+//
+class VTKH_API CameraSweep
+{
+public:
+  CameraSweep(vtkh::DataSet &data_set,
+              const int num_phi,
+              const int num_theta,
+              const int width,
+              const int height);
+  ~CameraSweep();
+
+  // directory the database is written to (default "cinema")
+  void                SetOutputPath(const std::string &path);
+  void                SetBackgroundColor(float bg_color[4]);
+  void                SetForegroundColor(float fg_color[4]);
+  // renders made per scene, the scene then batches them (default 64)
+  void                SetChunkSize(const int chunk_size);
+  void                AddRenderer(vtkh::Renderer *renderer);
+
+  int                 GetNumberOfRenders() const;
+  vtkh::Render        GetRender(const int index) const;
+  double              GetPhi(const int index) const;
+  double              GetTheta(const int index) const;
+  std::string         GetImageName(const int index) const;
+
+  // collective: renders every view, then rank 0 writes the index
+  void                Execute();
+protected:
+  void                WriteIndex() const;
+
+  vtkh::Render                  m_template;
+  std::vector<vtkh::Renderer*>  m_renderers;
+  std::string                   m_path;
+  int                           m_num_phi;
+  int                           m_num_theta;
+  int                           m_chunk_size;
+};
+
+} // namespace vtkh
+#endif
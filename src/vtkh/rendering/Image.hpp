@@ -6,6 +6,7 @@
 #include <vtkm/Bounds.h>
 
 #include <vtkh/vtkh_exports.h>
+#include <vtkh/utils/PixelKernels.hpp>
 
 namespace vtkh
 {
@@ -72,16 +73,13 @@ struct VTKH_API Image
       m_pixels.resize(size * 4);
       m_depths.resize(size);
 
+      PixelKernels::FloatToUChar(color_buffer, m_pixels.data(), size * 4);
+
 #ifdef VTKH_USE_OPENMP
       #pragma omp parallel for
 #endif
       for(int i = 0; i < size; ++i)
       {
-        const int offset = i * 4;
-        m_pixels[offset + 0] = static_cast<unsigned char>(color_buffer[offset + 0] * 255.f);
-        m_pixels[offset + 1] = static_cast<unsigned char>(color_buffer[offset + 1] * 255.f);
-        m_pixels[offset + 2] = static_cast<unsigned char>(color_buffer[offset + 2] * 255.f);
-        m_pixels[offset + 3] = static_cast<unsigned char>(color_buffer[offset + 3] * 255.f);
         float depth = depth_buffer[i];
         //make sure we can do a single comparison on depth
         depth = depth < 0 ? 2.f : depth;
@@ -133,19 +131,7 @@ struct VTKH_API Image
         bg_color[i] = static_cast<unsigned char>(color[i] * 255.f);
       }
 
-#ifdef VTKH_USE_OPENMP
-      #pragma omp parallel for
-#endif
-      for(int i = 0; i < size; ++i)
-      {
-        const int offset = i * 4;
-        unsigned int alpha = static_cast<unsigned int>(m_pixels[offset + 3]);
-        const float opacity = (255 - alpha);
-        m_pixels[offset + 0] += static_cast<unsigned char>(opacity * bg_color[0] / 255);
-        m_pixels[offset + 1] += static_cast<unsigned char>(opacity * bg_color[1] / 255);
-        m_pixels[offset + 2] += static_cast<unsigned char>(opacity * bg_color[2] / 255);
-        m_pixels[offset + 3] += static_cast<unsigned char>(opacity * bg_color[3] / 255);
-      }
+      PixelKernels::BlendBackground(m_pixels.data(), bg_color, size);
     }
     //
     // Fill this image with a sub-region of another image
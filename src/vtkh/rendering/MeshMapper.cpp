@@ -0,0 +1,324 @@
+#include "MeshMapper.hpp"
+#include "RayTracerMapper.hpp"
+
+#include <vtkh/vtkm_filters/vtkmPointAverage.hpp>
+
+#include <vtkm/cont/Algorithm.h>
+#include <vtkm/cont/CellSetExplicit.h>
+#include <vtkm/cont/CellSetStructured.h>
+#include <vtkm/exec/CellEdge.h>
+#include <vtkm/rendering/CanvasRayTracer.h>
+#include <vtkm/rendering/Wireframer.h>
+#include <vtkm/worklet/DispatcherMapTopology.h>
+#include <vtkm/worklet/ExternalFaces.h>
+#include <vtkm/worklet/ScatterCounted.h>
+#include <vtkm/worklet/WorkletMapTopology.h>
+
+namespace vtkh {
+
+namespace detail
+{
+
+class CountEdges : public vtkm::worklet::WorkletVisitCellsWithPoints
+{
+public:
+  typedef void ControlSignature(CellSetIn cellset, FieldOutCell num_edges);
+  typedef void ExecutionSignature(CellShape, PointCount, _2);
+
+  template<typename ShapeTag>
+  VTKM_EXEC void operator()(ShapeTag shape,
+                            const vtkm::IdComponent &num_points,
+                            vtkm::IdComponent &num_edges) const
+  {
+    num_edges = vtkm::exec::CellEdgeNumberOfEdges(num_points, shape, *this);
+  }
+};
+
+class EmitEdges : public vtkm::worklet::WorkletVisitCellsWithPoints
+{
+public:
+  typedef void ControlSignature(CellSetIn cellset, FieldOutCell edges);
+  typedef void ExecutionSignature(CellShape, PointIndices, VisitIndex, _2);
+  using ScatterType = vtkm::worklet::ScatterCounted;
+
+  template<typename ShapeTag, typename IndicesVecType>
+  VTKM_EXEC void operator()(ShapeTag shape,
+                            const IndicesVecType &indices,
+                            const vtkm::IdComponent &edge_index,
+                            vtkm::Id2 &edge) const
+  {
+    const vtkm::IdComponent num_points = indices.GetNumberOfComponents();
+    vtkm::Id p0 = indices[vtkm::exec::CellEdgeLocalIndex(num_points, 0, edge_index, shape, *this)];
+    vtkm::Id p1 = indices[vtkm::exec::CellEdgeLocalIndex(num_points, 1, edge_index, shape, *this)];
+    // order the end points so shared edges compare equal
+    edge = p0 < p1 ? vtkm::Id2(p0, p1) : vtkm::Id2(p1, p0);
+  }
+};
+
+struct MapFaceField
+{
+  vtkm::worklet::ExternalFaces &m_worklet;
+  vtkm::cont::VariantArrayHandle m_result;
+
+  MapFaceField(vtkm::worklet::ExternalFaces &worklet)
+    : m_worklet(worklet)
+  {}
+
+  template<typename T, typename S>
+  void operator()(const vtkm::cont::ArrayHandle<T,S> &array)
+  {
+    m_result = m_worklet.ProcessCellField(array);
+  }
+};
+
+} // namespace detail
+
+struct MeshMapper::Geometry
+{
+  bool                                       m_is_1d;
+  bool                                       m_has_faces;
+  // the external faces, or the input cells when showing internal zones
+  vtkm::cont::DynamicCellSet                 m_cells;
+  vtkm::worklet::ExternalFaces               m_faces_worklet;
+  vtkm::cont::ArrayHandle<vtkm::Id2>         m_edges;
+  // solid surface for the hidden line depth pass
+  std::shared_ptr<RayTracerMapper::Geometry> m_solid;
+};
+
+MeshMapper::MeshMapper()
+  : m_canvas(nullptr),
+    m_has_point_field(false),
+    m_show_internal(false),
+    m_is_overlay(false)
+{
+}
+
+MeshMapper::~MeshMapper()
+{
+}
+
+std::shared_ptr<MeshMapper::Geometry>
+MeshMapper::BuildGeometry(const vtkm::cont::DynamicCellSet &cellset,
+                          const vtkm::cont::CoordinateSystem &coords,
+                          bool show_internal)
+{
+  auto geometry = std::make_shared<Geometry>();
+  geometry->m_is_1d = cellset.IsSameType(vtkm::cont::CellSetStructured<1>());
+  geometry->m_has_faces = false;
+  geometry->m_cells = cellset;
+
+  if(geometry->m_is_1d)
+  {
+    // handled by the vtkm wireframer
+    return geometry;
+  }
+
+  if(!show_internal)
+  {
+    vtkm::cont::CellSetExplicit<> faces;
+    geometry->m_faces_worklet.SetPassPolyData(true);
+    if(cellset.IsSameType(vtkm::cont::CellSetStructured<3>()))
+    {
+      geometry->m_faces_worklet.Run(cellset.Cast<vtkm::cont::CellSetStructured<3>>(),
+                                    coords,
+                                    faces);
+    }
+    else
+    {
+      geometry->m_faces_worklet.Run(cellset, faces);
+    }
+    geometry->m_cells = faces;
+    geometry->m_has_faces = true;
+    geometry->m_solid = RayTracerMapper::BuildGeometry(geometry->m_cells, coords);
+  }
+
+  vtkm::cont::ArrayHandle<vtkm::IdComponent> edge_counts;
+  vtkm::worklet::DispatcherMapTopology<detail::CountEdges>().Invoke(geometry->m_cells,
+                                                                    edge_counts);
+
+  vtkm::worklet::ScatterCounted scatter(edge_counts);
+  vtkm::worklet::DispatcherMapTopology<detail::EmitEdges>(scatter).Invoke(geometry->m_cells,
+                                                                          geometry->m_edges);
+
+  vtkm::cont::Algorithm::Sort(geometry->m_edges);
+  vtkm::cont::Algorithm::Unique(geometry->m_edges);
+
+  return geometry;
+}
+
+void
+MeshMapper::SetGeometry(std::shared_ptr<Geometry> geometry)
+{
+  m_geometry = geometry;
+  m_has_point_field = false;
+}
+
+void
+MeshMapper::ClearGeometry()
+{
+  m_geometry.reset();
+  m_has_point_field = false;
+}
+
+bool
+MeshMapper::HasGeometry() const
+{
+  return m_geometry != nullptr;
+}
+
+void
+MeshMapper::SetShowInternalZones(bool on)
+{
+  m_show_internal = on;
+  m_wireframer.SetShowInternalZones(on);
+}
+
+void
+MeshMapper::SetIsOverlay(bool on)
+{
+  m_is_overlay = on;
+  m_wireframer.SetIsOverlay(on);
+}
+
+bool
+MeshMapper::GetShowInternalZones() const
+{
+  return m_show_internal;
+}
+
+bool
+MeshMapper::GetIsOverlay() const
+{
+  return m_is_overlay;
+}
+
+void
+MeshMapper::SetCanvas(vtkm::rendering::Canvas *canvas)
+{
+  m_canvas = canvas;
+  m_wireframer.SetCanvas(canvas);
+}
+
+vtkm::rendering::Canvas*
+MeshMapper::GetCanvas() const
+{
+  return m_canvas;
+}
+
+void
+MeshMapper::RenderCells(const vtkm::cont::DynamicCellSet &cellset,
+                        const vtkm::cont::CoordinateSystem &coords,
+                        const vtkm::cont::Field &scalar_field,
+                        const vtkm::cont::ColorTable &color_table,
+                        const vtkm::rendering::Camera &camera,
+                        const vtkm::Range &scalar_range)
+{
+  // geometry built here (and the point field cached with it) is only
+  // for this call, so a later call with another cell set starts over
+  const bool own_geometry = !HasGeometry();
+  if(own_geometry)
+  {
+    SetGeometry(BuildGeometry(cellset, coords, m_show_internal));
+  }
+
+  if(m_geometry->m_is_1d)
+  {
+    m_wireframer.SetActiveColorTable(color_table);
+    m_wireframer.RenderCells(cellset, coords, scalar_field, color_table, camera, scalar_range);
+    if(own_geometry)
+    {
+      ClearGeometry();
+    }
+    return;
+  }
+
+  // only the field needs to follow the cached faces
+  vtkm::cont::Field field = scalar_field;
+  if(m_geometry->m_has_faces &&
+     scalar_field.GetAssociation() == vtkm::cont::Field::Association::CELL_SET)
+  {
+    detail::MapFaceField mapper(m_geometry->m_faces_worklet);
+    scalar_field.GetData().ResetTypes(vtkm::TypeListTagFieldScalar()).CastAndCall(mapper);
+    field = vtkm::cont::Field(scalar_field.GetName(),
+                              vtkm::cont::Field::Association::CELL_SET,
+                              mapper.m_result);
+  }
+
+  // the wireframer colors edges by their end points, so a cell field
+  // has to be averaged onto the points first. That is done for the
+  // first camera and reused for the rest of the domain's cameras
+  vtkm::cont::Field edge_field = scalar_field;
+  if(scalar_field.GetAssociation() == vtkm::cont::Field::Association::CELL_SET &&
+     m_has_point_field && m_point_field.GetName() == scalar_field.GetName())
+  {
+    edge_field = m_point_field;
+  }
+  else if(scalar_field.GetAssociation() == vtkm::cont::Field::Association::CELL_SET)
+  {
+    vtkm::cont::DataSet domain;
+    domain.SetCellSet(cellset);
+    domain.AddCoordinateSystem(coords);
+    domain.AddField(scalar_field);
+
+    vtkh::vtkmPointAverage average;
+    vtkm::cont::DataSet averaged = average.Run(domain,
+                                               scalar_field.GetName(),
+                                               scalar_field.GetName(),
+                                               vtkm::filter::FieldSelection());
+    edge_field = averaged.GetField(scalar_field.GetName());
+    m_point_field = edge_field;
+    m_has_point_field = true;
+  }
+
+  vtkm::rendering::Wireframer renderer(m_canvas, m_show_internal, m_is_overlay);
+
+  const bool render_depth = !m_show_internal && !m_is_overlay;
+  // keep the depth canvas alive until the edges are rendered
+  std::shared_ptr<vtkm::rendering::CanvasRayTracer> depth_canvas;
+  if(render_depth)
+  {
+    depth_canvas = std::make_shared<vtkm::rendering::CanvasRayTracer>(m_canvas->GetWidth(),
+                                                                      m_canvas->GetHeight());
+    depth_canvas->SetBackgroundColor(vtkm::rendering::Color::white);
+    depth_canvas->Initialize();
+    depth_canvas->Activate();
+    depth_canvas->Clear();
+
+    RayTracerMapper tracer;
+    tracer.SetGeometry(m_geometry->m_solid);
+    tracer.SetCanvas(depth_canvas.get());
+    tracer.SetActiveColorTable(color_table);
+    tracer.RenderCells(m_geometry->m_cells, coords, field, color_table, camera, scalar_range);
+    renderer.SetSolidDepthBuffer(depth_canvas->GetDepthBuffer());
+  }
+
+  renderer.SetCamera(camera);
+  renderer.SetColorMap(this->ColorMap);
+  renderer.SetData(coords, m_geometry->m_edges, edge_field, scalar_range);
+  renderer.Render();
+
+  if(own_geometry)
+  {
+    ClearGeometry();
+  }
+}
+
+void
+MeshMapper::StartScene()
+{
+  // nothing needs to be done
+}
+
+void
+MeshMapper::EndScene()
+{
+  // nothing needs to be done
+}
+
+vtkm::rendering::Mapper*
+MeshMapper::NewCopy() const
+{
+  return new MeshMapper(*this);
+}
+
+} // namespace vtkh
@@ -0,0 +1,67 @@
+#ifndef VTK_H_MESH_MAPPER_HPP
+#define VTK_H_MESH_MAPPER_HPP
+
+#include <memory>
+#include <vtkh/vtkh_exports.h>
+
+#include <vtkm/rendering/Mapper.h>
+#include <vtkm/rendering/MapperWireframer.h>
+
+namespace vtkh {
+
+//
+// Wireframe mapper that keeps the view independent work (external faces,
+// unique edges and the bvh used for the hidden line depth pass) in a
+// shared Geometry object, so it can be built once and reused for every
+// camera and, with the TopologyCache, across cycles. 1D cell sets are
+// handed to vtkm::rendering::MapperWireframer.
+//
+class VTKH_API MeshMapper : public vtkm::rendering::Mapper
+{
+public:
+  struct Geometry;
+
+  MeshMapper();
+  virtual ~MeshMapper();
+
+  static std::shared_ptr<Geometry> BuildGeometry(const vtkm::cont::DynamicCellSet &cellset,
+                                                 const vtkm::cont::CoordinateSystem &coords,
+                                                 bool show_internal);
+
+  void SetGeometry(std::shared_ptr<Geometry> geometry);
+  void ClearGeometry();
+  bool HasGeometry() const;
+
+  void SetShowInternalZones(bool on);
+  void SetIsOverlay(bool on);
+  bool GetShowInternalZones() const;
+  bool GetIsOverlay() const;
+
+  void SetCanvas(vtkm::rendering::Canvas *canvas) override;
+  vtkm::rendering::Canvas* GetCanvas() const override;
+
+  void RenderCells(const vtkm::cont::DynamicCellSet &cellset,
+                   const vtkm::cont::CoordinateSystem &coords,
+                   const vtkm::cont::Field &scalar_field,
+                   const vtkm::cont::ColorTable &color_table,
+                   const vtkm::rendering::Camera &camera,
+                   const vtkm::Range &scalar_range) override;
+
+  void StartScene() override;
+  void EndScene() override;
+
+  vtkm::rendering::Mapper* NewCopy() const override;
+protected:
+  vtkm::rendering::Canvas          *m_canvas;
+  vtkm::rendering::MapperWireframer m_wireframer;
+  std::shared_ptr<Geometry>         m_geometry;
+  // a cell field averaged onto the points, kept until the geometry
+  // (i.e. the domain) changes
+  vtkm::cont::Field                 m_point_field;
+  bool                              m_has_point_field;
+  bool                              m_show_internal;
+  bool                              m_is_overlay;
+};
+
+} // namespace vtkh
+#endif
@@ -1,7 +1,8 @@
 #include "MeshRenderer.hpp"
+#include "MeshMapper.hpp"
+#include "TopologyCache.hpp"
 
 #include <vtkm/rendering/CanvasRayTracer.h>
-#include <vtkm/rendering/MapperWireframer.h>
 #include <memory>
 
 namespace vtkh {
@@ -11,7 +12,7 @@ MeshRenderer::MeshRenderer()
     m_show_internal(false),
     m_use_foreground_color(false)
 {
-  typedef vtkm::rendering::MapperWireframer MapperType;
+  typedef vtkh::MeshMapper MapperType;
   auto mapper = std::make_shared<MapperType>();
   this->m_mapper = mapper;
 }
@@ -25,7 +26,7 @@ MeshRenderer::PreExecute()
 {
   Renderer::PreExecute();
 
-  typedef vtkm::rendering::MapperWireframer MapperType;
+  typedef vtkh::MeshMapper MapperType;
   std::shared_ptr<MapperType> mesh_mapper = 
     std::dynamic_pointer_cast<MapperType>(this->m_mapper);
 
@@ -48,6 +49,40 @@ MeshRenderer::PreExecute()
   }
 }
 
+void
+MeshRenderer::SetDomainGeometry(const vtkm::Id &domain_id,
+                                const vtkm::cont::DynamicCellSet &cellset,
+                                const vtkm::cont::CoordinateSystem &coords)
+{
+  typedef vtkh::MeshMapper MapperType;
+  // the faces and edges depend on whether internal zones are shown
+  std::string key = m_cache_owner + (m_show_internal ? "internal" : "");
+
+  std::shared_ptr<MapperType::Geometry> geometry;
+  if(m_cache_topology)
+  {
+    geometry = TopologyCache::Find<MapperType::Geometry>(key, domain_id, cellset, coords);
+  }
+
+  if(geometry == nullptr)
+  {
+    geometry = MapperType::BuildGeometry(cellset, coords, m_show_internal);
+    if(m_cache_topology)
+    {
+      TopologyCache::Insert(key, domain_id, cellset, coords, geometry);
+    }
+  }
+
+  std::static_pointer_cast<MapperType>(this->m_mapper)->SetGeometry(geometry);
+}
+
+void
+MeshRenderer::ClearDomainGeometry(const vtkm::Id &vtkmNotUsed(domain_id))
+{
+  typedef vtkh::MeshMapper MapperType;
+  std::static_pointer_cast<MapperType>(this->m_mapper)->ClearGeometry();
+}
+
 void
 MeshRenderer::SetIsOverlay(bool on)
 {
@@ -21,6 +21,10 @@ public:
   bool GetShowInternal() const;
 protected:
   void PreExecute() override;
+  void SetDomainGeometry(const vtkm::Id &domain_id,
+                         const vtkm::cont::DynamicCellSet &cellset,
+                         const vtkm::cont::CoordinateSystem &coords) override;
+  void ClearDomainGeometry(const vtkm::Id &domain_id) override;
   bool m_use_foreground_color;
   bool m_is_overlay;
   bool m_show_internal;
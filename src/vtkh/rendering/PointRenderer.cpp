@@ -1,17 +1,160 @@
 #include "PointRenderer.hpp"
 
+#include <vtkh/Logger.hpp>
+#include <vtkm/Math.h>
+#include <vtkm/cont/ArrayCopy.h>
+#include <vtkm/cont/ArrayHandleIndex.h>
+#include <vtkm/cont/ArrayHandlePermutation.h>
+#include <vtkm/cont/CellSetSingleType.h>
 #include <vtkm/rendering/CanvasRayTracer.h>
 #include <vtkm/rendering/MapperPoint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <memory>
+#include <unordered_set>
 
 namespace vtkh {
-  
+
+namespace detail
+{
+
+struct DecimatedPoints
+{
+  bool                           m_decimated;
+  vtkm::cont::DynamicCellSet     m_cellset;
+  vtkm::cont::CoordinateSystem   m_coords;
+  vtkm::cont::Field              m_field;
+};
+
+//
+// A pixel at distance d covers 2 d tan(fov / 2) / (height * zoom) of
+// world space. The voxel diagonal is kept under pixel_error of those at
+// the nearest point of the domain, so the bound holds for every point.
+// Returns 0 when the camera is inside the domain or in 2d mode.
+//
+vtkm::Float64 voxel_size(const vtkm::rendering::Camera &camera,
+                         const vtkm::Bounds &bounds,
+                         const int height,
+                         const vtkm::Float32 pixel_error)
+{
+  if(camera.GetMode() != vtkm::rendering::Camera::MODE_3D)
+  {
+    return 0.;
+  }
+  const vtkm::Vec<vtkm::Float32,3> pos = camera.GetPosition();
+  const vtkm::Range *ranges[3] = {&bounds.X, &bounds.Y, &bounds.Z};
+  vtkm::Float64 dist2 = 0.;
+  for(int i = 0; i < 3; ++i)
+  {
+    const vtkm::Float64 d = std::max(std::max(ranges[i]->Min - pos[i], pos[i] - ranges[i]->Max), 0.);
+    dist2 += d * d;
+  }
+  const vtkm::Float64 fov = camera.GetFieldOfView() * vtkm::Pi() / 180.;
+  const vtkm::Float64 footprint = 2. * std::sqrt(dist2) * std::tan(fov * 0.5) /
+                                  (vtkm::Float64(height) * camera.GetZoom());
+  return pixel_error * footprint / std::sqrt(3.);
+}
+
+struct PermuteField
+{
+  vtkm::cont::ArrayHandle<vtkm::Id> m_ids;
+  std::string m_name;
+  vtkm::cont::Field m_result;
+
+  template<typename T, typename S>
+  void operator()(const vtkm::cont::ArrayHandle<T,S> &array)
+  {
+    vtkm::cont::ArrayHandle<T> values;
+    vtkm::cont::ArrayCopy(vtkm::cont::make_ArrayHandlePermutation(m_ids, array), values);
+    m_result = vtkm::cont::Field(m_name, vtkm::cont::Field::Association::POINTS, values);
+  }
+};
+
+// keeps the first point, in input order, of every occupied voxel
+DecimatedPoints decimate(const vtkm::cont::CoordinateSystem &coords,
+                         const vtkm::cont::Field &field,
+                         const vtkm::Bounds &bounds,
+                         const vtkm::Float64 voxel)
+{
+  DecimatedPoints res;
+  res.m_decimated = false;
+
+  // voxel indices are packed into 21 bits per axis
+  const vtkm::Id max_dim = vtkm::Id(1) << 21;
+  const vtkm::Float64 origin[3] = {bounds.X.Min, bounds.Y.Min, bounds.Z.Min};
+  const vtkm::Float64 extent[3] = {bounds.X.Length(), bounds.Y.Length(), bounds.Z.Length()};
+  vtkm::Id dims[3];
+  for(int i = 0; i < 3; ++i)
+  {
+    dims[i] = static_cast<vtkm::Id>(extent[i] / voxel) + 1;
+    if(dims[i] >= max_dim)
+    {
+      return res;
+    }
+  }
+
+  auto portal = coords.GetData().GetPortalConstControl();
+  const vtkm::Id size = portal.GetNumberOfValues();
+  std::unordered_set<vtkm::UInt64> occupied;
+  std::vector<vtkm::Id> ids;
+  for(vtkm::Id i = 0; i < size; ++i)
+  {
+    const vtkm::Vec3f point = portal.Get(i);
+    vtkm::UInt64 key = 0;
+    for(int d = 0; d < 3; ++d)
+    {
+      vtkm::Id index = static_cast<vtkm::Id>((point[d] - origin[d]) / voxel);
+      index = std::min(std::max(index, vtkm::Id(0)), dims[d] - 1);
+      key = (key << 21) | static_cast<vtkm::UInt64>(index);
+    }
+    if(occupied.insert(key).second)
+    {
+      ids.push_back(i);
+    }
+  }
+
+  const vtkm::Id num_points = static_cast<vtkm::Id>(ids.size());
+  if(num_points == size)
+  {
+    return res;
+  }
+
+  vtkm::cont::ArrayHandle<vtkm::Id> id_array;
+  vtkm::cont::ArrayCopy(vtkm::cont::make_ArrayHandle(ids), id_array);
+
+  vtkm::cont::ArrayHandle<vtkm::Vec3f> points;
+  vtkm::cont::ArrayCopy(vtkm::cont::make_ArrayHandlePermutation(id_array, coords.GetData()), points);
+  res.m_coords = vtkm::cont::CoordinateSystem(coords.GetName(), points);
+
+  PermuteField permute;
+  permute.m_ids = id_array;
+  permute.m_name = field.GetName();
+  field.GetData().ResetTypes(vtkm::TypeListTagFieldScalar()).CastAndCall(permute);
+  res.m_field = permute.m_result;
+
+  vtkm::cont::ArrayHandle<vtkm::Id> conn;
+  vtkm::cont::ArrayCopy(vtkm::cont::ArrayHandleIndex(num_points), conn);
+  vtkm::cont::CellSetSingleType<> cellset;
+  cellset.Fill(num_points, vtkm::CELL_SHAPE_VERTEX, 1, conn);
+  res.m_cellset = cellset;
+
+  res.m_decimated = true;
+  return res;
+}
+
+} // namespace detail
+
+
 PointRenderer::PointRenderer()
   : m_use_nodes(true),
     m_radius_set(false),
     m_use_variable_radius(false),
     m_base_radius(0.5f),
-    m_delta_radius(0.5f)
+    m_delta_radius(0.5f),
+    m_lod(false),
+    m_lod_error(1.f)
 {
   typedef vtkm::rendering::MapperPoint TracerType;
   auto mapper = std::make_shared<TracerType>();
@@ -66,6 +209,99 @@ PointRenderer::SetRadiusDelta(vtkm::Float32 delta)
   m_delta_radius = delta;
 }
 
+void
+PointRenderer::SetLevelOfDetail(bool on, vtkm::Float32 pixel_error)
+{
+  if(pixel_error <= 0.f)
+  {
+    throw Error("PointRenderer: level of detail error must be positive");
+  }
+  m_lod = on;
+  m_lod_error = pixel_error;
+}
+
+void
+PointRenderer::RenderDomain(const vtkm::Id &domain_id,
+                            const vtkm::cont::DynamicCellSet &cellset,
+                            const vtkm::cont::CoordinateSystem &coords,
+                            const vtkm::cont::Field &field)
+{
+  if(!m_lod ||
+     !m_use_nodes ||
+     field.GetAssociation() != vtkm::cont::Field::Association::POINTS)
+  {
+    Renderer::RenderDomain(domain_id, cellset, coords, field);
+    return;
+  }
+
+  //
+  // Voxel sizes are rounded down to a power of two, so cameras at a
+  // similar distance (e.g. a cinema sweep) share one clustering. The
+  // clusterings are kept for every render of the batch.
+  //
+  const vtkm::Bounds bounds = coords.GetBounds();
+  std::map<int, detail::DecimatedPoints> levels;
+  int total_renders = static_cast<int>(m_renders.size());
+  for(int i = 0; i < total_renders; ++i)
+  {
+    this->SetShadingOn(m_renders[i].GetShadingOn());
+    m_mapper->SetActiveColorTable(m_color_table);
+
+    vtkmCanvasPtr p_canvas = m_renders[i].GetDomainCanvas(domain_id);
+    const vtkmCamera &camera = m_renders[i].GetCamera();
+    m_mapper->SetCanvas(&(*p_canvas));
+
+    const vtkm::Float64 voxel = detail::voxel_size(camera,
+                                                   bounds,
+                                                   m_renders[i].GetHeight(),
+                                                   m_lod_error);
+    const detail::DecimatedPoints *points = nullptr;
+    if(voxel > 0.)
+    {
+      const int level = static_cast<int>(std::floor(std::log2(voxel)));
+      auto it = levels.find(level);
+      if(it == levels.end())
+      {
+        detail::DecimatedPoints decimated = detail::decimate(coords,
+                                                             field,
+                                                             bounds,
+                                                             std::ldexp(1., level));
+        it = levels.insert(std::make_pair(level, decimated)).first;
+      }
+      points = &it->second;
+    }
+
+    if(points != nullptr && points->m_decimated)
+    {
+      m_mapper->RenderCells(points->m_cellset,
+                            points->m_coords,
+                            points->m_field,
+                            m_color_table,
+                            camera,
+                            m_range);
+    }
+    else
+    {
+      m_mapper->RenderCells(cellset,
+                            coords,
+                            field,
+                            m_color_table,
+                            camera,
+                            m_range);
+    }
+  }
+
+  vtkm::Id lod_points = 0;
+  for(auto it = levels.begin(); it != levels.end(); ++it)
+  {
+    lod_points += it->second.m_decimated
+                ? it->second.m_coords.GetNumberOfPoints()
+                : coords.GetNumberOfPoints();
+  }
+  VTKH_DATA_ADD("lod_levels", levels.size());
+  VTKH_DATA_ADD("lod_points", lod_points);
+}
+
 void
 PointRenderer::PreExecute()
 {
@@ -19,12 +19,25 @@ public:
   void UseVariableRadius(bool useVariableRadius);
   void SetBaseRadius(vtkm::Float32 radius);
   void SetRadiusDelta(vtkm::Float32 delta);
+  // render one point per cell of a voxel grid sized from the pixel
+  // footprint of the domain's nearest point, so points that share a
+  // pixel are not all traced. No dropped point is more than pixel_error
+  // pixels from the point drawn in its place. Meant for point meshes
+  // (DataSet::IsPointMesh) rendered with nodes and a point field
+  void SetLevelOfDetail(bool on, vtkm::Float32 pixel_error = 1.f);
+protected:
+  void RenderDomain(const vtkm::Id &domain_id,
+                    const vtkm::cont::DynamicCellSet &cellset,
+                    const vtkm::cont::CoordinateSystem &coords,
+                    const vtkm::cont::Field &field) override;
 private:
   bool m_use_nodes;
   bool m_radius_set;
   bool m_use_variable_radius;
   vtkm::Float32 m_base_radius;
   vtkm::Float32 m_delta_radius;
+  bool m_lod;
+  vtkm::Float32 m_lod_error;
 
 };
 
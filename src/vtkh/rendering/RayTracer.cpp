@@ -1,14 +1,16 @@
 #include "RayTracer.hpp"
+#include "RayTracerMapper.hpp"
+#include "TopologyCache.hpp"
 
 #include <vtkm/rendering/CanvasRayTracer.h>
-#include <vtkm/rendering/MapperRayTracer.h>
 #include <memory>
 
 namespace vtkh {
   
 RayTracer::RayTracer()
+  : m_batch_cameras(false)
 {
-  typedef vtkm::rendering::MapperRayTracer TracerType;
+  typedef vtkh::RayTracerMapper TracerType;
   auto mapper = std::make_shared<TracerType>();
   mapper->SetCompositeBackground(false);
   this->m_mapper = mapper;
@@ -34,8 +36,75 @@ void
 RayTracer::SetShadingOn(bool on)
 {
   // do nothing by default;
-  typedef vtkm::rendering::MapperRayTracer TracerType;
+  typedef vtkh::RayTracerMapper TracerType;
   std::static_pointer_cast<TracerType>(this->m_mapper)->SetShadingOn(on);
 }
 
+void
+RayTracer::SetBatchCameras(bool on)
+{
+  m_batch_cameras = on;
+}
+
+void
+RayTracer::SetDomainGeometry(const vtkm::Id &domain_id,
+                             const vtkm::cont::DynamicCellSet &cellset,
+                             const vtkm::cont::CoordinateSystem &coords)
+{
+  // build the bvh once and trace every camera in the batch against it
+  typedef vtkh::RayTracerMapper TracerType;
+  std::shared_ptr<TracerType::Geometry> geometry;
+  if(m_cache_topology)
+  {
+    geometry = TopologyCache::Find<TracerType::Geometry>(m_cache_owner, domain_id, cellset, coords);
+  }
+
+  if(geometry == nullptr)
+  {
+    geometry = TracerType::BuildGeometry(cellset, coords);
+    if(m_cache_topology)
+    {
+      TopologyCache::Insert(m_cache_owner, domain_id, cellset, coords, geometry);
+    }
+  }
+
+  std::static_pointer_cast<TracerType>(this->m_mapper)->SetGeometry(geometry);
+}
+
+void
+RayTracer::ClearDomainGeometry(const vtkm::Id &vtkmNotUsed(domain_id))
+{
+  typedef vtkh::RayTracerMapper TracerType;
+  std::static_pointer_cast<TracerType>(this->m_mapper)->ClearGeometry();
+}
+
+void
+RayTracer::RenderDomain(const vtkm::Id &domain_id,
+                        const vtkm::cont::DynamicCellSet &cellset,
+                        const vtkm::cont::CoordinateSystem &coords,
+                        const vtkm::cont::Field &field)
+{
+  const int total_renders = static_cast<int>(m_renders.size());
+  if(!m_batch_cameras || total_renders < 2)
+  {
+    Renderer::RenderDomain(domain_id, cellset, coords, field);
+    return;
+  }
+
+  std::vector<vtkm::rendering::Camera> cameras;
+  std::vector<vtkm::rendering::Canvas*> canvases;
+  std::vector<bool> shading;
+  for(int i = 0; i < total_renders; ++i)
+  {
+    cameras.push_back(m_renders[i].GetCamera());
+    canvases.push_back(m_renders[i].GetDomainCanvas(domain_id).get());
+    shading.push_back(m_renders[i].GetShadingOn());
+  }
+
+  typedef vtkh::RayTracerMapper TracerType;
+  auto tracer = std::static_pointer_cast<TracerType>(this->m_mapper);
+  tracer->SetActiveColorTable(m_color_table);
+  tracer->RenderCellsBatched(cameras, canvases, shading, field, m_range);
+}
+
 } // namespace vtkh
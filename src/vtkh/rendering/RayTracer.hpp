@@ -13,7 +13,20 @@ public:
   virtual ~RayTracer();
   std::string GetName() const override;
   void SetShadingOn(bool on) override;
+  // trace all cameras of a batch in a single launch per domain
+  void SetBatchCameras(bool on);
   static Renderer::vtkmCanvasPtr GetNewCanvas(int width = 1024, int height = 1024);
+protected:
+  void SetDomainGeometry(const vtkm::Id &domain_id,
+                         const vtkm::cont::DynamicCellSet &cellset,
+                         const vtkm::cont::CoordinateSystem &coords) override;
+  void ClearDomainGeometry(const vtkm::Id &domain_id) override;
+  void RenderDomain(const vtkm::Id &domain_id,
+                    const vtkm::cont::DynamicCellSet &cellset,
+                    const vtkm::cont::CoordinateSystem &coords,
+                    const vtkm::cont::Field &field) override;
+
+  bool m_batch_cameras;
 };
 
 } // namespace vtkh
@@ -0,0 +1,494 @@
+#include "RayTracerMapper.hpp"
+
+#include <vtkh/Error.hpp>
+
+#include <vtkm/VectorAnalysis.h>
+#include <vtkm/cont/Algorithm.h>
+#include <vtkm/cont/ArrayHandleConstant.h>
+#include <vtkm/rendering/raytracing/Logger.h>
+#include <vtkm/rendering/raytracing/RayOperations.h>
+#include <vtkm/rendering/raytracing/TriangleExtractor.h>
+#include <vtkm/rendering/raytracing/TriangleIntersector.h>
+#include <vtkm/worklet/DispatcherMapField.h>
+#include <vtkm/worklet/WorkletMapField.h>
+
+namespace vtkh {
+
+namespace detail
+{
+
+typedef vtkm::rendering::raytracing::Ray<vtkm::Float32> RayType;
+
+// copies 'count' rays starting at 'src_offset' into 'dst' at 'dst_offset'
+void copy_rays(const RayType &src,
+               const vtkm::Id &src_offset,
+               RayType &dst,
+               const vtkm::Id &dst_offset,
+               const vtkm::Id &count)
+{
+  using vtkm::cont::Algorithm;
+  Algorithm::CopySubRange(src.IntersectionX, src_offset, count, dst.IntersectionX, dst_offset);
+  Algorithm::CopySubRange(src.IntersectionY, src_offset, count, dst.IntersectionY, dst_offset);
+  Algorithm::CopySubRange(src.IntersectionZ, src_offset, count, dst.IntersectionZ, dst_offset);
+  Algorithm::CopySubRange(src.OriginX, src_offset, count, dst.OriginX, dst_offset);
+  Algorithm::CopySubRange(src.OriginY, src_offset, count, dst.OriginY, dst_offset);
+  Algorithm::CopySubRange(src.OriginZ, src_offset, count, dst.OriginZ, dst_offset);
+  Algorithm::CopySubRange(src.DirX, src_offset, count, dst.DirX, dst_offset);
+  Algorithm::CopySubRange(src.DirY, src_offset, count, dst.DirY, dst_offset);
+  Algorithm::CopySubRange(src.DirZ, src_offset, count, dst.DirZ, dst_offset);
+  Algorithm::CopySubRange(src.NormalX, src_offset, count, dst.NormalX, dst_offset);
+  Algorithm::CopySubRange(src.NormalY, src_offset, count, dst.NormalY, dst_offset);
+  Algorithm::CopySubRange(src.NormalZ, src_offset, count, dst.NormalZ, dst_offset);
+  Algorithm::CopySubRange(src.U, src_offset, count, dst.U, dst_offset);
+  Algorithm::CopySubRange(src.V, src_offset, count, dst.V, dst_offset);
+  Algorithm::CopySubRange(src.Scalar, src_offset, count, dst.Scalar, dst_offset);
+  Algorithm::CopySubRange(src.Distance, src_offset, count, dst.Distance, dst_offset);
+  Algorithm::CopySubRange(src.MinDistance, src_offset, count, dst.MinDistance, dst_offset);
+  Algorithm::CopySubRange(src.MaxDistance, src_offset, count, dst.MaxDistance, dst_offset);
+  Algorithm::CopySubRange(src.HitIdx, src_offset, count, dst.HitIdx, dst_offset);
+  Algorithm::CopySubRange(src.PixelIdx, src_offset, count, dst.PixelIdx, dst_offset);
+  Algorithm::CopySubRange(src.Status, src_offset, count, dst.Status, dst_offset);
+  // rgba color buffer
+  Algorithm::CopySubRange(src.Buffers.at(0).Buffer,
+                          src_offset * 4,
+                          count * 4,
+                          dst.Buffers.at(0).Buffer,
+                          dst_offset * 4);
+}
+
+//
+// The batched trace colors rays without lighting, since the tracer only
+// knows about one camera. This is the vtkm ray tracer's surface shading
+// term for term: the color is scaled by min(ka + kd cos + ks spec, 1)
+// with the light just above each ray's camera.
+//
+class HeadlightShade : public vtkm::worklet::WorkletMapField
+{
+protected:
+  vtkm::Float32 m_ambient;
+  vtkm::Float32 m_diffuse;
+  vtkm::Float32 m_specular;
+  vtkm::Float32 m_specular_exponent;
+public:
+  VTKM_CONT
+  HeadlightShade()
+    : m_ambient(.5f),
+      m_diffuse(.7f),
+      m_specular(.7f),
+      m_specular_exponent(20.f)
+  {}
+
+  typedef void ControlSignature(FieldIn,
+                                FieldIn,
+                                FieldIn,
+                                FieldIn,
+                                FieldIn,
+                                FieldIn,
+                                FieldIn,
+                                FieldIn,
+                                WholeArrayIn,
+                                WholeArrayIn,
+                                WholeArrayIn,
+                                WholeArrayIn,
+                                WholeArrayInOut);
+  typedef void ExecutionSignature(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, WorkIndex);
+
+  template<typename PositionPortal, typename FlagPortal, typename ColorPortal>
+  VTKM_EXEC void operator()(const vtkm::Id &hit_idx,
+                            const vtkm::Int32 &camera_id,
+                            const vtkm::Float32 &ix,
+                            const vtkm::Float32 &iy,
+                            const vtkm::Float32 &iz,
+                            const vtkm::Float32 &nx,
+                            const vtkm::Float32 &ny,
+                            const vtkm::Float32 &nz,
+                            const PositionPortal &lights,
+                            const PositionPortal &positions,
+                            const PositionPortal &look_ats,
+                            const FlagPortal &shading,
+                            ColorPortal &colors,
+                            const vtkm::Id &index) const
+  {
+    if(hit_idx < 0 || shading.Get(camera_id) == 0)
+    {
+      return;
+    }
+
+    const vtkm::Vec<vtkm::Float32,3> intersection(ix, iy, iz);
+    const vtkm::Vec<vtkm::Float32,3> normal(nx, ny, nz);
+
+    vtkm::Vec<vtkm::Float32,3> light_dir = lights.Get(camera_id) - intersection;
+    vtkm::Vec<vtkm::Float32,3> view_dir = positions.Get(camera_id) - look_ats.Get(camera_id);
+    vtkm::Normalize(light_dir);
+    vtkm::Normalize(view_dir);
+
+    vtkm::Float32 cos_theta = vtkm::dot(normal, light_dir);
+    cos_theta = vtkm::Min(vtkm::Max(cos_theta, 0.f), 1.f);
+
+    vtkm::Vec<vtkm::Float32,3> reflect = 2.f * vtkm::dot(light_dir, normal) * normal - light_dir;
+    vtkm::Normalize(reflect);
+    const vtkm::Float32 cos_phi = vtkm::dot(reflect, view_dir);
+    const vtkm::Float32 specular = vtkm::Pow(vtkm::Max(cos_phi, 0.f), m_specular_exponent);
+    const vtkm::Float32 intensity =
+      vtkm::Min(m_ambient + m_diffuse * cos_theta + m_specular * specular, 1.f);
+
+    const vtkm::Id offset = index * 4;
+    for(vtkm::Id i = 0; i < 3; ++i)
+    {
+      colors.Set(offset + i, colors.Get(offset + i) * intensity);
+    }
+  }
+}; //class HeadlightShade
+
+} // namespace detail
+
+RayTracerMapper::RayTracerMapper()
+  : m_canvas(nullptr),
+    m_composite_background(true),
+    m_shading(true),
+    m_max_batch_rays(1 << 24)
+{
+}
+
+RayTracerMapper::~RayTracerMapper()
+{
+}
+
+std::shared_ptr<RayTracerMapper::Geometry>
+RayTracerMapper::BuildGeometry(const vtkm::cont::DynamicCellSet &cellset,
+                               const vtkm::cont::CoordinateSystem &coords)
+{
+  vtkm::rendering::raytracing::Logger *logger =
+    vtkm::rendering::raytracing::Logger::GetInstance();
+  logger->OpenLogEntry("vtkh_ray_tracer_geometry");
+
+  auto geometry = std::make_shared<Geometry>();
+
+  vtkm::rendering::raytracing::TriangleExtractor extractor;
+  extractor.ExtractCells(cellset);
+  geometry->m_num_triangles = extractor.GetNumberOfTriangles();
+
+  if(geometry->m_num_triangles > 0)
+  {
+    auto intersector = std::make_shared<vtkm::rendering::raytracing::TriangleIntersector>();
+    // this builds the bvh
+    intersector->SetData(coords, extractor.GetTriangles());
+    geometry->m_bounds.Include(intersector->GetShapeBounds());
+    geometry->m_intersector = intersector;
+  }
+
+  logger->AddLogData("num_triangles", geometry->m_num_triangles);
+  logger->CloseLogEntry(-1.0);
+  return geometry;
+}
+
+void
+RayTracerMapper::SetGeometry(const vtkm::cont::DynamicCellSet &cellset,
+                             const vtkm::cont::CoordinateSystem &coords)
+{
+  SetGeometry(BuildGeometry(cellset, coords));
+}
+
+void
+RayTracerMapper::SetGeometry(std::shared_ptr<Geometry> geometry)
+{
+  ClearGeometry();
+  m_geometry = geometry;
+  if(m_geometry != nullptr && m_geometry->m_intersector != nullptr)
+  {
+    m_tracer.AddShapeIntersector(m_geometry->m_intersector);
+  }
+}
+
+void
+RayTracerMapper::ClearGeometry()
+{
+  m_tracer.Clear();
+  m_geometry.reset();
+}
+
+bool
+RayTracerMapper::HasGeometry() const
+{
+  return m_geometry != nullptr;
+}
+
+void
+RayTracerMapper::SetCanvas(vtkm::rendering::Canvas *canvas)
+{
+  if(canvas != nullptr)
+  {
+    m_canvas = dynamic_cast<vtkm::rendering::CanvasRayTracer*>(canvas);
+    if(m_canvas == nullptr)
+    {
+      throw Error("RayTracerMapper: bad canvas type. Must be CanvasRayTracer");
+    }
+  }
+  else
+  {
+    m_canvas = nullptr;
+  }
+}
+
+vtkm::rendering::Canvas*
+RayTracerMapper::GetCanvas() const
+{
+  return m_canvas;
+}
+
+void
+RayTracerMapper::RenderCells(const vtkm::cont::DynamicCellSet &cellset,
+                             const vtkm::cont::CoordinateSystem &coords,
+                             const vtkm::cont::Field &scalar_field,
+                             const vtkm::cont::ColorTable &vtkmNotUsed(color_table),
+                             const vtkm::rendering::Camera &camera,
+                             const vtkm::Range &scalar_range)
+{
+  // geometry built here is only for this call, so a later call with a
+  // different cell set does not trace the old mesh
+  const bool own_geometry = !HasGeometry();
+  if(own_geometry)
+  {
+    SetGeometry(cellset, coords);
+  }
+
+  if(m_geometry->m_intersector == nullptr)
+  {
+    // nothing to trace
+    if(own_geometry)
+    {
+      ClearGeometry();
+    }
+    return;
+  }
+
+  vtkm::rendering::raytracing::Camera &cam = m_tracer.GetCamera();
+  cam.SetParameters(camera, *m_canvas);
+  m_ray_camera.SetParameters(camera, *m_canvas);
+
+  m_ray_camera.CreateRays(m_rays, m_geometry->m_bounds);
+  m_rays.Buffers.at(0).InitConst(0.f);
+  vtkm::rendering::raytracing::RayOperations::MapCanvasToRays(m_rays, camera, *m_canvas);
+
+  m_tracer.SetField(scalar_field, scalar_range);
+  m_tracer.SetColorMap(this->ColorMap);
+  m_tracer.SetShadingOn(m_shading);
+  m_tracer.Render(m_rays);
+
+  m_canvas->WriteToCanvas(m_rays, m_rays.Buffers.at(0).Buffer, camera);
+
+  if(m_composite_background)
+  {
+    m_canvas->BlendBackground();
+  }
+
+  if(own_geometry)
+  {
+    ClearGeometry();
+  }
+}
+
+void
+RayTracerMapper::SetMaxBatchRays(const vtkm::Id &max_rays)
+{
+  m_max_batch_rays = max_rays;
+}
+
+void
+RayTracerMapper::RenderCellsBatched(const std::vector<vtkm::rendering::Camera> &cameras,
+                                    const std::vector<vtkm::rendering::Canvas*> &canvases,
+                                    const std::vector<bool> &shading,
+                                    const vtkm::cont::Field &scalar_field,
+                                    const vtkm::Range &scalar_range)
+{
+  if(!HasGeometry())
+  {
+    throw Error("RayTracerMapper: batched rendering requires geometry to be set");
+  }
+
+  if(cameras.size() != canvases.size() || cameras.size() != shading.size())
+  {
+    throw Error("RayTracerMapper: batched rendering needs a canvas and "
+                "shading flag for every camera");
+  }
+
+  if(m_geometry->m_intersector == nullptr)
+  {
+    // nothing to trace
+    return;
+  }
+
+  // group cameras so that the worst case number of rays (every pixel)
+  // in a launch stays under the budget
+  const int num_cameras = static_cast<int>(cameras.size());
+  int begin = 0;
+  vtkm::Id batch_rays = 0;
+  for(int i = 0; i < num_cameras; ++i)
+  {
+    const vtkm::Id camera_rays = canvases[i]->GetWidth() * canvases[i]->GetHeight();
+    if(i > begin && batch_rays + camera_rays > m_max_batch_rays)
+    {
+      TraceBatch(cameras, canvases, shading, begin, i, scalar_field, scalar_range);
+      begin = i;
+      batch_rays = 0;
+    }
+    batch_rays += camera_rays;
+  }
+
+  if(begin < num_cameras)
+  {
+    TraceBatch(cameras, canvases, shading, begin, num_cameras, scalar_field, scalar_range);
+  }
+}
+
+void
+RayTracerMapper::TraceBatch(const std::vector<vtkm::rendering::Camera> &cameras,
+                            const std::vector<vtkm::rendering::Canvas*> &canvases,
+                            const std::vector<bool> &shading,
+                            const int &begin,
+                            const int &end,
+                            const vtkm::cont::Field &scalar_field,
+                            const vtkm::Range &scalar_range)
+{
+  vtkm::rendering::raytracing::Logger *logger =
+    vtkm::rendering::raytracing::Logger::GetInstance();
+  logger->OpenLogEntry("vtkh_ray_tracer_batch");
+
+  const int num_cameras = end - begin;
+  std::vector<vtkm::rendering::CanvasRayTracer*> batch_canvases(num_cameras);
+  std::vector<vtkm::Id> counts(num_cameras);
+  std::vector<vtkm::Id> offsets(num_cameras);
+  std::vector<vtkm::Vec<vtkm::Float32,3>> lights(num_cameras);
+  std::vector<vtkm::Vec<vtkm::Float32,3>> positions(num_cameras);
+  std::vector<vtkm::Vec<vtkm::Float32,3>> look_ats(num_cameras);
+  std::vector<vtkm::UInt8> shade(num_cameras);
+
+  // The vtkm camera only generates a whole Ray, so each camera's rays
+  // are built in a staging buffer and copied into their slice of the
+  // batch. Generation is cheap next to traversal, so the rays are built
+  // once to size the batch and again to fill it, which keeps the extra
+  // memory to one camera's rays instead of a second copy of the batch.
+  detail::RayType stage;
+  vtkm::Id total_rays = 0;
+  for(int i = 0; i < num_cameras; ++i)
+  {
+    const vtkm::rendering::Camera &camera = cameras[begin + i];
+    batch_canvases[i] = dynamic_cast<vtkm::rendering::CanvasRayTracer*>(canvases[begin + i]);
+    if(batch_canvases[i] == nullptr)
+    {
+      throw Error("RayTracerMapper: bad canvas type. Must be CanvasRayTracer");
+    }
+
+    m_ray_camera.SetParameters(camera, *batch_canvases[i]);
+    m_ray_camera.CreateRays(stage, m_geometry->m_bounds);
+
+    counts[i] = stage.NumRays;
+    offsets[i] = total_rays;
+    total_rays += counts[i];
+
+    // the vtkm tracer puts its light two units along the view up
+    vtkm::Vec<vtkm::Float32,3> up = camera.GetViewUp();
+    vtkm::Normalize(up);
+    positions[i] = vtkm::Vec<vtkm::Float32,3>(camera.GetPosition());
+    lights[i] = positions[i] + 2.f * up;
+    look_ats[i] = vtkm::Vec<vtkm::Float32,3>(camera.GetLookAt());
+    shade[i] = shading[begin + i] ? 1 : 0;
+  }
+
+  if(total_rays == 0)
+  {
+    // the geometry is outside of every view
+    logger->CloseLogEntry(-1.0);
+    return;
+  }
+
+  detail::RayType rays;
+  rays.Resize(static_cast<vtkm::Int32>(total_rays));
+  vtkm::cont::ArrayHandle<vtkm::Int32> camera_ids;
+  camera_ids.Allocate(total_rays);
+  for(int i = 0; i < num_cameras; ++i)
+  {
+    const vtkm::rendering::Camera &camera = cameras[begin + i];
+    m_ray_camera.SetParameters(camera, *batch_canvases[i]);
+    m_ray_camera.CreateRays(stage, m_geometry->m_bounds);
+    stage.Buffers.at(0).InitConst(0.f);
+    vtkm::rendering::raytracing::RayOperations::MapCanvasToRays(stage, camera, *batch_canvases[i]);
+
+    detail::copy_rays(stage, 0, rays, offsets[i], counts[i]);
+    vtkm::cont::Algorithm::CopySubRange(vtkm::cont::make_ArrayHandleConstant(vtkm::Int32(i), counts[i]),
+                                        0,
+                                        counts[i],
+                                        camera_ids,
+                                        offsets[i]);
+  }
+
+  // the tracer camera is only used for lighting, which is done below
+  m_tracer.GetCamera().SetParameters(cameras[begin], *canvases[begin]);
+  m_tracer.SetField(scalar_field, scalar_range);
+  m_tracer.SetColorMap(this->ColorMap);
+  m_tracer.SetShadingOn(false);
+  m_tracer.Render(rays);
+
+  vtkm::worklet::DispatcherMapField<detail::HeadlightShade>().Invoke(
+    rays.HitIdx,
+    camera_ids,
+    rays.IntersectionX,
+    rays.IntersectionY,
+    rays.IntersectionZ,
+    rays.NormalX,
+    rays.NormalY,
+    rays.NormalZ,
+    vtkm::cont::make_ArrayHandle(lights),
+    vtkm::cont::make_ArrayHandle(positions),
+    vtkm::cont::make_ArrayHandle(look_ats),
+    vtkm::cont::make_ArrayHandle(shade),
+    rays.Buffers.at(0).Buffer);
+
+  // scatter the results back into each canvas through the staging rays
+  for(int i = 0; i < num_cameras; ++i)
+  {
+    stage.Resize(static_cast<vtkm::Int32>(counts[i]));
+    detail::copy_rays(rays, offsets[i], stage, 0, counts[i]);
+    batch_canvases[i]->WriteToCanvas(stage, stage.Buffers.at(0).Buffer, cameras[begin + i]);
+    if(m_composite_background)
+    {
+      batch_canvases[i]->BlendBackground();
+    }
+  }
+
+  logger->AddLogData("num_cameras", num_cameras);
+  logger->AddLogData("num_rays", total_rays);
+  logger->CloseLogEntry(-1.0);
+}
+
+void
+RayTracerMapper::SetCompositeBackground(bool on)
+{
+  m_composite_background = on;
+}
+
+void
+RayTracerMapper::SetShadingOn(bool on)
+{
+  m_shading = on;
+}
+
+void
+RayTracerMapper::StartScene()
+{
+  // nothing needs to be done
+}
+
+void
+RayTracerMapper::EndScene()
+{
+  // nothing needs to be done
+}
+
+vtkm::rendering::Mapper*
+RayTracerMapper::NewCopy() const
+{
+  return new RayTracerMapper(*this);
+}
+
+} // namespace vtkh
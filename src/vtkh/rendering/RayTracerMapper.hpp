@@ -0,0 +1,102 @@
+#ifndef VTK_H_RAY_TRACER_MAPPER_HPP
+#define VTK_H_RAY_TRACER_MAPPER_HPP
+
+#include <memory>
+#include <vector>
+#include <vtkh/vtkh_exports.h>
+
+#include <vtkm/rendering/CanvasRayTracer.h>
+#include <vtkm/rendering/Mapper.h>
+#include <vtkm/rendering/raytracing/Camera.h>
+#include <vtkm/rendering/raytracing/Ray.h>
+#include <vtkm/rendering/raytracing/RayTracer.h>
+#include <vtkm/rendering/raytracing/ShapeIntersector.h>
+
+namespace vtkh {
+
+//
+// A triangle ray tracing mapper that separates building the geometry
+// (external faces, triangulation and the BVH) from tracing a camera.
+// vtkm::rendering::MapperRayTracer rebuilds everything on each call
+// to RenderCells, so rendering the same domain for every camera in a
+// batch rebuilt the same BVH over and over. Call SetGeometry once
+// per domain, then RenderCells for each camera. If no geometry has
+// been set, RenderCells builds it from the cell set it is given and
+// drops it again when the call returns.
+// Geometry is shared, so it can outlive the mapper (see TopologyCache).
+//
+class VTKH_API RayTracerMapper : public vtkm::rendering::Mapper
+{
+public:
+  struct Geometry
+  {
+    std::shared_ptr<vtkm::rendering::raytracing::ShapeIntersector> m_intersector;
+    vtkm::Bounds                                                   m_bounds;
+    vtkm::Id                                                       m_num_triangles;
+  };
+
+  RayTracerMapper();
+  virtual ~RayTracerMapper();
+
+  static std::shared_ptr<Geometry> BuildGeometry(const vtkm::cont::DynamicCellSet &cellset,
+                                                 const vtkm::cont::CoordinateSystem &coords);
+
+  void SetGeometry(const vtkm::cont::DynamicCellSet &cellset,
+                   const vtkm::cont::CoordinateSystem &coords);
+  void SetGeometry(std::shared_ptr<Geometry> geometry);
+  void ClearGeometry();
+  bool HasGeometry() const;
+
+  void SetCanvas(vtkm::rendering::Canvas *canvas) override;
+  vtkm::rendering::Canvas* GetCanvas() const override;
+
+  void RenderCells(const vtkm::cont::DynamicCellSet &cellset,
+                   const vtkm::cont::CoordinateSystem &coords,
+                   const vtkm::cont::Field &scalar_field,
+                   const vtkm::cont::ColorTable &color_table,
+                   const vtkm::rendering::Camera &camera,
+                   const vtkm::Range &scalar_range) override;
+
+  //
+  // Traces every camera against the current geometry in as few launches
+  // as possible. Rays are generated per camera and copied into one
+  // buffer (up to the ray budget), traversed and colored together, then
+  // scattered back into each camera's canvas. Shading is applied per
+  // camera afterwards with the same lighting RenderCells uses.
+  //
+  void RenderCellsBatched(const std::vector<vtkm::rendering::Camera> &cameras,
+                          const std::vector<vtkm::rendering::Canvas*> &canvases,
+                          const std::vector<bool> &shading,
+                          const vtkm::cont::Field &scalar_field,
+                          const vtkm::Range &scalar_range);
+  // max number of rays in a single batched launch
+  void SetMaxBatchRays(const vtkm::Id &max_rays);
+
+  void SetCompositeBackground(bool on);
+  void SetShadingOn(bool on);
+
+  void StartScene() override;
+  void EndScene() override;
+
+  vtkm::rendering::Mapper* NewCopy() const override;
+protected:
+  vtkm::rendering::CanvasRayTracer                              *m_canvas;
+  vtkm::rendering::raytracing::RayTracer                         m_tracer;
+  vtkm::rendering::raytracing::Camera                            m_ray_camera;
+  vtkm::rendering::raytracing::Ray<vtkm::Float32>                m_rays;
+  std::shared_ptr<Geometry>                                      m_geometry;
+  bool                                                           m_composite_background;
+  bool                                                           m_shading;
+  vtkm::Id                                                       m_max_batch_rays;
+
+  void TraceBatch(const std::vector<vtkm::rendering::Camera> &cameras,
+                  const std::vector<vtkm::rendering::Canvas*> &canvases,
+                  const std::vector<bool> &shading,
+                  const int &begin,
+                  const int &end,
+                  const vtkm::cont::Field &scalar_field,
+                  const vtkm::Range &scalar_range);
+};
+
+} // namespace vtkh
+#endif
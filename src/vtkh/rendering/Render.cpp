@@ -1,20 +1,225 @@
 #include "Render.hpp"
 #include <vtkh/rendering/Annotator.hpp>
+#include <vtkh/utils/ImageEncoders.hpp>
+#include <vtkh/utils/PixelKernels.hpp>
 #include <vtkh/utils/PNGEncoder.hpp>
 #include <vtkh/utils/vtkm_array_utils.hpp>
 #include <vtkm/rendering/MapperRayTracer.h>
 #include <vtkm/rendering/View2D.h>
 #include <vtkm/rendering/View3D.h>
 
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <sstream>
+
 namespace vtkh
 {
 
+namespace detail
+{
+
+struct SaveSettings
+{
+  AsyncQueue m_queue;
+  bool       m_async;
+
+  SaveSettings()
+    : m_async(true)
+  {
+  }
+};
+
+SaveSettings &save_settings()
+{
+  static SaveSettings settings;
+  return settings;
+}
+
+//
+// Screen annotations (color bars with their field names) only depend on
+// the fields, ranges, color tables, foreground color and image size. They
+// are rasterized once onto a transparent canvas and the covered pixels
+// are kept premultiplied, so blending them with "over" gives the same
+// result as drawing onto the image.
+//
+struct Overlay
+{
+  std::vector<int>                        m_pixels;
+  std::vector<vtkm::Vec<vtkm::Float32,4>> m_colors;
+};
+
+struct OverlayCache
+{
+  std::list<std::pair<std::string, std::shared_ptr<Overlay>>> m_overlays;
+  size_t                                                      m_max_size;
+
+  OverlayCache()
+    : m_max_size(16)
+  {
+  }
+};
+
+OverlayCache &overlay_cache()
+{
+  static OverlayCache cache;
+  return cache;
+}
+
+std::string overlay_key(const std::vector<std::string> &field_names,
+                        const std::vector<vtkm::Range> &ranges,
+                        const std::vector<vtkm::cont::ColorTable> &colors,
+                        const vtkm::rendering::Color &fg_color,
+                        const int width,
+                        const int height)
+{
+  std::ostringstream key;
+  key.precision(17);
+  key<<width<<"x"<<height<<" fg";
+  for(int i = 0; i < 4; ++i)
+  {
+    key<<" "<<fg_color.Components[i];
+  }
+  for(size_t f = 0; f < field_names.size(); ++f)
+  {
+    key<<"|"<<field_names[f]<<" "<<ranges[f].Min<<" "<<ranges[f].Max;
+    const vtkm::cont::ColorTable &table = colors[f];
+    key<<" "<<static_cast<int>(table.GetColorSpace());
+    const int num_points = table.GetNumberOfPoints();
+    for(int i = 0; i < num_points; ++i)
+    {
+      vtkm::Vec<vtkm::Float64,4> point;
+      table.GetPoint(i, point);
+      key<<" "<<point[0]<<" "<<point[1]<<" "<<point[2]<<" "<<point[3];
+    }
+    const int num_alpha = table.GetNumberOfPointsAlpha();
+    for(int i = 0; i < num_alpha; ++i)
+    {
+      vtkm::Vec<vtkm::Float64,4> point;
+      table.GetPointAlpha(i, point);
+      key<<" a "<<point[0]<<" "<<point[1]<<" "<<point[2]<<" "<<point[3];
+    }
+  }
+  return key.str();
+}
+
+std::shared_ptr<Overlay>
+screen_overlay(const std::vector<std::string> &field_names,
+               const std::vector<vtkm::Range> &ranges,
+               const std::vector<vtkm::cont::ColorTable> &colors,
+               const vtkm::rendering::Color &fg_color,
+               const vtkm::rendering::Camera &camera,
+               const vtkm::Bounds &bounds,
+               const int width,
+               const int height)
+{
+  OverlayCache &cache = overlay_cache();
+  const std::string key = overlay_key(field_names, ranges, colors, fg_color, width, height);
+  for(auto it = cache.m_overlays.begin(); it != cache.m_overlays.end(); ++it)
+  {
+    if(it->first == key)
+    {
+      // most recently used first
+      cache.m_overlays.splice(cache.m_overlays.begin(), cache.m_overlays, it);
+      return it->second;
+    }
+  }
+
+  vtkm::rendering::CanvasRayTracer canvas(width, height);
+  canvas.SetBackgroundColor(vtkm::rendering::Color(0.f, 0.f, 0.f, 0.f));
+  canvas.SetForegroundColor(fg_color);
+  canvas.Clear();
+  vtkm::rendering::Camera screen_camera = camera;
+  Annotator annotator(canvas, screen_camera, bounds);
+  annotator.RenderScreenAnnotations(field_names, ranges, colors);
+
+  std::shared_ptr<Overlay> overlay = std::make_shared<Overlay>();
+  const vtkm::Vec<vtkm::Float32,4> *color_buffer = GetVTKMPointer(canvas.GetColorBuffer());
+  const int size = width * height;
+  for(int i = 0; i < size; ++i)
+  {
+    if(color_buffer[i][3] > 0.f)
+    {
+      overlay->m_pixels.push_back(i);
+      overlay->m_colors.push_back(color_buffer[i]);
+    }
+  }
+
+  cache.m_overlays.push_front(std::make_pair(key, overlay));
+  while(cache.m_overlays.size() > cache.m_max_size)
+  {
+    cache.m_overlays.pop_back();
+  }
+  return overlay;
+}
+
+void blend_overlay(const Overlay &overlay, vtkm::rendering::Canvas &canvas)
+{
+  vtkm::Vec<vtkm::Float32,4> *color_buffer = GetVTKMPointer(canvas.GetColorBuffer());
+  const int size = static_cast<int>(overlay.m_pixels.size());
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < size; ++i)
+  {
+    const vtkm::Vec<vtkm::Float32,4> &src = overlay.m_colors[i];
+    vtkm::Vec<vtkm::Float32,4> &dst = color_buffer[overlay.m_pixels[i]];
+    const vtkm::Float32 remaining = 1.f - src[3];
+    for(int c = 0; c < 4; ++c)
+    {
+      dst[c] = src[c] + dst[c] * remaining;
+    }
+  }
+}
+
+//
+// The projection maps the view to [-1,1] and zoom and pan are applied
+// on top of it, ndc = zoom * (projected + pan). The tile camera zooms so
+// the tile spans [-1,1] and pans its center to the origin. Projection
+// scales x by the canvas aspect, so a tile whose aspect differs from
+// the image also scales the pan in x.
+//
+vtkm::rendering::Camera tile_camera(const vtkm::rendering::Camera &camera,
+                                    const int width,
+                                    const int height,
+                                    const int x,
+                                    const int y,
+                                    const int tile_width,
+                                    const int tile_height)
+{
+  const vtkm::Float32 scale_x = vtkm::Float32(width) / vtkm::Float32(tile_width);
+  const vtkm::Float32 scale_y = vtkm::Float32(height) / vtkm::Float32(tile_height);
+  const vtkm::Float32 center_x = 2.f * (x + 0.5f * tile_width) / width - 1.f;
+  const vtkm::Float32 center_y = 2.f * (y + 0.5f * tile_height) / height - 1.f;
+
+  vtkm::rendering::Camera tile = camera;
+  const vtkm::Float32 zoom = camera.GetZoom();
+  const vtkm::Vec2f_32 pan = camera.GetPan();
+  vtkm::Vec2f_32 tile_pan;
+  tile_pan[0] = (scale_x / scale_y) * (pan[0] - center_x / zoom);
+  tile_pan[1] = pan[1] - center_y / zoom;
+
+  // Zoom takes a power of 4 and also scales the pan, so the pan is set
+  // after it relative to whatever Zoom left
+  tile.Zoom(std::log(scale_y) / std::log(4.f));
+  const vtkm::Vec2f_32 zoomed_pan = tile.GetPan();
+  tile.Pan(tile_pan[0] - zoomed_pan[0], tile_pan[1] - zoomed_pan[1]);
+  return tile;
+}
+
+} // namespace detail
+
 Render::Render()
   : m_width(1024),
     m_height(1024),
     m_render_annotations(true),
     m_render_background(true),
-    m_shading(true)
+    m_shading(true),
+    m_single_canvas(false),
+    m_compression_level(6),
+    m_tile_size(0),
+    m_image_format(PNG),
+    m_output_image(std::make_shared<Image>())
 {
 }
 
@@ -42,6 +247,12 @@ Render::GetDomainCanvas(const vtkm::Id &domain_id)
     throw Error(ss.str());
   }
 
+  if(m_single_canvas)
+  {
+    // every domain renders into the same canvas
+    dom = 0;
+  }
+
   if(m_canvases[dom] == nullptr)
   {
     m_canvases[dom] = this->CreateCanvas();
@@ -122,10 +333,144 @@ Render::SetSceneBounds(const vtkm::Bounds &bounds)
   m_scene_bounds = bounds;
 }
 
+void
+Render::SetImageFormat(ImageFormat format)
+{
+  m_image_format = format;
+}
+
+Render::ImageFormat
+Render::GetImageFormat() const
+{
+  return m_image_format;
+}
+
+const Image&
+Render::GetImage() const
+{
+  return *m_output_image;
+}
+
+void
+Render::SetTileSize(const int tile_size)
+{
+  if(tile_size < 0)
+  {
+    throw Error("Render: tile size cannot be negative");
+  }
+  m_tile_size = tile_size;
+}
+
+int
+Render::GetTileSize() const
+{
+  return m_tile_size;
+}
+
+bool
+Render::IsTiled() const
+{
+  return m_tile_size > 0 &&
+         m_image_format == PNG &&
+         (m_tile_size < m_width || m_tile_size < m_height);
+}
+
+int
+Render::GetNumberOfTiles() const
+{
+  if(!IsTiled())
+  {
+    return 1;
+  }
+  const int tiles_x = (m_width + m_tile_size - 1) / m_tile_size;
+  const int tiles_y = (m_height + m_tile_size - 1) / m_tile_size;
+  return tiles_x * tiles_y;
+}
+
+void
+Render::GetTileViewport(const int tile,
+                        int &x,
+                        int &y,
+                        int &width,
+                        int &height) const
+{
+  if(!IsTiled())
+  {
+    x = 0;
+    y = 0;
+    width = m_width;
+    height = m_height;
+    return;
+  }
+  const int tiles_x = (m_width + m_tile_size - 1) / m_tile_size;
+  const int top = (tile / tiles_x) * m_tile_size;
+  x = (tile % tiles_x) * m_tile_size;
+  width = std::min(m_tile_size, m_width - x);
+  height = std::min(m_tile_size, m_height - top);
+  y = m_height - top - height;
+}
+
+vtkh::Render
+Render::GetTile(const int tile) const
+{
+  if(tile < 0 || tile >= GetNumberOfTiles())
+  {
+    throw Error("Render: tile index out of range");
+  }
+  int x, y, width, height;
+  GetTileViewport(tile, x, y, width, height);
+
+  vtkh::Render res = *this;
+  res.m_tile_size = 0;
+  res.m_width = width;
+  res.m_height = height;
+  res.m_camera = detail::tile_camera(m_camera, m_width, m_height, x, y, width, height);
+  res.m_canvases.assign(m_canvases.size(), nullptr);
+  res.m_image_format = MEMORY;
+  res.m_output_image = std::make_shared<Image>();
+  return res;
+}
+
+void
+Render::SetCompressionLevel(const int level)
+{
+  m_compression_level = level;
+}
+
+int
+Render::GetCompressionLevel() const
+{
+  return m_compression_level;
+}
+
+void
+Render::SetSingleCanvas(bool on)
+{
+  if(on == m_single_canvas)
+  {
+    return;
+  }
+
+  m_single_canvas = on;
+  // canvases are created lazily, so only the slots need to change
+  const size_t num_canvases = m_single_canvas ? 1 : m_domain_ids.size();
+  m_canvases.clear();
+  m_canvases.resize(num_canvases, nullptr);
+}
+
+bool
+Render::GetSingleCanvas() const
+{
+  return m_single_canvas;
+}
+
 void
 Render::AddDomain(vtkm::Id domain_id)
 {
-  m_canvases.push_back(nullptr);
+  if(!m_single_canvas || m_canvases.size() == 0)
+  {
+    m_canvases.push_back(nullptr);
+  }
   m_domain_ids.push_back(domain_id);
 }
 
@@ -238,8 +583,16 @@ Render::RenderScreenAnnotations(const std::vector<std::string> &field_names,
   if(size < 1) return;
 
   if(m_render_background) m_canvases[0]->BlendBackground();
-  Annotator annotator(*m_canvases[0], m_camera, m_scene_bounds);
-  annotator.RenderScreenAnnotations(field_names, ranges, colors);
+  if(field_names.empty()) return;
+  std::shared_ptr<detail::Overlay> overlay = detail::screen_overlay(field_names,
+                                                                    ranges,
+                                                                    colors,
+                                                                    m_fg_color,
+                                                                    m_camera,
+                                                                    m_scene_bounds,
+                                                                    m_canvases[0]->GetWidth(),
+                                                                    m_canvases[0]->GetHeight());
+  detail::blend_overlay(*overlay, *m_canvases[0]);
 }
 
 void
@@ -260,22 +613,141 @@ Render::CreateCanvas()
   return canvas;
 }
 
-void
-Render::Save()
+AsyncQueue::Job
+Render::MakeSaveJob()
 {
   // After rendering and compositing
   // Rank 0 domain 0 contains the complete image.
   int size = m_canvases.size();
-  if(size < 1) return;
+  if(size < 1) return AsyncQueue::Job();
 #ifdef VTKH_PARALLEL
-  if(vtkh::GetMPIRank() != 0) return;
+  if(vtkh::GetMPIRank() != 0) return AsyncQueue::Job();
 #endif
-  float* color_buffer = &GetVTKMPointer(m_canvases[0]->GetColorBuffer())[0][0];
-  int height = m_canvases[0]->GetHeight();
-  int width = m_canvases[0]->GetWidth();
-  PNGEncoder encoder;
-  encoder.Encode(color_buffer, width, height);
-  encoder.Save(m_image_name + ".png");
+  // the job keeps the canvas alive, so the buffer is handed off not copied
+  vtkmCanvasPtr canvas = m_canvases[0];
+  const float* color_buffer = &GetVTKMPointer(canvas->GetColorBuffer())[0][0];
+  const float* depth_buffer = GetVTKMPointer(canvas->GetDepthBuffer());
+  const int height = canvas->GetHeight();
+  const int width = canvas->GetWidth();
+
+  if(m_image_format == MEMORY)
+  {
+    m_output_image->Init(color_buffer, depth_buffer, width, height);
+    return AsyncQueue::Job();
+  }
+
+  const int level = m_compression_level;
+  const ImageFormat format = m_image_format;
+  const std::string name = m_image_name;
+
+  return [canvas, color_buffer, depth_buffer, width, height, level, format, name]()
+  {
+    std::string file_name;
+    bool saved = false;
+    if(format == PNG)
+    {
+      file_name = name + ".png";
+      PNGEncoder encoder;
+      encoder.SetCompressionLevel(level);
+      encoder.Encode(color_buffer, width, height);
+      saved = encoder.Save(file_name);
+    }
+    else
+    {
+      std::vector<unsigned char> rgba(width * height * 4);
+      PixelKernels::FloatToUChar(color_buffer, &rgba[0], width * height * 4);
+      if(format == QOI)
+      {
+        file_name = name + ".qoi";
+        QOIEncoder encoder;
+        encoder.Encode(&rgba[0], width, height);
+        saved = encoder.Save(file_name);
+      }
+      else
+      {
+        file_name = name + ".raw";
+        RawImageEncoder encoder;
+        encoder.Encode(&rgba[0], depth_buffer, width, height);
+        saved = encoder.Save(file_name);
+      }
+    }
+
+    if(!saved)
+    {
+      throw Error("Render: failed to write image '" + file_name + "'");
+    }
+  };
+}
+
+void
+Render::Save()
+{
+  AsyncQueue::Job job = MakeSaveJob();
+  if(job)
+  {
+    job();
+  }
+}
+
+void
+Render::SaveAsync()
+{
+  AsyncQueue::Job job = MakeSaveJob();
+  if(job)
+  {
+    detail::save_settings().m_queue.Push(job);
+  }
+}
+
+void
+Render::SetAsyncSave(bool on)
+{
+  if(!on)
+  {
+    FlushSaves();
+  }
+  detail::save_settings().m_async = on;
+}
+
+bool
+Render::GetAsyncSave()
+{
+  return detail::save_settings().m_async;
+}
+
+void
+Render::SetSaveQueueSize(const int size)
+{
+  detail::save_settings().m_queue.SetMaxSize(size);
+}
+
+void
+Render::FlushSaves()
+{
+  detail::save_settings().m_queue.Flush();
+}
+
+void
+Render::SetAnnotationCacheSize(const int size)
+{
+  detail::OverlayCache &cache = detail::overlay_cache();
+  cache.m_max_size = static_cast<size_t>(std::max(size, 0));
+  while(cache.m_overlays.size() > cache.m_max_size)
+  {
+    cache.m_overlays.pop_back();
+  }
+}
+
+void
+Render::ClearAnnotationCache()
+{
+  detail::overlay_cache().m_overlays.clear();
+}
+
+AsyncQueue&
+Render::GetSaveQueue()
+{
+  return detail::save_settings().m_queue;
 }
 
 vtkh::Render
@@ -5,6 +5,8 @@
 #include <vtkh/vtkh_exports.h>
 #include <vtkh/DataSet.hpp>
 #include <vtkh/Error.hpp>
+#include <vtkh/rendering/Image.hpp>
+#include <vtkh/utils/AsyncQueue.hpp>
 
 #include <vtkm/rendering/Camera.h>
 #include <vtkm/rendering/CanvasRayTracer.h>
@@ -19,12 +21,36 @@ namespace vtkh {
 // transformations, to handle this we keep track of the domain ids
 // that each canvas is associated with.
 //
+// Surface renderers depth test against what is already in the canvas,
+// so when only surfaces are rendered all local domains can share one
+// canvas (SetSingleCanvas). Canvas memory then no longer grows with
+// the number of domains. Volume rendering needs a canvas per domain
+// to blend domains in visibility order.
+// Save writes the image before returning. SaveAsync instead hands the
+// finished color buffer to a background writer, so encoding and file
+// I/O overlap with rendering the next batch, and the caller must call
+// FlushSaves before the file is needed. Scene saves in the background
+// (see SetAsyncSave) and flushes the writer before Render returns.
+// Images too large to keep whole can be tiled (SetTileSize). Scene then
+// renders and composites one tile at a time and streams the tiles into
+// the png, so canvases and compositing buffers are tile sized.
+//
 
 class VTKH_API Render
 {
 public:
   typedef std::shared_ptr<vtkm::rendering::CanvasRayTracer> vtkmCanvasPtr;
 
+  // what Save produces: a .png, .qoi or .raw (color + depth, see
+  // RawImageEncoder) file, or no file and the image kept in memory
+  enum ImageFormat
+  {
+    PNG,
+    QOI,
+    RAW,
+    MEMORY
+  };
+
   Render();
   ~Render();
   vtkmCanvasPtr                   GetDomainCanvas(const vtkm::Id &domain_id);
@@ -37,6 +63,7 @@ public:
   vtkm::Int32                     GetWidth() const;
   vtkm::rendering::Color          GetBackgroundColor() const;
   bool                            GetShadingOn() const;
+  bool                            GetSingleCanvas() const;
 
   void                            DoRenderAnnotations(bool on);
   void                            DoRenderBackground(bool on);
@@ -48,6 +75,33 @@ public:
   void                            SetBackgroundColor(float bg_color[4]);
   void                            SetForegroundColor(float fg_color[4]);
   void                            SetShadingOn(bool on);
+  void                            SetSingleCanvas(bool on);
+  // png compression level 0-9, see PNGEncoder
+  void                            SetCompressionLevel(const int level);
+  int                             GetCompressionLevel() const;
+  void                            SetImageFormat(ImageFormat format);
+  ImageFormat                     GetImageFormat() const;
+  // the final image kept by Save on rank 0 with the MEMORY format.
+  // Rows are bottom up like the canvas. Copies of this render (e.g. the
+  // ones made by Scene) share it, so it can be read after Scene::Render
+  const Image&                    GetImage() const;
+  // tile edge in pixels, edge tiles are smaller. Only png output can be
+  // tiled. Screen annotations are left out and world annotations are
+  // drawn per tile with the tile's zoomed camera. 0 (default) is untiled
+  void                            SetTileSize(const int tile_size);
+  int                             GetTileSize() const;
+  bool                            IsTiled() const;
+  int                             GetNumberOfTiles() const;
+  // pixel rect of a tile with the origin at the bottom left. Tiles are
+  // row major from the top left, the order the png is written in
+  void                            GetTileViewport(const int tile,
+                                                  int &x,
+                                                  int &y,
+                                                  int &width,
+                                                  int &height) const;
+  // an untiled render of one tile that keeps its image in memory. The
+  // camera only sees the tile's part of the view frustum
+  vtkh::Render                    GetTile(const int tile) const;
   void                            ClearCanvases();
   bool                            HasCanvas(const vtkm::Id &domain_id) const;
   void                            AddDomain(vtkm::Id domain_id);
@@ -56,7 +110,27 @@ public:
   void                            RenderScreenAnnotations(const std::vector<std::string> &field_names,
                                                           const std::vector<vtkm::Range> &ranges,
                                                           const std::vector<vtkm::cont::ColorTable> &colors);
+  // writes the image now. Throws if it could not be written
   void                            Save();
+  // queues the image on the background writer. Errors are thrown from
+  // FlushSaves, and the canvas must not be rendered into until then
+  void                            SaveAsync();
+
+  // process wide image writer settings
+  // whether Scene saves with SaveAsync (default) or Save
+  static void                     SetAsyncSave(bool on);
+  static bool                     GetAsyncSave();
+  // max images waiting to be written before Save blocks
+  static void                     SetSaveQueueSize(const int size);
+  // blocks until all pending images are written. Throws if one of them
+  // could not be written
+  static void                     FlushSaves();
+  static AsyncQueue&              GetSaveQueue();
+  // screen annotations are rasterized once per set of fields, ranges,
+  // color tables and image size and then blended onto every image. Max
+  // overlays kept (default 16)
+  static void                     SetAnnotationCacheSize(const int size);
+  static void                     ClearAnnotationCache();
 protected:
   std::vector<vtkmCanvasPtr>   m_canvases;
   std::vector<vtkm::Id>        m_domain_ids;
@@ -68,9 +142,17 @@ protected:
   vtkm::rendering::Color       m_bg_color;
   vtkm::rendering::Color       m_fg_color;
   vtkmCanvasPtr                CreateCanvas();
+  // the write Save and SaveAsync run. Empty when there is nothing to
+  // write on this rank, or the image was kept in memory
+  AsyncQueue::Job              MakeSaveJob();
   bool                         m_render_annotations;
   bool                         m_render_background;
   bool                         m_shading;
+  bool                         m_single_canvas;
+  int                          m_compression_level;
+  int                          m_tile_size;
+  ImageFormat                  m_image_format;
+  std::shared_ptr<Image>       m_output_image;
 };
 
 static float vtkh_default_bg_color[4] = {0.f, 0.f, 0.f, 1.f};
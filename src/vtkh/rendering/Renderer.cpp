@@ -1,21 +1,42 @@
 #include "Renderer.hpp"
 #include "compositing/Compositor.hpp"
+#include "TopologyCache.hpp"
 
 #include <vtkh/Logger.hpp>
 #include <vtkh/utils/vtkm_array_utils.hpp>
 #include <vtkh/utils/vtkm_dataset_info.hpp>
 #include <vtkh/utils/PNGEncoder.hpp>
+#include <vtkh/utils/PixelKernels.hpp>
 #include <vtkm/rendering/raytracing/Logger.h>
 
 #include <assert.h>
+#include <atomic>
+#include <sstream>
 
 namespace vtkh {
 
+namespace detail
+{
+
+// every renderer owns its own topology cache entries, since two plots
+// of the same type usually render different meshes
+std::string next_cache_owner()
+{
+  static std::atomic<int> next_id(0);
+  std::ostringstream owner;
+  owner<<"renderer_"<<next_id++<<":";
+  return owner.str();
+}
+
+} // namespace detail
+
 Renderer::Renderer()
   : m_do_composite(true),
     m_color_table("Cool to Warm"),
     m_field_index(0),
-    m_has_color_table(true)
+    m_has_color_table(true),
+    m_cache_topology(false),
+    m_cache_owner(detail::next_cache_owner())
 {
   m_compositor  = new Compositor();
 }
@@ -23,6 +44,7 @@ Renderer::Renderer()
 Renderer::~Renderer()
 {
   delete m_compositor;
+  TopologyCache::ClearOwner(m_cache_owner);
 }
 
 void
@@ -50,6 +72,24 @@ Renderer::GetHasColorTable() const
   return m_has_color_table;
 }
 
+void
+Renderer::SetCacheTopology(bool on)
+{
+  m_cache_topology = on;
+}
+
+bool
+Renderer::GetCacheTopology() const
+{
+  return m_cache_topology;
+}
+
+std::string
+Renderer::GetCacheOwner() const
+{
+  return m_cache_owner;
+}
+
 void
 Renderer::SetDoComposite(bool do_composite)
 {
@@ -94,38 +134,47 @@ void
 Renderer::Composite(const int &num_images)
 {
   VTKH_DATA_OPEN("Composite");
-  m_compositor->SetCompositeMode(Compositor::Z_BUFFER_SURFACE);
+  assert(num_images == static_cast<int>(m_renders.size()));
+  CompositeSurfaces(m_renders, *m_compositor);
+  VTKH_DATA_CLOSE();
+}
+
+void
+Renderer::CompositeSurfaces(std::vector<vtkh::Render> &renders,
+                            Compositor &compositor)
+{
+  const int num_images = static_cast<int>(renders.size());
+  compositor.SetCompositeMode(Compositor::Z_BUFFER_SURFACE);
   for(int i = 0; i < num_images; ++i)
   {
-    const int num_canvases = m_renders[i].GetNumberOfCanvases();
+    const int num_canvases = renders[i].GetNumberOfCanvases();
 
     for(int dom = 0; dom < num_canvases; ++dom)
     {
-      float* color_buffer = &GetVTKMPointer(m_renders[i].GetCanvas(dom)->GetColorBuffer())[0][0];
-      float* depth_buffer = GetVTKMPointer(m_renders[i].GetCanvas(dom)->GetDepthBuffer());
+      float* color_buffer = &GetVTKMPointer(renders[i].GetCanvas(dom)->GetColorBuffer())[0][0];
+      float* depth_buffer = GetVTKMPointer(renders[i].GetCanvas(dom)->GetDepthBuffer());
 
-      int height = m_renders[i].GetCanvas(dom)->GetHeight();
-      int width = m_renders[i].GetCanvas(dom)->GetWidth();
+      int height = renders[i].GetCanvas(dom)->GetHeight();
+      int width = renders[i].GetCanvas(dom)->GetWidth();
 
-      m_compositor->AddImage(color_buffer,
-                             depth_buffer,
-                             width,
-                             height);
+      compositor.AddImage(color_buffer,
+                          depth_buffer,
+                          width,
+                          height);
     } //for dom
 
-    Image result = m_compositor->Composite();
+    Image result = compositor.Composite();
 
 #ifdef VTKH_PARALLEL
     if(vtkh::GetMPIRank() == 0)
     {
-      ImageToCanvas(result, *m_renders[i].GetCanvas(0), true);
+      ImageToCanvas(result, *renders[i].GetCanvas(0), true);
     }
 #else
-    ImageToCanvas(result, *m_renders[i].GetCanvas(0), true);
+    ImageToCanvas(result, *renders[i].GetCanvas(0), true);
 #endif
-    m_compositor->ClearImages();
+    compositor.ClearImages();
   } // for image
-  VTKH_DATA_CLOSE();
 }
 
 void
@@ -199,7 +248,6 @@ Renderer::DoExecute()
     throw Error(msg);
   }
 
-  int total_renders = static_cast<int>(m_renders.size());
   int num_domains = static_cast<int>(m_input->GetNumberOfDomains());
   for(int dom = 0; dom < num_domains; ++dom)
   {
@@ -217,33 +265,56 @@ Renderer::DoExecute()
     const vtkm::cont::CoordinateSystem &coords = data_set.GetCoordinateSystem();
     if(cellset.GetNumberOfCells() == 0) continue;
 
-    for(int i = 0; i < total_renders; ++i)
-    {
-      if(m_renders[i].GetShadingOn())
-      {
-        this->SetShadingOn(true);
-      }
-      else
-      {
-        this->SetShadingOn(false);
-      }
-
-      m_mapper->SetActiveColorTable(m_color_table);
-
-      vtkmCanvasPtr p_canvas = m_renders[i].GetDomainCanvas(domain_id);
-      const vtkmCamera &camera = m_renders[i].GetCamera();
-      m_mapper->SetCanvas(&(*p_canvas));
-      m_mapper->RenderCells(cellset,
-                            coords,
-                            field,
-                            m_color_table,
-                            camera,
-                            m_range);
+    this->SetDomainGeometry(domain_id, cellset, coords);
+    this->RenderDomain(domain_id, cellset, coords, field);
+    this->ClearDomainGeometry(domain_id);
+  }
+}
 
+void
+Renderer::RenderDomain(const vtkm::Id &domain_id,
+                       const vtkm::cont::DynamicCellSet &cellset,
+                       const vtkm::cont::CoordinateSystem &coords,
+                       const vtkm::cont::Field &field)
+{
+  int total_renders = static_cast<int>(m_renders.size());
+  for(int i = 0; i < total_renders; ++i)
+  {
+    if(m_renders[i].GetShadingOn())
+    {
+      this->SetShadingOn(true);
     }
+    else
+    {
+      this->SetShadingOn(false);
+    }
+
+    m_mapper->SetActiveColorTable(m_color_table);
+
+    vtkmCanvasPtr p_canvas = m_renders[i].GetDomainCanvas(domain_id);
+    const vtkmCamera &camera = m_renders[i].GetCamera();
+    m_mapper->SetCanvas(&(*p_canvas));
+    m_mapper->RenderCells(cellset,
+                          coords,
+                          field,
+                          m_color_table,
+                          camera,
+                          m_range);
   }
+}
 
+void
+Renderer::SetDomainGeometry(const vtkm::Id &vtkmNotUsed(domain_id),
+                            const vtkm::cont::DynamicCellSet &vtkmNotUsed(cellset),
+                            const vtkm::cont::CoordinateSystem &vtkmNotUsed(coords))
+{
+  // do nothing by default;
+}
 
+void
+Renderer::ClearDomainGeometry(const vtkm::Id &vtkmNotUsed(domain_id))
+{
+  // do nothing by default;
 }
 
 void
@@ -254,14 +325,7 @@ Renderer::ImageToCanvas(Image &image, vtkm::rendering::Canvas &canvas, bool get_
   const int size = width * height;
   const int color_size = size * 4;
   float* color_buffer = &GetVTKMPointer(canvas.GetColorBuffer())[0][0];
-  float one_over_255 = 1.f / 255.f;
-#ifdef VTKH_USE_OPENMP
-  #pragma omp parallel for
-#endif
-  for(int i = 0; i < color_size; ++i)
-  {
-    color_buffer[i] = static_cast<float>(image.m_pixels[i]) * one_over_255;
-  }
+  PixelKernels::UCharToFloat(image.m_pixels.data(), color_buffer, color_size);
 
   float* depth_buffer = GetVTKMPointer(canvas.GetDepthBuffer());
   if(get_depth) memcpy(depth_buffer, &image.m_depths[0], sizeof(float) * size);
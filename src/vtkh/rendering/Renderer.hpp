@@ -36,6 +36,11 @@ public:
   void SetDoComposite(bool do_composite);
   void SetRenders(const std::vector<Render> &renders);
   void SetRange(const vtkm::Range &range);
+  // keep geometry derived from the mesh across cycles while the cell
+  // set and coordinates stay the same (see TopologyCache). Entries
+  // belong to this renderer and are dropped with it, so it has to live
+  // across cycles for the cache to hit
+  void SetCacheTopology(bool on);
 
   vtkm::cont::ColorTable      GetColorTable() const;
   std::string                 GetFieldName() const;
@@ -44,6 +49,15 @@ public:
   vtkh::DataSet              *GetInput();
   vtkm::Range                 GetRange() const;
   bool                        GetHasColorTable() const;
+  bool                        GetCacheTopology() const;
+  // owner of this renderer's entries in the TopologyCache
+  std::string                 GetCacheOwner() const;
+
+  // z-buffer composites the canvases of each render into its first
+  // canvas on rank 0. Scene uses this to composite a finished batch
+  // while the renderers work on the next one
+  static void CompositeSurfaces(std::vector<vtkh::Render> &renders,
+                                Compositor &compositor);
 protected:
 
   // image related data with cinema support
@@ -57,13 +71,29 @@ protected:
   vtkm::Range                              m_range;
   vtkm::cont::ColorTable                   m_color_table;
   bool                                     m_has_color_table;
+  bool                                     m_cache_topology;
+  // unique per renderer, prefixes the owner of its TopologyCache entries
+  std::string                              m_cache_owner;
   // methods
   virtual void PreExecute() override;
   virtual void PostExecute() override;
   virtual void DoExecute() override;
 
+  // called once per domain around the loop over renders so that
+  // sub-classes can build view independent state (e.g. a bvh) once
+  // and reuse it for every camera in the batch
+  virtual void SetDomainGeometry(const vtkm::Id &domain_id,
+                                 const vtkm::cont::DynamicCellSet &cellset,
+                                 const vtkm::cont::CoordinateSystem &coords);
+  virtual void ClearDomainGeometry(const vtkm::Id &domain_id);
+  // renders one domain into the canvas of every render
+  virtual void RenderDomain(const vtkm::Id &domain_id,
+                            const vtkm::cont::DynamicCellSet &cellset,
+                            const vtkm::cont::CoordinateSystem &coords,
+                            const vtkm::cont::Field &field);
+
   virtual void Composite(const int &num_images);
-  void ImageToCanvas(Image &image, vtkm::rendering::Canvas &canvas, bool get_depth);
+  static void ImageToCanvas(Image &image, vtkm::rendering::Canvas &canvas, bool get_depth);
 };
 
 } // namespace vtkh
@@ -1,14 +1,132 @@
 #include <vtkh/rendering/Scene.hpp>
 #include <vtkh/rendering/MeshRenderer.hpp>
 #include <vtkh/rendering/VolumeRenderer.hpp>
+#include <vtkh/Error.hpp>
+#include <vtkh/Logger.hpp>
+#include <vtkh/Timer.hpp>
+#include <vtkh/rendering/compositing/Compositor.hpp>
+#include <vtkh/rendering/compositing/PartialCompositor.hpp>
+#include <vtkh/utils/PNGEncoder.hpp>
 
+#include <algorithm>
+#include <limits>
+#include <string.h>
+
+#ifdef VTKH_PARALLEL
+#include <mpi.h>
+#endif
+
+namespace vtkh
+{
+namespace detail
+{
+
+// the compositing thread and the rendering thread both make MPI calls
+bool threads_can_communicate()
+{
+#ifdef VTKH_PARALLEL
+  int provided;
+  MPI_Query_thread(&provided);
+  return provided == MPI_THREAD_MULTIPLE;
+#else
+  return true;
+#endif
+}
+
+#ifdef VTKH_PARALLEL
+// frees the communicator the pipelined batches composite over, however
+// Render exits
+struct PipelineComm
+{
+  MPI_Comm m_comm;
+  PipelineComm()
+    : m_comm(MPI_COMM_NULL)
+  {
+  }
+  ~PipelineComm()
+  {
+    if(m_comm != MPI_COMM_NULL)
+    {
+      MPI_Comm_free(&m_comm);
+    }
+  }
+};
+#endif
+
+//
+// Waits for the batch compositing on the second thread and rethrows its
+// failure. Ranks agree on the outcome first, so when one rank's batch
+// fails every rank stops instead of entering the next batch's
+// collectives alone.
+//
+void wait_for_composite(AsyncQueue &comm_thread)
+{
+  int failed = 0;
+  std::string message;
+  try
+  {
+    comm_thread.Flush();
+  }
+  catch(const std::exception &e)
+  {
+    failed = 1;
+    message = e.what();
+  }
+  catch(...)
+  {
+    failed = 1;
+    message = "unknown error";
+  }
+
+#ifdef VTKH_PARALLEL
+  MPI_Comm comm = MPI_Comm_f2c(vtkh::GetMPICommHandle());
+  int any_failed = 0;
+  MPI_Allreduce(&failed, &any_failed, 1, MPI_INT, MPI_MAX, comm);
+  if(any_failed && !failed)
+  {
+    failed = 1;
+    message = "failed on another rank";
+  }
+#endif
+
+  if(failed)
+  {
+    throw Error("Scene: compositing a pipelined batch failed: " + message);
+  }
+}
+
+//
+// Flushes the background image writer when Scene::Render leaves on an
+// exception, so queued saves do not outlive the call and run during
+// static destruction. The exception already in flight is the one
+// reported.
+//
+struct SaveFlushGuard
+{
+  ~SaveFlushGuard()
+  {
+    try
+    {
+      vtkh::Render::FlushSaves();
+    }
+    catch(...)
+    {
+    }
+  }
+};
+
+} // namespace detail
+} // namespace vtkh
 
 namespace vtkh
 {
 
 Scene::Scene()
   : m_has_volume(false),
-    m_batch_size(10)
+    m_batch_size(10),
+    m_auto_batch_size(false),
+    m_memory_budget(size_t(1) << 30),
+    m_pipelined(false)
 {
 
 }
@@ -23,6 +141,89 @@ Scene::SetRenderBatchSize(int batch_size)
 {
   assert(batch_size > 0);
   m_batch_size = batch_size;
+  m_auto_batch_size = false;
+}
+
+void
+Scene::SetMemoryBudget(size_t bytes)
+{
+  m_memory_budget = bytes;
+  m_auto_batch_size = true;
+}
+
+size_t
+Scene::GetMemoryBudget() const
+{
+  return m_memory_budget;
+}
+
+void
+Scene::SetPipelined(bool on)
+{
+  m_pipelined = on;
+}
+
+bool
+Scene::GetPipelined() const
+{
+  return m_pipelined;
+}
+
+//
+// Every render in a batch keeps its canvases (color and depth) until the
+// batch is saved: one per local domain when there is a volume plot, one
+// otherwise. Renderers draw into the same canvases, so they do not add
+// to this. Compositing works on one render at a time, so its buffers are
+// only counted once. So are the canvases held by the background writer.
+// A pipelined scene keeps two batches alive.
+//
+int
+Scene::ComputeBatchSize(const int batches_in_flight)
+{
+  const size_t pixel_bytes = sizeof(vtkm::Vec<vtkm::Float32,4>) + sizeof(vtkm::Float32);
+  size_t render_bytes = 0;
+  size_t composite_bytes = 0;
+  size_t canvas_bytes = 0;
+  const int render_size = static_cast<int>(m_renders.size());
+  for(int i = 0; i < render_size; ++i)
+  {
+    vtkh::Render probe = m_renders[i];
+    probe.SetSingleCanvas(!m_has_volume);
+    const size_t pixels = size_t(probe.GetWidth()) * size_t(probe.GetHeight());
+    const size_t canvases = probe.GetNumberOfCanvases();
+    render_bytes = std::max(render_bytes, canvases * pixels * pixel_bytes);
+    canvas_bytes = std::max(canvas_bytes, pixels * pixel_bytes);
+    // rgba8 + depth images for surfaces, partials for volumes
+    const size_t composite_pixel = m_has_volume ? sizeof(VolumePartial<float>) : 2 * 8;
+    composite_bytes = std::max(composite_bytes, canvases * pixels * composite_pixel);
+  }
+
+  size_t reserved = composite_bytes;
+  if(vtkh::Render::GetAsyncSave() && vtkh::GetMPIRank() == 0)
+  {
+    reserved += vtkh::Render::GetSaveQueue().GetMaxSize() * canvas_bytes;
+  }
+
+  long long int batch_size = 1;
+  if(render_bytes > 0 && m_memory_budget > reserved)
+  {
+    batch_size = std::max<long long int>(1, (m_memory_budget - reserved) /
+                                            (render_bytes * batches_in_flight));
+  }
+  batch_size = std::min<long long int>(batch_size, std::max(render_size, 1));
+
+#ifdef VTKH_PARALLEL
+  // every rank has to composite the same renders together
+  MPI_Comm comm = MPI_Comm_f2c(vtkh::GetMPICommHandle());
+  long long int local_size = batch_size;
+  MPI_Allreduce(&local_size, &batch_size, 1, MPI_LONG_LONG_INT, MPI_MIN, comm);
+#endif
+
+  VTKH_DATA_ADD("render_bytes", render_bytes);
+  VTKH_DATA_ADD("reserved_bytes", reserved);
+  VTKH_DATA_ADD("memory_budget", m_memory_budget);
+  VTKH_DATA_ADD("render_batch_size", batch_size);
+  return static_cast<int>(batch_size);
 }
 
 int
@@ -116,6 +317,7 @@ Scene::AddRenderer(vtkh::Renderer *renderer)
 void
 Scene::Render()
 {
+  detail::SaveFlushGuard flush_guard;
 
   std::vector<vtkm::Range> ranges;
   std::vector<std::string> field_names;
@@ -123,6 +325,28 @@ Scene::Render()
 
   bool do_once = true;
 
+  std::vector<vtkh::Render> all_renders;
+  std::vector<vtkh::Render> tiled;
+  for(size_t i = 0; i < m_renders.size(); ++i)
+  {
+    if(m_renders[i].IsTiled())
+    {
+      tiled.push_back(m_renders[i]);
+    }
+  }
+  if(!tiled.empty())
+  {
+    // tiled renders do not take part in batching
+    all_renders.swap(m_renders);
+    for(size_t i = 0; i < all_renders.size(); ++i)
+    {
+      if(!all_renders[i].IsTiled())
+      {
+        m_renders.push_back(all_renders[i]);
+      }
+    }
+  }
+
   //
   // We are going to render images in batches. With databases
   // like Cinema, we could be rendering hundres of images. Keeping
@@ -132,20 +356,74 @@ Scene::Render()
   // are limited.
   //
   const int render_size = m_renders.size();
-  int batch_start = 0;
-  while(batch_start < render_size)
+  const bool pipeline = m_pipelined && !m_has_volume && detail::threads_can_communicate();
+  if(m_pipelined && !pipeline)
   {
-    int batch_end = std::min(m_batch_size + batch_start, render_size);
-    auto begin = m_renders.begin() + batch_start;
-    auto end = m_renders.begin() + batch_end;
+    VTKH_INFO("Scene: pipelining needs MPI_THREAD_MULTIPLE and no volume plot");
+  }
+  if(m_auto_batch_size)
+  {
+    m_batch_size = ComputeBatchSize(pipeline ? 2 : 1);
+  }
 
-    std::vector<vtkh::Render> current_batch(begin, end);
+  //
+  // When pipelined, the last batch is composited on a second thread
+  // over its own communicator while this thread renders the next one.
+  // At most two batches of canvases exist at any time.
+  //
+#ifdef VTKH_PARALLEL
+  // declared first so the compositing thread is joined before it is freed
+  detail::PipelineComm pipeline_comm;
+#endif
+  Compositor compositor;
+  AsyncQueue comm_thread;
+  comm_thread.SetMaxSize(1);
+  std::shared_ptr<std::vector<vtkh::Render>> in_flight;
+  int in_flight_start = 0;
+  double pipeline_wait_time = 0.;
+#ifdef VTKH_PARALLEL
+  if(pipeline)
+  {
+    MPI_Comm_dup(MPI_Comm_f2c(vtkh::GetMPICommHandle()), &pipeline_comm.m_comm);
+    compositor.SetMPICommHandle(MPI_Comm_c2f(pipeline_comm.m_comm));
+  }
+#endif
+
+  auto finish_batch = [&](std::vector<vtkh::Render> &batch, const int start)
+  {
+    // render screen annotations last and save
+    for(int i = 0; i < batch.size(); ++i)
+    {
+      batch[i].RenderWorldAnnotations();
+      batch[i].RenderScreenAnnotations(field_names, ranges, color_tables);
+      batch[i].RenderBackground();
+      if(vtkh::Render::GetAsyncSave())
+      {
+        batch[i].SaveAsync();
+      }
+      else
+      {
+        batch[i].Save();
+      }
+      // free buffers
+      m_renders[start + i].ClearCanvases();
+    }
+  };
+
+  auto render_batch = [&](std::vector<vtkh::Render> &batch, const bool composite)
+  {
+    // surfaces depth test into a shared canvas, but volume rendering
+    // blends domains in visibility order and needs a canvas per domain
+    for(int i = 0; i < batch.size(); ++i)
+    {
+      batch[i].SetSingleCanvas(!m_has_volume);
+    }
     const int plot_size = m_renderers.size();
     auto renderer = m_renderers.begin();
 
     for(int i = 0; i < plot_size; ++i)
     {
-      if(i == plot_size - 1)
+      if(i == plot_size - 1 && composite)
       {
         (*renderer)->SetDoComposite(true);
       }
@@ -154,7 +432,7 @@ Scene::Render()
         (*renderer)->SetDoComposite(false);
       }
 
-      (*renderer)->SetRenders(current_batch);
+      (*renderer)->SetRenders(batch);
       (*renderer)->Update();
 
       // we only need to get the ranges and color tables once
@@ -169,25 +447,168 @@ Scene::Render()
         do_once = false;
       }
 
-      current_batch  = (*renderer)->GetRenders();
+      batch  = (*renderer)->GetRenders();
       (*renderer)->ClearRenders();
 
       renderer++;
     }
+  };
 
-    // render screen annotations last and save
-    for(int i = 0; i < current_batch.size(); ++i)
+  int batch_start = 0;
+  while(batch_start < render_size)
+  {
+    int batch_end = std::min(m_batch_size + batch_start, render_size);
+    auto begin = m_renders.begin() + batch_start;
+    auto end = m_renders.begin() + batch_end;
+
+    std::vector<vtkh::Render> current_batch(begin, end);
+    render_batch(current_batch, !pipeline);
+
+    if(!pipeline)
     {
-      current_batch[i].RenderWorldAnnotations();
-      current_batch[i].RenderScreenAnnotations(field_names, ranges, color_tables);
-      current_batch[i].RenderBackground();
-      current_batch[i].Save();
-      // free buffers
-      m_renders[batch_start + i].ClearCanvases();
+      finish_batch(current_batch, batch_start);
+    }
+    else
+    {
+      // the previous batch was compositing while this one rendered
+      if(in_flight)
+      {
+        vtkh::Timer wait_timer;
+        detail::wait_for_composite(comm_thread);
+        pipeline_wait_time += wait_timer.elapsed();
+        finish_batch(*in_flight, in_flight_start);
+      }
+      in_flight = std::make_shared<std::vector<vtkh::Render>>(current_batch);
+      in_flight_start = batch_start;
+      std::shared_ptr<std::vector<vtkh::Render>> batch = in_flight;
+      comm_thread.Push([batch, &compositor]()
+      {
+        Renderer::CompositeSurfaces(*batch, compositor);
+      });
     }
 
     batch_start = batch_end;
   } // while
+
+  if(in_flight)
+  {
+    vtkh::Timer wait_timer;
+    detail::wait_for_composite(comm_thread);
+    pipeline_wait_time += wait_timer.elapsed();
+    finish_batch(*in_flight, in_flight_start);
+    VTKH_DATA_ADD("pipeline_wait_time", pipeline_wait_time);
+  }
+  //
+  // A tiled render is rendered and composited one tile at a time. Rank 0
+  // gathers a row of tiles into a band and hands it to the png writer
+  // through the save queue, so at most one tile of canvases plus the
+  // queued bands are alive. Screen annotations (color bars, titles) are
+  // skipped, and world annotations are drawn per tile with the tile's
+  // zoomed camera. A failed write is thrown from the flush below.
+  //
+  AsyncQueue &save_queue = vtkh::Render::GetSaveQueue();
+  auto save = [&save_queue](AsyncQueue::Job job)
+  {
+    if(vtkh::Render::GetAsyncSave())
+    {
+      save_queue.Push(job);
+    }
+    else
+    {
+      job();
+    }
+  };
+
+  const bool is_root = vtkh::GetMPIRank() == 0;
+  for(size_t i = 0; i < tiled.size(); ++i)
+  {
+    vtkh::Render &render = tiled[i];
+    const int width = render.GetWidth();
+    const int num_tiles = render.GetNumberOfTiles();
+    VTKH_DATA_OPEN("tiled_render");
+    VTKH_DATA_ADD("tiles", num_tiles);
+
+    std::shared_ptr<TiledPNGWriter> writer;
+    std::shared_ptr<std::vector<unsigned char>> band;
+    if(is_root)
+    {
+      writer = std::make_shared<TiledPNGWriter>();
+      writer->SetCompressionLevel(render.GetCompressionLevel());
+      const std::string name = render.GetImageName() + ".png";
+      const int height = render.GetHeight();
+      save([writer, name, width, height]()
+      {
+        if(!writer->Open(name, width, height))
+        {
+          throw Error("Scene: failed to open tiled png '" + name + "'");
+        }
+      });
+    }
+
+    for(int tile = 0; tile < num_tiles; ++tile)
+    {
+      std::vector<vtkh::Render> tile_batch(1, render.GetTile(tile));
+      render_batch(tile_batch, true);
+      tile_batch[0].RenderWorldAnnotations();
+      tile_batch[0].RenderBackground();
+      tile_batch[0].Save();
+
+      if(!is_root)
+      {
+        continue;
+      }
+
+      int x, y, tile_width, tile_height;
+      render.GetTileViewport(tile, x, y, tile_width, tile_height);
+      if(x == 0)
+      {
+        band = std::make_shared<std::vector<unsigned char>>(size_t(width) * tile_height * 4);
+      }
+      const Image &image = tile_batch[0].GetImage();
+      for(int row = 0; row < tile_height; ++row)
+      {
+        memcpy(&(*band)[(size_t(row) * width + x) * 4],
+               &image.m_pixels[size_t(row) * tile_width * 4],
+               tile_width * 4);
+      }
+      if(x + tile_width == width)
+      {
+        save([writer, band, tile_height]()
+        {
+          if(!writer->AddBand(band->data(), tile_height))
+          {
+            throw Error("Scene: failed to write a band of a tiled png");
+          }
+        });
+        band.reset();
+      }
+    }
+
+    if(is_root)
+    {
+      save([writer]()
+      {
+        if(!writer->Close())
+        {
+          throw Error("Scene: failed to finish a tiled png");
+        }
+      });
+    }
+    VTKH_DATA_CLOSE();
+  }
+
+  if(!tiled.empty())
+  {
+    m_renders.swap(all_renders);
+  }
+
+  // make sure every image is on disk before returning
+  VTKH_DATA_ADD("save_queue_peak_size", save_queue.GetPeakSize());
+  VTKH_DATA_ADD("save_queue_wait_time", save_queue.GetWaitTime());
+  vtkh::Timer flush_timer;
+  vtkh::Render::FlushSaves();
+  VTKH_DATA_ADD("save_flush_time", flush_timer.elapsed());
+  save_queue.ResetStatistics();
 }
 
 void
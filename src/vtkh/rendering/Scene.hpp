@@ -17,6 +17,9 @@ private:
   std::vector<vtkh::Render>    m_renders;
   bool                         m_has_volume;
   int                          m_batch_size;
+  bool                         m_auto_batch_size;
+  size_t                       m_memory_budget;
+  bool                         m_pipelined;
 public:
  Scene();
  ~Scene();
@@ -26,9 +29,23 @@ public:
   void AddRenderer(vtkh::Renderer *render);
   void Render();
   void Save();
+  // renders are done in batches so that not every canvas is alive at
+  // once (default 10). A fixed batch size turns off the memory budget
   void SetRenderBatchSize(int batch_size);
+  // the last batch size used
   int  GetRenderBatchSize() const;
+  // per rank bytes allowed for canvases and compositing. Setting it
+  // makes the batch size be chosen from the image sizes and local domain
+  // count instead, which costs a reduction across ranks per Render
+  void SetMemoryBudget(size_t bytes);
+  size_t GetMemoryBudget() const;
+  // composite each batch on a second thread while the next batch
+  // renders. Needs MPI_THREAD_MULTIPLE and a scene without a volume
+  // plot, otherwise batches run one after another
+  void SetPipelined(bool on);
+  bool GetPipelined() const;
 protected:
+  int  ComputeBatchSize(const int batches_in_flight);
   bool IsMesh(vtkh::Renderer *renderer);
   bool IsVolume(vtkh::Renderer *renderer);
 }; // class scene
@@ -0,0 +1,187 @@
+#include "TopologyCache.hpp"
+
+#include <vtkh/Logger.hpp>
+
+#include <vtkm/cont/ArrayHandleUniformPointCoordinates.h>
+#include <vtkm/cont/CellSetExplicit.h>
+#include <vtkm/cont/CellSetSingleType.h>
+#include <vtkm/cont/CellSetStructured.h>
+
+#include <limits>
+#include <map>
+#include <utility>
+
+namespace vtkh {
+
+namespace detail
+{
+
+struct CacheEntry
+{
+  vtkm::cont::DynamicCellSet   m_cellset;
+  vtkm::cont::CoordinateSystem m_coords;
+  std::shared_ptr<void>        m_geometry;
+};
+
+typedef std::pair<std::string, vtkm::Id> CacheKey;
+
+std::map<CacheKey, CacheEntry> &
+cache_entries()
+{
+  static std::map<CacheKey, CacheEntry> entries;
+  return entries;
+}
+
+template<typename CellSetType>
+bool same_connectivity(const vtkm::cont::DynamicCellSet &a,
+                       const vtkm::cont::DynamicCellSet &b)
+{
+  // copies share the underlying arrays
+  CellSetType cell_set_a = a.Cast<CellSetType>();
+  CellSetType cell_set_b = b.Cast<CellSetType>();
+  return cell_set_a.GetConnectivityArray(vtkm::TopologyElementTagCell(),
+                                         vtkm::TopologyElementTagPoint()) ==
+         cell_set_b.GetConnectivityArray(vtkm::TopologyElementTagCell(),
+                                         vtkm::TopologyElementTagPoint());
+}
+
+template<vtkm::IdComponent DIMS>
+bool same_dims(const vtkm::cont::DynamicCellSet &a,
+               const vtkm::cont::DynamicCellSet &b)
+{
+  typedef vtkm::cont::CellSetStructured<DIMS> StructuredType;
+  return a.Cast<StructuredType>().GetPointDimensions() ==
+         b.Cast<StructuredType>().GetPointDimensions();
+}
+
+bool same_cellset(const vtkm::cont::DynamicCellSet &a,
+                  const vtkm::cont::DynamicCellSet &b)
+{
+  if(a.GetNumberOfCells() != b.GetNumberOfCells() ||
+     a.GetNumberOfPoints() != b.GetNumberOfPoints())
+  {
+    return false;
+  }
+
+  if(a.IsSameType(vtkm::cont::CellSetExplicit<>()))
+  {
+    return b.IsSameType(vtkm::cont::CellSetExplicit<>()) &&
+           same_connectivity<vtkm::cont::CellSetExplicit<>>(a, b);
+  }
+  else if(a.IsSameType(vtkm::cont::CellSetSingleType<>()))
+  {
+    return b.IsSameType(vtkm::cont::CellSetSingleType<>()) &&
+           same_connectivity<vtkm::cont::CellSetSingleType<>>(a, b);
+  }
+  else if(a.IsSameType(vtkm::cont::CellSetStructured<3>()))
+  {
+    return b.IsSameType(vtkm::cont::CellSetStructured<3>()) && same_dims<3>(a, b);
+  }
+  else if(a.IsSameType(vtkm::cont::CellSetStructured<2>()))
+  {
+    return b.IsSameType(vtkm::cont::CellSetStructured<2>()) && same_dims<2>(a, b);
+  }
+  else if(a.IsSameType(vtkm::cont::CellSetStructured<1>()))
+  {
+    return b.IsSameType(vtkm::cont::CellSetStructured<1>()) && same_dims<1>(a, b);
+  }
+
+  // unknown cell set type, never reuse
+  return false;
+}
+
+bool same_coords(const vtkm::cont::CoordinateSystem &a,
+                 const vtkm::cont::CoordinateSystem &b)
+{
+  if(a.GetNumberOfPoints() != b.GetNumberOfPoints())
+  {
+    return false;
+  }
+
+  if(a.GetData() == b.GetData())
+  {
+    return true;
+  }
+
+  // uniform coordinates are usually recreated every cycle, but they
+  // are fully described by their origin and spacing
+  typedef vtkm::cont::ArrayHandleUniformPointCoordinates UniformType;
+  if(a.GetData().IsType<UniformType>() && b.GetData().IsType<UniformType>())
+  {
+    auto portal_a = a.GetData().Cast<UniformType>().GetPortalConstControl();
+    auto portal_b = b.GetData().Cast<UniformType>().GetPortalConstControl();
+    return portal_a.GetOrigin() == portal_b.GetOrigin() &&
+           portal_a.GetSpacing() == portal_b.GetSpacing() &&
+           portal_a.GetRange3() == portal_b.GetRange3();
+  }
+
+  return false;
+}
+
+} // namespace detail
+
+std::shared_ptr<void>
+TopologyCache::FindEntry(const std::string &owner,
+                         const vtkm::Id &domain_id,
+                         const vtkm::cont::DynamicCellSet &cellset,
+                         const vtkm::cont::CoordinateSystem &coords)
+{
+  auto &entries = detail::cache_entries();
+  auto it = entries.find(std::make_pair(owner, domain_id));
+  if(it == entries.end())
+  {
+    return nullptr;
+  }
+
+  if(!detail::same_cellset(it->second.m_cellset, cellset) ||
+     !detail::same_coords(it->second.m_coords, coords))
+  {
+    // the topology changed, so the entry is stale
+    entries.erase(it);
+    VTKH_DATA_ADD("topology_cache_miss", owner);
+    return nullptr;
+  }
+
+  VTKH_DATA_ADD("topology_cache_hit", owner);
+  return it->second.m_geometry;
+}
+
+void
+TopologyCache::Insert(const std::string &owner,
+                      const vtkm::Id &domain_id,
+                      const vtkm::cont::DynamicCellSet &cellset,
+                      const vtkm::cont::CoordinateSystem &coords,
+                      std::shared_ptr<void> geometry)
+{
+  detail::CacheEntry entry;
+  entry.m_cellset = cellset;
+  entry.m_coords = coords;
+  entry.m_geometry = geometry;
+  detail::cache_entries()[std::make_pair(owner, domain_id)] = entry;
+}
+
+void
+TopologyCache::Clear()
+{
+  detail::cache_entries().clear();
+}
+
+void
+TopologyCache::ClearOwner(const std::string &owner_prefix)
+{
+  auto &entries = detail::cache_entries();
+  auto it = entries.lower_bound(std::make_pair(owner_prefix, std::numeric_limits<vtkm::Id>::lowest()));
+  while(it != entries.end() &&
+        it->first.first.compare(0, owner_prefix.size(), owner_prefix) == 0)
+  {
+    it = entries.erase(it);
+  }
+}
+
+int
+TopologyCache::GetNumberOfEntries()
+{
+  return static_cast<int>(detail::cache_entries().size());
+}
+
+} // namespace vtkh
@@ -0,0 +1,52 @@
+#ifndef VTK_H_TOPOLOGY_CACHE_HPP
+#define VTK_H_TOPOLOGY_CACHE_HPP
+
+#include <memory>
+#include <string>
+#include <vtkh/vtkh_exports.h>
+
+#include <vtkm/cont/CoordinateSystem.h>
+#include <vtkm/cont/DynamicCellSet.h>
+
+namespace vtkh {
+
+//
+// Keeps geometry derived from a domain's topology (triangles, bvhs, edges)
+// across cycles. Entries are keyed on the owner (a string unique to each
+// renderer instance) and domain id, and are only returned while the
+// domain still has the same topology: the same cell set and coordinate
+// array handles, or for uniform coordinates the same origin and spacing.
+// Handles that are modified in place cannot be detected, so simulations
+// that do this must call Clear when the mesh changes.
+//
+class VTKH_API TopologyCache
+{
+public:
+  template<typename GeometryType>
+  static std::shared_ptr<GeometryType> Find(const std::string &owner,
+                                            const vtkm::Id &domain_id,
+                                            const vtkm::cont::DynamicCellSet &cellset,
+                                            const vtkm::cont::CoordinateSystem &coords)
+  {
+    return std::static_pointer_cast<GeometryType>(FindEntry(owner, domain_id, cellset, coords));
+  }
+
+  static void Insert(const std::string &owner,
+                     const vtkm::Id &domain_id,
+                     const vtkm::cont::DynamicCellSet &cellset,
+                     const vtkm::cont::CoordinateSystem &coords,
+                     std::shared_ptr<void> geometry);
+
+  static void Clear();
+  // removes the entries of every owner starting with the prefix
+  static void ClearOwner(const std::string &owner_prefix);
+  static int  GetNumberOfEntries();
+protected:
+  static std::shared_ptr<void> FindEntry(const std::string &owner,
+                                         const vtkm::Id &domain_id,
+                                         const vtkm::cont::DynamicCellSet &cellset,
+                                         const vtkm::cont::CoordinateSystem &coords);
+};
+
+} // namespace vtkh
+#endif
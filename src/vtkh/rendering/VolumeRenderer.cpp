@@ -1,10 +1,17 @@
 #include "VolumeRenderer.hpp"
 
+#include <vtkh/Logger.hpp>
 #include <vtkh/utils/vtkm_array_utils.hpp>
+#include <vtkh/utils/vtkm_dataset_info.hpp>
+#include <vtkh/vtkm_filters/vtkmExtractStructured.hpp>
 #include <vtkh/rendering/compositing/Compositor.hpp>
+#include <vtkh/rendering/compositing/PartialCompositor.hpp>
 
 #include <vtkm/rendering/CanvasRayTracer.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 
 #ifdef VTKH_PARALLEL
@@ -49,6 +56,302 @@ namespace detail
       return false;
     }
   };
+
+  //
+  // Pull the pixels a domain touched out of its canvas. The
+  // visibility order stands in for depth so the partials of a pixel
+  // sort front to back the same way the full images would blend.
+  //
+  void ExtractPartials(vtkm::rendering::Canvas &canvas,
+                       const int vis_order,
+                       std::vector<VolumePartial<float>> &partials)
+  {
+    const int size = canvas.GetWidth() * canvas.GetHeight();
+    const float *colors = &GetVTKMPointer(canvas.GetColorBuffer())[0][0];
+    const float *depths = GetVTKMPointer(canvas.GetDepthBuffer());
+
+    int count = 0;
+#ifdef VTKH_USE_OPENMP
+    #pragma omp parallel for reduction(+:count)
+#endif
+    for(int i = 0; i < size; ++i)
+    {
+      if(colors[i * 4 + 3] > 0.f) count++;
+    }
+
+    partials.resize(count);
+    int index = 0;
+    for(int i = 0; i < size; ++i)
+    {
+      const float *color = colors + i * 4;
+      if(color[3] == 0.f) continue;
+      VolumePartial<float> &partial = partials[index++];
+      partial.m_pixel_id = i;
+      partial.m_depth = static_cast<float>(vis_order);
+      partial.m_pixel[0] = color[0];
+      partial.m_pixel[1] = color[1];
+      partial.m_pixel[2] = color[2];
+      partial.m_alpha = color[3];
+      partial.m_front_depth = depths[i];
+    }
+  }
+
+  //
+  // Write the composited partials into the canvas. Pixels no domain
+  // touched are cleared. The depth is the nearest depth of the pixel's
+  // partials, so annotations depth test against every domain, not
+  // just the ones that were rendered into this canvas.
+  //
+  void PartialsToCanvas(const std::vector<VolumePartial<float>> &partials,
+                        vtkm::rendering::Canvas &canvas)
+  {
+    const int size = canvas.GetWidth() * canvas.GetHeight();
+    float *colors = &GetVTKMPointer(canvas.GetColorBuffer())[0][0];
+    float *depths = GetVTKMPointer(canvas.GetDepthBuffer());
+    std::fill(colors, colors + size * 4, 0.f);
+    std::fill(depths, depths + size, 1.001f);
+
+    const int num_partials = static_cast<int>(partials.size());
+#ifdef VTKH_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < num_partials; ++i)
+    {
+      const VolumePartial<float> &partial = partials[i];
+      float *color = colors + partial.m_pixel_id * 4;
+      color[0] = partial.m_pixel[0];
+      color[1] = partial.m_pixel[1];
+      color[2] = partial.m_pixel[2];
+      color[3] = partial.m_alpha;
+      depths[partial.m_pixel_id] = partial.m_front_depth;
+    }
+  }
+
+  //
+  // Min and max of a scalar field over blocks of cells. A point field
+  // also takes the points on the far side of each block, since every
+  // sample in a cell interpolates all of its corners.
+  //
+  struct MacrocellFunctor
+  {
+    int m_dims[3];       // values per axis
+    int m_macro_dims[3]; // macrocells per axis
+    int m_size;          // cells per macrocell side
+    int m_overlap;       // 1 for point fields
+    std::vector<vtkm::Float64> m_min;
+    std::vector<vtkm::Float64> m_max;
+
+    template<typename T, typename S>
+    void operator()(const vtkm::cont::ArrayHandle<T,S> &array)
+    {
+      auto portal = array.GetPortalConstControl();
+      const int total = m_macro_dims[0] * m_macro_dims[1] * m_macro_dims[2];
+      m_min.resize(total);
+      m_max.resize(total);
+#ifdef VTKH_USE_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int m = 0; m < total; ++m)
+      {
+        const int mx = m % m_macro_dims[0];
+        const int my = (m / m_macro_dims[0]) % m_macro_dims[1];
+        const int mz = m / (m_macro_dims[0] * m_macro_dims[1]);
+        const int x0 = mx * m_size;
+        const int y0 = my * m_size;
+        const int z0 = mz * m_size;
+        const int x1 = std::min(x0 + m_size + m_overlap, m_dims[0]);
+        const int y1 = std::min(y0 + m_size + m_overlap, m_dims[1]);
+        const int z1 = std::min(z0 + m_size + m_overlap, m_dims[2]);
+        vtkm::Float64 lo = std::numeric_limits<vtkm::Float64>::max();
+        vtkm::Float64 hi = std::numeric_limits<vtkm::Float64>::lowest();
+        for(int z = z0; z < z1; ++z)
+        {
+          for(int y = y0; y < y1; ++y)
+          {
+            const vtkm::Id row = (vtkm::Id(z) * m_dims[1] + y) * m_dims[0];
+            for(int x = x0; x < x1; ++x)
+            {
+              const vtkm::Float64 value = static_cast<vtkm::Float64>(portal.Get(row + x));
+              lo = std::min(lo, value);
+              hi = std::max(hi, value);
+            }
+          }
+        }
+        m_min[m] = lo;
+        m_max[m] = hi;
+      }
+    }
+  };
+
+  //
+  // Answers whether a range of scalars maps to zero opacity. The
+  // scalar range is mapped onto the range of the color table the same
+  // way the mapper samples it. Alpha is interpolated between control
+  // points, so it can only be non-zero in a span that touches a
+  // non-zero point. A range is transparent when every point inside
+  // it, and the closest one on each side, has zero alpha.
+  //
+  class AlphaTest
+  {
+  public:
+    AlphaTest(const vtkm::cont::ColorTable &color_table,
+              const vtkm::Range &scalar_range)
+      : m_scalar_range(scalar_range),
+        m_table_range(color_table.GetRange())
+    {
+      const int num_points = color_table.GetNumberOfPointsAlpha();
+      for(int i = 0; i < num_points; ++i)
+      {
+        vtkm::Vec<vtkm::Float64,4> point;
+        color_table.GetPointAlpha(i, point);
+        m_x.push_back(point[0]);
+        m_alpha.push_back(point[1]);
+      }
+    }
+
+    bool IsTransparent(const vtkm::Float64 lo, const vtkm::Float64 hi) const
+    {
+      const int num_points = static_cast<int>(m_x.size());
+      if(num_points == 0)
+      {
+        return false;
+      }
+      const vtkm::Float64 a = ToTable(lo);
+      const vtkm::Float64 b = ToTable(hi);
+      int left = -1;
+      int right = -1;
+      for(int i = 0; i < num_points; ++i)
+      {
+        if(m_x[i] < a)
+        {
+          left = i;
+        }
+        else if(m_x[i] > b)
+        {
+          right = i;
+          break;
+        }
+        else if(m_alpha[i] > 0.)
+        {
+          return false;
+        }
+      }
+      if(left != -1 && m_alpha[left] > 0.) return false;
+      if(right != -1 && m_alpha[right] > 0.) return false;
+      return true;
+    }
+
+  protected:
+    vtkm::Float64 ToTable(const vtkm::Float64 value) const
+    {
+      vtkm::Float64 t = 0.;
+      if(m_scalar_range.Length() > 0.)
+      {
+        t = (value - m_scalar_range.Min) / m_scalar_range.Length();
+      }
+      t = std::min(1., std::max(0., t));
+      return m_table_range.Min + t * m_table_range.Length();
+    }
+
+    vtkm::Range m_scalar_range;
+    vtkm::Range m_table_range;
+    std::vector<vtkm::Float64> m_x;
+    std::vector<vtkm::Float64> m_alpha;
+  };
+
+  //
+  // Finds the box of cells (inclusive) covered by macrocells that are
+  // not transparent. Returns false when nothing is visible.
+  //
+  bool FindVisibleCells(const vtkm::cont::DynamicCellSet &cellset,
+                        const vtkm::cont::Field &field,
+                        const AlphaTest &alpha_test,
+                        const int macrocell_size,
+                        int cell_min[3],
+                        int cell_max[3],
+                        int cell_dims[3])
+  {
+    int point_dims[3];
+    VTKMDataSetInfo::GetPointDims(cellset, point_dims);
+    const bool point_field =
+      field.GetAssociation() == vtkm::cont::Field::Association::POINTS;
+
+    MacrocellFunctor macrocells;
+    macrocells.m_size = macrocell_size;
+    macrocells.m_overlap = point_field ? 1 : 0;
+    for(int i = 0; i < 3; ++i)
+    {
+      cell_dims[i] = point_dims[i] - 1;
+      macrocells.m_dims[i] = point_field ? point_dims[i] : cell_dims[i];
+      macrocells.m_macro_dims[i] = (cell_dims[i] + macrocell_size - 1) / macrocell_size;
+      cell_min[i] = std::numeric_limits<int>::max();
+      cell_max[i] = -1;
+    }
+    field.GetData().ResetTypes(vtkm::TypeListTagFieldScalar()).CastAndCall(macrocells);
+
+    const int *macro_dims = macrocells.m_macro_dims;
+    const int total = macro_dims[0] * macro_dims[1] * macro_dims[2];
+    bool visible = false;
+    for(int m = 0; m < total; ++m)
+    {
+      if(alpha_test.IsTransparent(macrocells.m_min[m], macrocells.m_max[m]))
+      {
+        continue;
+      }
+      visible = true;
+      const int coord[3] = {m % macro_dims[0],
+                            (m / macro_dims[0]) % macro_dims[1],
+                            m / (macro_dims[0] * macro_dims[1])};
+      for(int i = 0; i < 3; ++i)
+      {
+        cell_min[i] = std::min(cell_min[i], coord[i] * macrocell_size);
+        cell_max[i] = std::max(cell_max[i],
+                               std::min((coord[i] + 1) * macrocell_size, cell_dims[i]) - 1);
+      }
+    }
+    return visible;
+  }
+
+  vtkm::cont::ColorTable CorrectOpacity(const vtkm::cont::ColorTable &color_table,
+                                        const float samples)
+  {
+    const float correction_scalar = VTKH_OPACITY_CORRECTION;
+
+    float ratio = correction_scalar / samples;
+    vtkm::cont::ColorTable corrected;
+    corrected = color_table;
+    int num_points = corrected.GetNumberOfPointsAlpha();
+    for(int i = 0; i < num_points; i++)
+    {
+      vtkm::Vec<vtkm::Float64,4> point;
+      corrected.GetPointAlpha(i,point);
+      point[1] = 1. - vtkm::Pow((1. - point[1]), double(ratio));
+      corrected.UpdatePointAlpha(i,point);
+    }
+    return corrected;
+  }
+
+  //
+  // Sample rate of a progressive pass. Refinement passes take between 1
+  // and 1.5 times the full rate, stepping through the golden ratio
+  // sequence so successive passes put samples at well spread offsets.
+  //
+  float PassSamples(const int pass, const int coarse_samples, const int num_samples)
+  {
+    if(pass == 0)
+    {
+      return static_cast<float>(coarse_samples);
+    }
+    const double golden = 0.6180339887498949;
+    const double offset = pass * golden - floor(pass * golden);
+    return static_cast<float>(num_samples * (1. + 0.5 * offset));
+  }
+
+  struct CanvasCopy
+  {
+    std::vector<float> m_color;
+    std::vector<float> m_depth;
+  };
 } //  namespace detail
 
 VolumeRenderer::VolumeRenderer()
@@ -63,6 +366,11 @@ VolumeRenderer::VolumeRenderer()
   m_uncorrected_color_table.AddPointAlpha(0.0f, .02);
   m_uncorrected_color_table.AddPointAlpha(.0f, .5);
   m_num_samples = 100.f;
+  m_use_partials = false;
+  m_skip_empty_space = true;
+  m_macrocell_size = 8;
+  m_num_passes = 1;
+  m_coarse_samples = 16;
   CorrectOpacity();
 }
 
@@ -74,10 +382,96 @@ void
 VolumeRenderer::Update()
 {
   PreExecute();
+  if(m_num_passes > 1)
+  {
+    RenderProgressive();
+    return;
+  }
   Renderer::DoExecute();
   PostExecute();
 }
 
+void
+VolumeRenderer::RenderProgressive()
+{
+  const int num_renders = static_cast<int>(m_renders.size());
+
+  //
+  // Keep what other plots drew into the canvases, so every pass starts
+  // from the same state, and a running sum of the passes.
+  //
+  std::vector<std::vector<detail::CanvasCopy>> base(num_renders);
+  std::vector<std::vector<std::vector<float>>> sums(num_renders);
+  for(int i = 0; i < num_renders; ++i)
+  {
+    const int num_canvases = m_renders[i].GetNumberOfCanvases();
+    base[i].resize(num_canvases);
+    sums[i].resize(num_canvases);
+    for(int c = 0; c < num_canvases; ++c)
+    {
+      vtkmCanvasPtr canvas = m_renders[i].GetCanvas(c);
+      const int size = canvas->GetWidth() * canvas->GetHeight();
+      const float *color = &GetVTKMPointer(canvas->GetColorBuffer())[0][0];
+      const float *depth = GetVTKMPointer(canvas->GetDepthBuffer());
+      base[i][c].m_color.assign(color, color + size * 4);
+      base[i][c].m_depth.assign(depth, depth + size);
+      sums[i][c].resize(size * 4, 0.f);
+    }
+  }
+
+  float total_weight = 0.f;
+  for(int pass = 0; pass < m_num_passes; ++pass)
+  {
+    const float samples = detail::PassSamples(pass, m_coarse_samples, m_num_samples);
+    SetSampleRate(samples);
+
+    for(int i = 0; i < num_renders && pass > 0; ++i)
+    {
+      for(int c = 0; c < m_renders[i].GetNumberOfCanvases(); ++c)
+      {
+        vtkmCanvasPtr canvas = m_renders[i].GetCanvas(c);
+        float *color = &GetVTKMPointer(canvas->GetColorBuffer())[0][0];
+        float *depth = GetVTKMPointer(canvas->GetDepthBuffer());
+        std::copy(base[i][c].m_color.begin(), base[i][c].m_color.end(), color);
+        std::copy(base[i][c].m_depth.begin(), base[i][c].m_depth.end(), depth);
+      }
+    }
+
+    Renderer::DoExecute();
+
+    // passes with more samples are less noisy, so they count for more
+    total_weight += samples;
+    const float inv_total = 1.f / total_weight;
+    for(int i = 0; i < num_renders; ++i)
+    {
+      for(int c = 0; c < m_renders[i].GetNumberOfCanvases(); ++c)
+      {
+        vtkmCanvasPtr canvas = m_renders[i].GetCanvas(c);
+        float *color = &GetVTKMPointer(canvas->GetColorBuffer())[0][0];
+        float *sum = &sums[i][c][0];
+        const int size = static_cast<int>(sums[i][c].size());
+#ifdef VTKH_USE_OPENMP
+        #pragma omp parallel for
+#endif
+        for(int j = 0; j < size; ++j)
+        {
+          sum[j] += samples * color[j];
+          color[j] = sum[j] * inv_total;
+        }
+      }
+    }
+
+    PostExecute();
+
+    if(m_pass_callback)
+    {
+      m_pass_callback(pass, m_renders);
+    }
+  }
+
+  CorrectOpacity();
+}
+
 void VolumeRenderer::SetColorTable(const vtkm::cont::ColorTable &color_table)
 {
   m_uncorrected_color_table = color_table;
@@ -86,22 +480,8 @@ void VolumeRenderer::SetColorTable(const vtkm::cont::ColorTable &color_table)
 
 void VolumeRenderer::CorrectOpacity()
 {
-  const float correction_scalar = VTKH_OPACITY_CORRECTION;
-  float samples = m_num_samples;
-
-  float ratio = correction_scalar / samples;
-  vtkm::cont::ColorTable corrected;
-  corrected = m_uncorrected_color_table;
-  int num_points = corrected.GetNumberOfPointsAlpha();
-  for(int i = 0; i < num_points; i++)
-  {
-    vtkm::Vec<vtkm::Float64,4> point;
-    corrected.GetPointAlpha(i,point);
-    point[1] = 1. - vtkm::Pow((1. - point[1]), double(ratio));
-    corrected.UpdatePointAlpha(i,point);
-  }
-
-  this->m_color_table = corrected;
+  this->m_color_table = detail::CorrectOpacity(m_uncorrected_color_table,
+                                               m_num_samples);
 }
 
 void
@@ -109,12 +489,19 @@ VolumeRenderer::PreExecute()
 {
   Renderer::PreExecute();
 
+  SetSampleRate(m_num_samples);
+}
+
+void
+VolumeRenderer::SetSampleRate(const float samples)
+{
   vtkm::Vec<vtkm::Float32,3> extent;
   extent[0] = static_cast<vtkm::Float32>(this->m_bounds.X.Length());
   extent[1] = static_cast<vtkm::Float32>(this->m_bounds.Y.Length());
   extent[2] = static_cast<vtkm::Float32>(this->m_bounds.Z.Length());
-  vtkm::Float32 dist = vtkm::Magnitude(extent) / m_num_samples;
+  vtkm::Float32 dist = vtkm::Magnitude(extent) / samples;
   m_tracer->SetSampleDistance(dist);
+  this->m_color_table = detail::CorrectOpacity(m_uncorrected_color_table, samples);
 }
 
 void
@@ -127,6 +514,102 @@ VolumeRenderer::PostExecute()
   }
 }
 
+void
+VolumeRenderer::SetUsePartialCompositing(bool on)
+{
+  m_use_partials = on;
+}
+
+void
+VolumeRenderer::SetEmptySpaceSkipping(bool on, const int macrocell_size)
+{
+  if(macrocell_size < 1)
+  {
+    throw Error("VolumeRenderer: macrocell size must be at least 1");
+  }
+  m_skip_empty_space = on;
+  m_macrocell_size = macrocell_size;
+}
+
+void
+VolumeRenderer::SetProgressive(const int num_passes, const int coarse_samples)
+{
+  if(coarse_samples < 1)
+  {
+    throw Error("VolumeRenderer: coarse samples must be at least 1");
+  }
+  m_num_passes = num_passes;
+  m_coarse_samples = coarse_samples;
+}
+
+void
+VolumeRenderer::SetPassCallback(PassCallback callback)
+{
+  m_pass_callback = callback;
+}
+
+void
+VolumeRenderer::RenderDomain(const vtkm::Id &domain_id,
+                             const vtkm::cont::DynamicCellSet &cellset,
+                             const vtkm::cont::CoordinateSystem &coords,
+                             const vtkm::cont::Field &field)
+{
+  int topo_dims;
+  if(!m_skip_empty_space ||
+     !VTKMDataSetInfo::IsStructured(cellset, topo_dims) ||
+     topo_dims != 3)
+  {
+    Renderer::RenderDomain(domain_id, cellset, coords, field);
+    return;
+  }
+
+  int cell_min[3], cell_max[3], cell_dims[3];
+  detail::AlphaTest alpha_test(m_color_table, m_range);
+  const bool visible = detail::FindVisibleCells(cellset,
+                                                field,
+                                                alpha_test,
+                                                m_macrocell_size,
+                                                cell_min,
+                                                cell_max,
+                                                cell_dims);
+  if(!visible)
+  {
+    // the canvases stay empty and contribute no partials
+    VTKH_DATA_ADD("skipped_domain", domain_id);
+    return;
+  }
+
+  if(cell_min[0] == 0 && cell_min[1] == 0 && cell_min[2] == 0 &&
+     cell_max[0] == cell_dims[0] - 1 &&
+     cell_max[1] == cell_dims[1] - 1 &&
+     cell_max[2] == cell_dims[2] - 1)
+  {
+    Renderer::RenderDomain(domain_id, cellset, coords, field);
+    return;
+  }
+
+  // rays only march through the box of visible macrocells
+  vtkm::cont::DataSet domain;
+  domain.SetCellSet(cellset);
+  domain.AddCoordinateSystem(coords);
+  domain.AddField(field);
+
+  vtkm::RangeId3 range(cell_min[0], cell_max[0] + 2,
+                       cell_min[1], cell_max[1] + 2,
+                       cell_min[2], cell_max[2] + 2);
+  vtkm::Id3 sample(1, 1, 1);
+  vtkm::filter::FieldSelection fields;
+  fields.AddField(field.GetName());
+
+  vtkh::vtkmExtractStructured extract;
+  vtkm::cont::DataSet cropped = extract.Run(domain, range, sample, fields);
+
+  Renderer::RenderDomain(domain_id,
+                         cropped.GetCellSet(),
+                         cropped.GetCoordinateSystem(),
+                         cropped.GetField(field.GetName()));
+}
+
 void
 VolumeRenderer::SetNumberOfSamples(const int num_samples)
 {
@@ -159,7 +642,11 @@ VolumeRenderer::FindMinDepth(const vtkm::rendering::Camera &camera,
 void
 VolumeRenderer::Composite(const int &num_images)
 {
-  const int num_domains = static_cast<int>(m_input->GetNumberOfDomains());
+  if(m_use_partials)
+  {
+    CompositePartials(num_images);
+    return;
+  }
 
   m_compositor->SetCompositeMode(Compositor::VIS_ORDER_BLEND);
 
@@ -197,6 +684,47 @@ VolumeRenderer::Composite(const int &num_images)
   } // for image
 }
 
+void
+VolumeRenderer::CompositePartials(const int &num_images)
+{
+  VTKH_DATA_OPEN("Composite");
+  FindVisibilityOrdering();
+
+  PartialCompositor<VolumePartial<float>> compositor;
+#ifdef VTKH_PARALLEL
+  compositor.set_comm_handle(vtkh::GetMPICommHandle());
+#endif
+
+  long long int total_partials = 0;
+  for(int i = 0; i < num_images; ++i)
+  {
+    const int num_canvases = m_renders[i].GetNumberOfCanvases();
+    std::vector<std::vector<VolumePartial<float>>> partials(num_canvases);
+
+    for(int dom = 0; dom < num_canvases; ++dom)
+    {
+      detail::ExtractPartials(*m_renders[i].GetCanvas(dom),
+                              m_visibility_orders[i][dom],
+                              partials[dom]);
+      total_partials += partials[dom].size();
+    }
+
+    std::vector<VolumePartial<float>> result;
+    compositor.composite(partials, result);
+#ifdef VTKH_PARALLEL
+    if(vtkh::GetMPIRank() == 0)
+    {
+#endif
+      detail::PartialsToCanvas(result, *m_renders[i].GetCanvas(0));
+#ifdef VTKH_PARALLEL
+    }
+#endif
+  } // for image
+
+  VTKH_DATA_ADD("local_partials", total_partials);
+  VTKH_DATA_CLOSE();
+}
+
 void
 VolumeRenderer::DepthSort(int num_domains,
                           std::vector<float> &min_depths,
@@ -5,11 +5,18 @@
 #include <vtkh/rendering/Renderer.hpp>
 #include <vtkm/rendering/MapperVolume.h>
 
+#include <functional>
+
 namespace vtkh {
 
 class VTKH_API VolumeRenderer : public Renderer
 {
 public:
+  // called after each progressive pass is composited. Rank 0 holds the
+  // image for this pass in canvas 0 of each render until the next pass
+  typedef std::function<void(const int pass,
+                             std::vector<vtkh::Render> &renders)> PassCallback;
+
   VolumeRenderer();
   virtual ~VolumeRenderer();
   std::string GetName() const override;
@@ -18,12 +25,37 @@ public:
 
   void Update() override;
   virtual void SetColorTable(const vtkm::cont::ColorTable &color_table) override;
+  // composite only the pixels each domain covers as sparse partials
+  // instead of exchanging full images (default off). Traffic then
+  // scales with the projected size of the domains rather than the
+  // image size
+  void SetUsePartialCompositing(bool on);
+  // skip the parts of structured domains that are fully transparent
+  // under the color table, tested on blocks of macrocell_size^3 cells.
+  // Domains with nothing visible are not rendered at all, the others
+  // are cropped to the box of visible macrocells (default on)
+  void SetEmptySpaceSkipping(bool on, const int macrocell_size = 8);
+  // progressive mode for interactive use. Update renders a preview with
+  // coarse_samples, then num_passes - 1 refinement passes with at least
+  // the full number of samples. Each refinement samples at a slightly
+  // different rate so the sample positions interleave, and passes are
+  // averaged (weighted by samples) into the result. The image is
+  // composited after every pass. num_passes < 2 turns this off
+  void SetProgressive(const int num_passes, const int coarse_samples = 16);
+  void SetPassCallback(PassCallback callback);
 protected:
   virtual void Composite(const int &num_images) override;
+  void CompositePartials(const int &num_images);
+  virtual void RenderDomain(const vtkm::Id &domain_id,
+                            const vtkm::cont::DynamicCellSet &cellset,
+                            const vtkm::cont::CoordinateSystem &coords,
+                            const vtkm::cont::Field &field) override;
   virtual void PreExecute() override;
   virtual void PostExecute() override;
 
   void CorrectOpacity();
+  void SetSampleRate(const float samples);
+  void RenderProgressive();
   void FindVisibilityOrdering();
   void DepthSort(int num_domains,
                  std::vector<float> &min_depths,
@@ -32,6 +64,12 @@ protected:
                      const vtkm::Bounds &bounds) const;
 
   int m_num_samples;
+  bool m_use_partials;
+  bool m_skip_empty_space;
+  int m_macrocell_size;
+  int m_num_passes;
+  int m_coarse_samples;
+  PassCallback m_pass_callback;
   std::shared_ptr<vtkm::rendering::MapperVolume> m_tracer;
   vtkm::cont::ColorTable m_uncorrected_color_table;
   std::vector<std::vector<int>> m_visibility_orders;
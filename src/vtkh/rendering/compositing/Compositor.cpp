@@ -3,20 +3,148 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <chrono>
 
 #ifdef VTKH_PARALLEL
 #include <mpi.h>
 #include <vtkh/vtkh.hpp>
 #include <vtkh/rendering/compositing/DirectSendCompositor.hpp>
 #include <vtkh/rendering/compositing/RadixKCompositor.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_image_block.hpp>
 #include <diy/mpi.hpp>
 #endif
 
 namespace vtkh
 {
 
+namespace detail
+{
+
+struct SurfaceSettings
+{
+  Compositor::SurfaceAlgorithm m_algorithm;
+  int                          m_radix_k;
+  Compositor::NetworkModel     m_model;
+
+  SurfaceSettings()
+    : m_algorithm(Compositor::AUTO_SELECT),
+      m_radix_k(8)
+  {
+    // conservative defaults for an infiniband class network
+    m_model.m_latency = 2e-6;
+    m_model.m_byte_time = 1. / 5e9;
+    m_model.m_pixel_time = 2e-9;
+  }
+};
+
+SurfaceSettings &surface_settings()
+{
+  static SurfaceSettings settings;
+  return settings;
+}
+
+} // namespace detail
+
+void
+Compositor::SetSurfaceAlgorithm(SurfaceAlgorithm algorithm, int radix_k)
+{
+  assert(algorithm != RADIX_K || radix_k > 1);
+  detail::surface_settings().m_algorithm = algorithm;
+  detail::surface_settings().m_radix_k = radix_k;
+}
+
+void
+Compositor::SetNetworkModel(const NetworkModel &model)
+{
+  detail::surface_settings().m_model = model;
+}
+
+Compositor::NetworkModel
+Compositor::GetNetworkModel()
+{
+  return detail::surface_settings().m_model;
+}
+
+void
+Compositor::CalibrateNetworkModel()
+{
+  NetworkModel &model = detail::surface_settings().m_model;
+
+  // local composite speed
+  const int dim = 512;
+  const int pixels = dim * dim;
+  Image front(vtkm::Bounds(1, dim, 1, dim, 0, 0));
+  Image back(vtkm::Bounds(1, dim, 1, dim, 0, 0));
+  for(int i = 0; i < pixels; ++i)
+  {
+    front.m_depths[i] = (i % 2) ? 0.5f : 2.f;
+    back.m_depths[i] = 0.25f;
+  }
+  vtkh::ImageCompositor image_compositor;
+  const int composite_reps = 5;
+  auto start = std::chrono::high_resolution_clock::now();
+  for(int i = 0; i < composite_reps; ++i)
+  {
+    image_compositor.ZBufferComposite(front, back);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+  double pixel_time = elapsed.count() / (composite_reps * pixels);
+
+#ifdef VTKH_PARALLEL
+  MPI_Comm comm = MPI_Comm_f2c(GetMPICommHandle());
+  const int rank = GetMPIRank();
+  const int size = GetMPISize();
+  // measure between ranks that are likely on different nodes
+  const int partner = size / 2;
+
+  double params[3] = {model.m_latency, model.m_byte_time, pixel_time};
+  if(size > 1 && (rank == 0 || rank == partner))
+  {
+    const int reps = 20;
+    const int large = 1 << 20;
+    std::vector<char> buffer(large);
+    const int other = rank == 0 ? partner : 0;
+    double times[2];
+    const int lengths[2] = {1, large};
+    for(int t = 0; t < 2; ++t)
+    {
+      double begin = MPI_Wtime();
+      for(int r = 0; r < reps; ++r)
+      {
+        if(rank == 0)
+        {
+          MPI_Send(&buffer[0], lengths[t], MPI_CHAR, other, 0, comm);
+          MPI_Recv(&buffer[0], lengths[t], MPI_CHAR, other, 0, comm, MPI_STATUS_IGNORE);
+        }
+        else
+        {
+          MPI_Recv(&buffer[0], lengths[t], MPI_CHAR, other, 0, comm, MPI_STATUS_IGNORE);
+          MPI_Send(&buffer[0], lengths[t], MPI_CHAR, other, 0, comm);
+        }
+      }
+      // one way time
+      times[t] = (MPI_Wtime() - begin) / (2. * reps);
+    }
+    params[0] = times[0];
+    params[1] = std::max((times[1] - times[0]) / large, 1e-12);
+  }
+
+  // rank 0 owns the network numbers, and the slowest composite speed wins
+  MPI_Bcast(params, 2, MPI_DOUBLE, 0, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &params[2], 1, MPI_DOUBLE, MPI_MAX, comm);
+  model.m_latency = params[0];
+  model.m_byte_time = params[1];
+  model.m_pixel_time = params[2];
+#else
+  model.m_pixel_time = pixel_time;
+#endif
+}
+
 Compositor::Compositor()
-  : m_composite_mode(Z_BUFFER_SURFACE)
+  : m_composite_mode(Z_BUFFER_SURFACE),
+    m_rle(true),
+    m_collect_depth(true),
+    m_mpi_comm_id(-1)
 {
 
 }
@@ -34,6 +162,38 @@ Compositor::SetCompositeMode(CompositeMode composite_mode)
   m_composite_mode = composite_mode;
 }
 
+void
+Compositor::SetRunLengthEncoding(bool on)
+{
+  m_rle = on;
+}
+
+void
+Compositor::SetCollectDepth(bool on)
+{
+  m_collect_depth = on;
+}
+
+void
+Compositor::SetMPICommHandle(int mpi_comm_id)
+{
+  m_mpi_comm_id = mpi_comm_id;
+}
+
+void
+Compositor::SetCompressImages(bool on, int depth_bits)
+{
+  assert(depth_bits == 32 || depth_bits == 24 || depth_bits == 16);
+#ifdef VTKH_PARALLEL
+  ImageCodec::Enabled() = on;
+  ImageCodec::DepthBits() = depth_bits;
+#else
+  // images are never sent in serial
+  (void) on;
+  (void) depth_bits;
+#endif
+}
+
 void
 Compositor::ClearImages()
 {
@@ -203,10 +363,28 @@ Compositor::CompositeZBufferSurface()
   // they were added to the compositor
 #ifdef VTKH_PARALLEL
   vtkhdiy::mpi::communicator diy_comm;
-  diy_comm = vtkhdiy::mpi::communicator(MPI_Comm_f2c(GetMPICommHandle()));
+  const int comm_id = m_mpi_comm_id == -1 ? GetMPICommHandle() : m_mpi_comm_id;
+  diy_comm = vtkhdiy::mpi::communicator(MPI_Comm_f2c(comm_id));
 
   assert(m_images.size() == 1);
   RadixKCompositor compositor;
+  compositor.SetRunLengthEncoding(m_rle);
+  compositor.SetCollectDepth(m_collect_depth);
+
+  const detail::SurfaceSettings &settings = detail::surface_settings();
+  int radix_k = 0; // pick from the model
+  if(settings.m_algorithm == RADIX_K)
+  {
+    radix_k = settings.m_radix_k;
+  }
+  else if(settings.m_algorithm == BINARY_SWAP)
+  {
+    radix_k = 2;
+  }
+  compositor.SetRadixK(radix_k);
+  compositor.SetDirectSend(settings.m_algorithm == DIRECT_SEND);
+  compositor.SetNetworkModel(settings.m_model);
+
   compositor.CompositeSurface(diy_comm, this->m_images[0]);
   m_log_stream<<compositor.GetTimingString();
 #endif
@@ -224,7 +402,8 @@ Compositor::CompositeVisOrder()
 
 #ifdef VTKH_PARALLEL
   vtkhdiy::mpi::communicator diy_comm;
-  diy_comm = vtkhdiy::mpi::communicator(MPI_Comm_f2c(GetMPICommHandle()));
+  const int comm_id = m_mpi_comm_id == -1 ? GetMPICommHandle() : m_mpi_comm_id;
+  diy_comm = vtkhdiy::mpi::communicator(MPI_Comm_f2c(comm_id));
 
   assert(m_images.size() != 0);
   DirectSendCompositor compositor;
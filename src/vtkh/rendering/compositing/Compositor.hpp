@@ -16,12 +16,53 @@ public:
                          Z_BUFFER_BLEND,   // zbuffer composite with transparency
                          VIS_ORDER_BLEND   // blend images in a specific order
                        };
+    // how surface images are exchanged between ranks. Binary swap is
+    // radix-k with k = 2. Direct send exchanges one strip per rank in a
+    // single round. AUTO_SELECT picks k from the network model below
+    enum SurfaceAlgorithm {
+                            AUTO_SELECT,
+                            RADIX_K,
+                            BINARY_SWAP,
+                            DIRECT_SEND
+                          };
+
+    // simple alpha-beta model of the machine used by AUTO_SELECT
+    struct NetworkModel
+    {
+      double m_latency;    // seconds per message
+      double m_byte_time;  // seconds per byte sent
+      double m_pixel_time; // seconds to composite a pixel
+    };
+
     Compositor();
 
     virtual ~Compositor();
 
+    // process wide settings, since compositors are owned by renderers
+    static void SetSurfaceAlgorithm(SurfaceAlgorithm algorithm, int radix_k = 8);
+    static void SetNetworkModel(const NetworkModel &model);
+    static NetworkModel GetNetworkModel();
+    // collective: measures latency and bandwidth between two ranks and the
+    // local composite speed, then shares the result with every rank
+    static void CalibrateNetworkModel();
+
     void SetCompositeMode(CompositeMode composite_mode);
 
+    // run length encode empty spans of sparse images during exchange
+    void SetRunLengthEncoding(bool on);
+
+    // gather depth with the final surface image. When off, rank 0 only
+    // has valid depths for its own tile
+    void SetCollectDepth(bool on);
+
+    // communicator to composite over (fortran handle). Defaults to the
+    // vtkh communicator
+    void SetMPICommHandle(int mpi_comm_id);
+
+    // compress color and depth payloads of compositing messages.
+    // depth_bits: 32 (lossless), 24 or 16 (quantized)
+    static void SetCompressImages(bool on, int depth_bits = 32);
+
     void ClearImages();
 
     void AddImage(const unsigned char *color_buffer,
@@ -55,15 +96,7 @@ public:
     unsigned char * ConvertBuffer(const float *buffer, const int size)
     {
         unsigned char *ubytes = new unsigned char[size];
-
-#ifdef VTKH_USE_OPENMP
-        #pragma omp parallel for
-#endif
-        for(int i = 0; i < size; ++i)
-        {
-            ubytes[i] = static_cast<unsigned char>(buffer[i] * 255.f);
-        }
-
+        PixelKernels::FloatToUChar(buffer, ubytes, size);
         return ubytes;
     }
 
@@ -74,6 +107,9 @@ protected:
 
     std::stringstream   m_log_stream;
     CompositeMode       m_composite_mode;
+    bool                m_rle;
+    bool                m_collect_depth;
+    int                 m_mpi_comm_id;
     std::vector<Image>  m_images;
 };
 
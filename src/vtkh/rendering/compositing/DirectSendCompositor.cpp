@@ -1,7 +1,7 @@
 #include <vtkh/rendering/ImageCompositor.hpp>
 #include <vtkh/rendering/compositing/DirectSendCompositor.hpp>
 #include <vtkh/rendering/compositing/MPICollect.hpp>
-#include <vtkh/rendering/compositing/vtkh_diy_collect.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_image_block.hpp>
 #include <vtkh/rendering/compositing/vtkh_diy_utils.hpp>
 
 #include <diy/master.hpp>
@@ -148,22 +148,7 @@ DirectSendCompositor::CompositeVolume(vtkhdiy::mpi::communicator &diy_comm,
                     magic_k);
   }
 
-  {
-    vtkhdiy::Master master(diy_comm, num_threads);
-    vtkhdiy::ContiguousAssigner assigner(num_blocks, num_blocks);
-
-    const int dims = 2;
-    vtkhdiy::RegularDecomposer<vtkhdiy::DiscreteBounds> decomposer(dims, global_bounds, num_blocks);
-    AddImageBlock all_create(master, sub_image);
-    decomposer.decompose(diy_comm.rank(), assigner, all_create);
-    MPI_Barrier(diy_comm);
-
-    //MPICollect(sub_image,diy_comm);
-    vtkhdiy::all_to_all(master,
-                    assigner,
-                    CollectImages(decomposer),
-                    magic_k);
-  }
+  MPICollect(sub_image, diy_comm);
 
   images.at(0).Swap(sub_image);
 }
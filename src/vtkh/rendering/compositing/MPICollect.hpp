@@ -3,91 +3,165 @@
 
 #include <vtkh/rendering/Image.hpp>
 #include <diy/mpi.hpp>
-#include <sstream>
+#include <algorithm>
+#include <vector>
 
 namespace vtkh
 {
 
-static void MPICollect(Image &image, MPI_Comm comm)
+namespace detail
 {
 
+// describes where a tile sits inside the final image, so it can be
+// received straight into the output buffer
+inline MPI_Datatype tile_type(const int tile_width,
+                              const int tile_height,
+                              const int image_width,
+                              const int channels,
+                              MPI_Datatype base)
+{
+  MPI_Datatype type;
+  MPI_Type_vector(tile_height,
+                  tile_width * channels,
+                  image_width * channels,
+                  base,
+                  &type);
+  MPI_Type_commit(&type);
+  return type;
+}
+
+// a private copy of a communicator, freed however the gather exits
+struct CommCopy
+{
+  MPI_Comm m_comm;
+  CommCopy(MPI_Comm comm)
+  {
+    MPI_Comm_dup(comm, &m_comm);
+  }
+  ~CommCopy()
+  {
+    MPI_Comm_free(&m_comm);
+  }
+};
+
+} // namespace detail
+
+//
+// Gathers the tile held by each rank into the full image on rank 0.
+// All receives are posted up front and land directly in the final image,
+// so tiles arrive in whatever order the network delivers them. Set
+// collect_depth to false when only color is needed; rank 0 then keeps its
+// own depths and everything else gets the canvas clear depth. Non-root
+// ranks are left with an empty image.
+//
+// The tiles travel on a copy of the communicator: diy probes for any
+// message on the one it was given, so a rank still finishing the
+// compositing exchange would otherwise take tiles meant for the gather.
+//
+static void MPICollect(Image &image, MPI_Comm parent_comm, bool collect_depth = true)
+{
+  detail::CommCopy comm_copy(parent_comm);
+  MPI_Comm comm = comm_copy.m_comm;
+  const int root = 0;
   int rank, size;
   MPI_Comm_rank(comm, &rank);
   MPI_Comm_size(comm, &size);
 
-  int bounds[4];
-  bounds[0] = image.m_bounds.X.Min;
-  bounds[1] = image.m_bounds.Y.Min;
-  bounds[2] = image.m_bounds.X.Max;
-  bounds[3] = image.m_bounds.Y.Max;
-
-  int xmin = image.m_bounds.X.Min;
-  int ymin = image.m_bounds.Y.Min;
-  int xmax = image.m_bounds.X.Max;
-  int ymax = image.m_bounds.Y.Max;
-  int pixels = (xmax - xmin + 1) *(ymax - ymin + 1);
-
-  int *pixel_sizes = nullptr;
-  int *pixel_bounds = nullptr;
-  if(rank == 0)
+  const int pixels = image.GetNumberOfPixels();
+
+  // an empty tile has infinite bounds, send an empty range instead
+  int bounds[4] = {0, 0, -1, -1};
+  if(pixels > 0)
   {
-    pixel_sizes = new int[size];
-    pixel_bounds = new int[size*4];
+    bounds[0] = image.m_bounds.X.Min;
+    bounds[1] = image.m_bounds.Y.Min;
+    bounds[2] = image.m_bounds.X.Max;
+    bounds[3] = image.m_bounds.Y.Max;
   }
 
-  MPI_Gather(&bounds, 4, MPI_INT, pixel_bounds, 4, MPI_INT, 0, comm);
-
-  MPI_Barrier(comm);
-  // create the final image
-  vtkm::Bounds final_bounds;
-  final_bounds.X.Min = 1;
-  final_bounds.Y.Min = 1;
-  final_bounds.X.Max = 1;
-  final_bounds.Y.Max = 1;
-
-  if(rank == 0)
+  std::vector<int> tile_bounds;
+  if(rank == root)
   {
-    final_bounds = image.m_orig_bounds;
+    tile_bounds.resize(size * 4);
   }
 
-  Image final_image(final_bounds);
-  if(rank == 0)
+  MPI_Gather(bounds, 4, MPI_INT, tile_bounds.data(), 4, MPI_INT, root, comm);
+
+  std::vector<MPI_Request> requests;
+  if(rank != root)
   {
-    image.SubsetTo(final_image);
+    if(pixels > 0)
+    {
+      requests.resize(collect_depth ? 2 : 1);
+      MPI_Isend(&image.m_pixels[0], pixels * 4, MPI_UNSIGNED_CHAR, root, 0, comm, &requests[0]);
+      if(collect_depth)
+      {
+        MPI_Isend(&image.m_depths[0], pixels, MPI_FLOAT, root, 1, comm, &requests[1]);
+      }
+    }
+    MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+    image.Clear();
+    return;
   }
 
-  if(rank != 0)
+  Image final_image(image.m_orig_bounds);
+  final_image.m_orig_rank = image.m_orig_rank;
+  const vtkm::Bounds &final_bounds = final_image.m_bounds;
+  const int width = final_bounds.X.Max - final_bounds.X.Min + 1;
+
+  if(!collect_depth)
   {
-    MPI_Send(&image.m_pixels[0], pixels * 4, MPI_UNSIGNED_CHAR, 0, 0, comm);
-    MPI_Send(&image.m_depths[0], pixels, MPI_FLOAT, 0, 0, comm);
+    // what the canvases clear their depth buffers to, so the gathered
+    // image reads as background wherever no depth was sent
+    std::fill(final_image.m_depths.begin(), final_image.m_depths.end(), 1.001f);
   }
-  else
+
+  std::vector<MPI_Datatype> types;
+  for(int i = 0; i < size; ++i)
   {
-    for(int i = 1; i < size; ++i)
+    if(i == root)
+    {
+      continue;
+    }
+    const int *tile = &tile_bounds[i * 4];
+    const int tile_width = tile[2] - tile[0] + 1;
+    const int tile_height = tile[3] - tile[1] + 1;
+    if(tile_width < 1 || tile_height < 1)
     {
-      vtkm::Bounds inbound;
-      inbound.X.Min = pixel_bounds[i*4 + 0];
-      inbound.Y.Min = pixel_bounds[i*4 + 1];
-      inbound.X.Max = pixel_bounds[i*4 + 2];
-      inbound.Y.Max = pixel_bounds[i*4 + 3];
-      Image incoming(inbound);
-
-      int rec_size = (inbound.X.Max - inbound.X.Min + 1) *
-                     (inbound.Y.Max - inbound.Y.Min + 1);
-
-      MPI_Status status;
-      MPI_Recv(&(incoming.m_pixels[0]), rec_size * 4, MPI_UNSIGNED_CHAR, i, 0, comm, &status);
-      MPI_Recv(&(incoming.m_depths[0]), rec_size, MPI_FLOAT, i, 0, comm, &status);
-      incoming.SubsetTo(final_image);
+      continue;
     }
+
+    const int offset = (tile[1] - final_bounds.Y.Min) * width + (tile[0] - final_bounds.X.Min);
+
+    MPI_Request request;
+    MPI_Datatype color_type = detail::tile_type(tile_width, tile_height, width, 4, MPI_UNSIGNED_CHAR);
+    MPI_Irecv(&final_image.m_pixels[offset * 4], 1, color_type, i, 0, comm, &request);
+    requests.push_back(request);
+    types.push_back(color_type);
+
+    if(collect_depth)
+    {
+      MPI_Datatype depth_type = detail::tile_type(tile_width, tile_height, width, 1, MPI_FLOAT);
+      MPI_Irecv(&final_image.m_depths[offset], 1, depth_type, i, 1, comm, &request);
+      requests.push_back(request);
+      types.push_back(depth_type);
+    }
+  }
+
+  // copy our own tile while the others arrive
+  if(pixels > 0)
+  {
+    image.SubsetTo(final_image);
   }
-  if(rank == 0)
+
+  MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+
+  for(size_t i = 0; i < types.size(); ++i)
   {
-    delete[] pixel_sizes;
-    delete[] pixel_bounds;
-    image.Swap(final_image);
+    MPI_Type_free(&types[i]);
   }
-  //MPI_Barrier(comm);
+
+  image.Swap(final_image);
 }
 
 }// namespace vtkh
@@ -40,6 +40,7 @@
 //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 #include "PartialCompositor.hpp"
+#include "PartialSort.hpp"
 #include <algorithm>
 #include <assert.h>
 #include <limits>
@@ -53,6 +54,7 @@
 namespace vtkh {
 namespace detail
 {
+
 template<template <typename> class PartialType, typename FloatType>
 void BlendPartials(const int &total_segments,
                    const int &total_partial_comps,
@@ -332,15 +334,16 @@ PartialCompositor<PartialType>::composite_partials(std::vector<PartialType> &par
                                             std::vector<PartialType> &output_partials)
 {
   const int total_partial_comps = partials.size();
-  if(total_partial_comps == 0)
+  if(total_partial_comps < 2)
   {
+    // nothing to blend and the loops below look one past each end
     output_partials = partials;
     return;
   }
   //
   // Sort the composites
   //
-  std::sort(partials.begin(), partials.end());
+  detail::RadixSortPartials(partials);
   //
   // Find the number of unique pixel_ids with work
   //
@@ -511,6 +514,13 @@ PartialCompositor<PartialType>::composite(std::vector<std::vector<PartialType>>
 
   merge(partial_images, partials, global_min_pixel, global_max_pixel);
 
+  if(global_min_pixel > global_max_pixel)
+  {
+    // no rank touched any pixels
+    output_partials.clear();
+    return;
+  }
+
 #ifdef VTKH_PARALLEL
   //
   // Exchange partials with other ranks
@@ -0,0 +1,184 @@
+#ifndef VTKH_PARTIAL_SORT_HPP
+#define VTKH_PARTIAL_SORT_HPP
+
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#ifdef VTKH_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace vtkh {
+namespace detail
+{
+
+// maps float bits to an unsigned int with the same ordering
+inline uint64_t OrderedDepthBits(const float depth)
+{
+  uint32_t bits;
+  memcpy(&bits, &depth, sizeof(bits));
+  return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+// maps double bits to an unsigned int with the same ordering
+inline uint64_t OrderedDepthBits(const double depth)
+{
+  uint64_t bits;
+  memcpy(&bits, &depth, sizeof(bits));
+  return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+//
+// One stable LSD radix sort of ids by the low key_bits of keys, 11 bits
+// at a time. Each thread counts and scatters its own contiguous range
+// so the passes stay stable, and digits where every key has the same
+// value are skipped.
+//
+inline void RadixSortKeys(std::vector<uint64_t> &keys,
+                          std::vector<int> &ids,
+                          const int key_bits)
+{
+  const int size = static_cast<int>(keys.size());
+  const int radix_bits = 11;
+  const int radix = 1 << radix_bits;
+  const uint64_t mask = radix - 1;
+#ifdef VTKH_USE_OPENMP
+  const int num_chunks = std::max(1, std::min(omp_get_max_threads(), size / radix));
+#else
+  const int num_chunks = 1;
+#endif
+
+  std::vector<uint64_t> keys_out(size);
+  std::vector<int> ids_out(size);
+  std::vector<int> counts(num_chunks * radix);
+  for(int shift = 0; shift < key_bits; shift += radix_bits)
+  {
+    std::fill(counts.begin(), counts.end(), 0);
+#ifdef VTKH_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int c = 0; c < num_chunks; ++c)
+    {
+      int *count = &counts[c * radix];
+      const int begin = static_cast<int>((long long)size * c / num_chunks);
+      const int end = static_cast<int>((long long)size * (c + 1) / num_chunks);
+      for(int i = begin; i < end; ++i)
+      {
+        count[(keys[i] >> shift) & mask]++;
+      }
+    }
+
+    // turn counts into offsets, digit major so each chunk writes after
+    // the chunks before it
+    int offset = 0;
+    int max_bucket = 0;
+    for(int d = 0; d < radix; ++d)
+    {
+      int bucket = 0;
+      for(int c = 0; c < num_chunks; ++c)
+      {
+        const int count = counts[c * radix + d];
+        counts[c * radix + d] = offset;
+        offset += count;
+        bucket += count;
+      }
+      max_bucket = std::max(max_bucket, bucket);
+    }
+
+    if(max_bucket == size)
+    {
+      continue;
+    }
+
+#ifdef VTKH_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int c = 0; c < num_chunks; ++c)
+    {
+      int *offsets = &counts[c * radix];
+      const int begin = static_cast<int>((long long)size * c / num_chunks);
+      const int end = static_cast<int>((long long)size * (c + 1) / num_chunks);
+      for(int i = begin; i < end; ++i)
+      {
+        const int dest = offsets[(keys[i] >> shift) & mask]++;
+        keys_out[dest] = keys[i];
+        ids_out[dest] = ids[i];
+      }
+    }
+
+    keys.swap(keys_out);
+    ids.swap(ids_out);
+  }
+}
+
+//
+// Stable sort of the partials by (pixel id, depth), the same order as
+// operator <. Indices are radix sorted by the order preserving bits of
+// the full float or double depth first, then by pixel id relative to
+// the smallest id, and the partials are moved once at the end.
+//
+template<typename PartialType>
+void RadixSortPartials(std::vector<PartialType> &partials)
+{
+  const int size = static_cast<int>(partials.size());
+
+  int min_pixel = std::numeric_limits<int>::max();
+  int max_pixel = std::numeric_limits<int>::min();
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for reduction(min:min_pixel) reduction(max:max_pixel)
+#endif
+  for(int i = 0; i < size; ++i)
+  {
+    min_pixel = std::min(min_pixel, partials[i].m_pixel_id);
+    max_pixel = std::max(max_pixel, partials[i].m_pixel_id);
+  }
+
+  std::vector<uint64_t> keys(size);
+  std::vector<int> ids(size);
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < size; ++i)
+  {
+    keys[i] = OrderedDepthBits(partials[i].m_depth);
+    ids[i] = i;
+  }
+  RadixSortKeys(keys, ids, static_cast<int>(8 * sizeof(partials[0].m_depth)));
+
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < size; ++i)
+  {
+    keys[i] = static_cast<uint32_t>(partials[ids[i]].m_pixel_id) - static_cast<uint32_t>(min_pixel);
+  }
+  int pixel_bits = 0;
+  if(size > 0)
+  {
+    const uint32_t span = static_cast<uint32_t>(max_pixel) - static_cast<uint32_t>(min_pixel);
+    while(pixel_bits < 32 && (span >> pixel_bits) != 0)
+    {
+      ++pixel_bits;
+    }
+  }
+  RadixSortKeys(keys, ids, pixel_bits);
+
+  std::vector<PartialType> sorted(size);
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < size; ++i)
+  {
+    sorted[i] = std::move(partials[ids[i]]);
+  }
+  partials.swap(sorted);
+}
+
+} // namespace detail
+} // namespace vtkh
+
+#endif
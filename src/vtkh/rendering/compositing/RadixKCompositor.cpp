@@ -1,7 +1,7 @@
-#include <vtkh/rendering/ImageCompositor.hpp>
 #include <vtkh/rendering/compositing/MPICollect.hpp>
 #include <vtkh/rendering/compositing/RadixKCompositor.hpp>
-#include <vtkh/rendering/compositing/vtkh_diy_collect.hpp>
+#include <vtkh/rendering/compositing/SparseImage.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_image_block.hpp>
 #include <vtkh/rendering/compositing/vtkh_diy_utils.hpp>
 
 #include <diy/master.hpp>
@@ -10,12 +10,29 @@
 #include <diy/reduce.hpp>
 #include <diy/reduce-operations.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+
 namespace vtkh
 {
 
-void reduce_images(void *b,
-                   const vtkhdiy::ReduceProxy &proxy,
-                   const vtkhdiy::RegularSwapPartners &partners)
+struct ReduceImages
+{
+  bool m_rle;
+
+  ReduceImages(bool rle)
+    : m_rle(rle)
+  {}
+
+  void operator()(void *b,
+                  const vtkhdiy::ReduceProxy &proxy,
+                  const vtkhdiy::RegularSwapPartners &partners) const;
+};
+
+void ReduceImages::operator()(void *b,
+                              const vtkhdiy::ReduceProxy &proxy,
+                              const vtkhdiy::RegularSwapPartners &partners) const
 {
   ImageBlock *block = reinterpret_cast<ImageBlock*>(b);
   unsigned int round = proxy.round();
@@ -31,10 +48,9 @@ void reduce_images(void *b,
           //skip revieving from self since we sent nothing
           continue;
         }
-        Image incoming;
+        SparseImage incoming;
         proxy.dequeue(gid, incoming);
-        vtkh::ImageCompositor compositor;
-        compositor.ZBufferComposite(image, incoming);
+        incoming.CompositeInto(image);
       } // for in links
   }
 
@@ -99,15 +115,22 @@ void reduce_images(void *b,
       }
       else
       {
-        proxy.enqueue(proxy.out_link().target(i), out_images[i]);
+        // only send the active pixels of the sub-image
+        SparseImage outgoing;
+        outgoing.Encode(out_images[i], m_rle);
+        proxy.enqueue(proxy.out_link().target(i), outgoing);
       }
   } //for
 
 } // reduce images
 
 RadixKCompositor::RadixKCompositor()
+  : m_rle(true),
+    m_collect_depth(true),
+    m_radix_k(8),
+    m_direct_send(false)
 {
-
+  m_model = Compositor::GetNetworkModel();
 }
 
 RadixKCompositor::~RadixKCompositor()
@@ -124,30 +147,44 @@ RadixKCompositor::CompositeSurface(vtkhdiy::mpi::communicator &diy_comm, Image &
     // tells diy to use one thread
     const int num_threads = 1;
     const int num_blocks = diy_comm.size();
-    const int magic_k = 8;
 
     vtkhdiy::Master master(diy_comm, num_threads);
 
     // create an assigner with one block per rank
     vtkhdiy::ContiguousAssigner assigner(num_blocks, num_blocks);
     AddImageBlock create(master, image);
-    const int num_dims = 2;
+    // with strips a single group holds every rank
+    const int num_dims = m_direct_send ? 1 : 2;
     vtkhdiy::RegularDecomposer<vtkhdiy::DiscreteBounds> decomposer(num_dims, global_bounds, num_blocks);
     decomposer.decompose(diy_comm.rank(), assigner, create);
+    int radix_k = m_direct_send ? std::max(num_blocks, 2) : m_radix_k;
+    if(radix_k < 2)
+    {
+      // every rank has to agree, so use the global fill
+      const int width = image.m_bounds.X.Max - image.m_bounds.X.Min + 1;
+      const int height = image.m_bounds.Y.Max - image.m_bounds.Y.Min + 1;
+      const double pixels = static_cast<double>(width) * height;
+      double active = 0;
+      for(size_t i = 0; i < image.m_depths.size(); ++i)
+      {
+        if(image.m_depths[i] <= 1.f) active++;
+      }
+      double total_active = 0;
+      vtkhdiy::mpi::all_reduce(diy_comm, active, total_active, std::plus<double>());
+      const double fill = std::min(1., total_active / (pixels * num_blocks));
+      radix_k = ChooseRadixK(decomposer.divisions, pixels, fill, m_model);
+    }
+    m_timing_log<<"radix_k "<<radix_k<<"\n";
+
     vtkhdiy::RegularSwapPartners partners(decomposer,
-                                      magic_k,
+                                      radix_k,
                                       false); // false == distance halving
     vtkhdiy::reduce(master,
                 assigner,
                 partners,
-                reduce_images);
-
+                ReduceImages(m_rle));
 
-    //MPICollect(image, diy_comm);
-    vtkhdiy::all_to_all(master,
-                    assigner,
-                    CollectImages(decomposer),
-                    magic_k);
+    MPICollect(image, diy_comm, m_collect_depth);
 
     if(diy_comm.rank() == 0)
     {
@@ -156,6 +193,90 @@ RadixKCompositor::CompositeSurface(vtkhdiy::mpi::communicator &diy_comm, Image &
 
 }
 
+void
+RadixKCompositor::SetRunLengthEncoding(bool on)
+{
+  m_rle = on;
+}
+
+void
+RadixKCompositor::SetCollectDepth(bool on)
+{
+  m_collect_depth = on;
+}
+
+void
+RadixKCompositor::SetRadixK(int k)
+{
+  m_radix_k = k;
+}
+
+void
+RadixKCompositor::SetDirectSend(bool on)
+{
+  m_direct_send = on;
+}
+
+void
+RadixKCompositor::SetNetworkModel(const Compositor::NetworkModel &model)
+{
+  m_model = model;
+}
+
+double
+RadixKCompositor::EstimateCost(const vtkhdiy::RegularPartners::KVSVector &kvs,
+                               const double pixels,
+                               const double fill,
+                               const Compositor::NetworkModel &model)
+{
+  // color + depth, only active pixels are sent (see SparseImage)
+  const double bytes_per_pixel = 8. * fill;
+  double tile = pixels;
+  double cost = 0.;
+  for(size_t r = 0; r < kvs.size(); ++r)
+  {
+    const double k = kvs[r].size;
+    const double piece = tile / k;
+    const double send = model.m_latency + piece * bytes_per_pixel * model.m_byte_time;
+    const double composite = piece * model.m_pixel_time;
+    // k-1 pieces go out and k-1 come in. Compositing a piece overlaps
+    // with receiving the next one, so only the slower of the two counts,
+    // plus the faster one for the piece that cannot overlap
+    cost += (k - 1.) * std::max(send, composite) + std::min(send, composite);
+    tile = piece;
+  }
+  return cost;
+}
+
+int
+RadixKCompositor::ChooseRadixK(const vtkhdiy::RegularPartners::DivisionVector &divisions,
+                               const double pixels,
+                               const double fill,
+                               const Compositor::NetworkModel &model)
+{
+  int max_division = 2;
+  for(size_t i = 0; i < divisions.size(); ++i)
+  {
+    max_division = std::max(max_division, divisions[i]);
+  }
+
+  // k = 2 is binary swap, k = max_division is direct send per dimension
+  int best_k = 2;
+  double best_cost = std::numeric_limits<double>::max();
+  for(int k = 2; k <= max_division; ++k)
+  {
+    vtkhdiy::RegularPartners::KVSVector kvs;
+    vtkhdiy::RegularPartners::factor(k, divisions, kvs);
+    const double cost = EstimateCost(kvs, pixels, fill, model);
+    if(cost < best_cost)
+    {
+      best_cost = cost;
+      best_k = k;
+    }
+  }
+  return best_k;
+}
+
 std::string
 RadixKCompositor::GetTimingString()
 {
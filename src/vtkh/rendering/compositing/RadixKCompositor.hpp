@@ -1,22 +1,51 @@
 #ifndef VTKH_DIY_RADIX_K_HPP
 #define VTKH_DIY_RADIX_K_HPP
 
+#include <vtkh/vtkh_exports.h>
 #include <vtkh/rendering/Image.hpp>
+#include <vtkh/rendering/compositing/Compositor.hpp>
 #include <diy/mpi.hpp>
+#include <diy/partners/common.hpp>
 #include <sstream>
 
 namespace vtkh
 {
 
-class RadixKCompositor
+class VTKH_API RadixKCompositor
 {
 public:
   RadixKCompositor();
   ~RadixKCompositor();
   void CompositeSurface(vtkhdiy::mpi::communicator &diy_comm, Image &image);
+  // encode background spans of sparse sub-images before sending them
+  void SetRunLengthEncoding(bool on);
+  // gather depth along with color onto rank 0
+  void SetCollectDepth(bool on);
+  // target group size per round. Values < 2 pick k with the cost model
+  void SetRadixK(int k);
+  // split the image into one strip per rank and exchange them in a
+  // single round, instead of the 2d radix-k rounds
+  void SetDirectSend(bool on);
+  void SetNetworkModel(const Compositor::NetworkModel &model);
+  // estimated time to composite 'pixels' with the given rounds, where
+  // 'fill' is the fraction of non-background pixels. Larger groups pay
+  // more latency but hide more of the compositing behind communication
+  static double EstimateCost(const vtkhdiy::RegularPartners::KVSVector &kvs,
+                             const double pixels,
+                             const double fill,
+                             const Compositor::NetworkModel &model);
+  static int ChooseRadixK(const vtkhdiy::RegularPartners::DivisionVector &divisions,
+                          const double pixels,
+                          const double fill,
+                          const Compositor::NetworkModel &model);
   std::string GetTimingString();
 private:
-  std::stringstream m_timing_log;
+  std::stringstream        m_timing_log;
+  bool                     m_rle;
+  bool                     m_collect_depth;
+  int                      m_radix_k;
+  bool                     m_direct_send;
+  Compositor::NetworkModel m_model;
 };
 
 } // namspace vtkh
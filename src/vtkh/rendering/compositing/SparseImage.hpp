@@ -0,0 +1,239 @@
+#ifndef VTKH_SPARSE_IMAGE_HPP
+#define VTKH_SPARSE_IMAGE_HPP
+
+#include <vtkh/rendering/Image.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace vtkh
+{
+
+//
+// The message form of an Image during surface compositing. Only the
+// bounding rectangle of the active (depth <= 1) pixels is kept, and when
+// that rectangle is itself mostly empty the background spans inside it
+// are run length encoded so only active pixels are sent. Message size
+// then scales with the visible pixels instead of the image size.
+//
+struct SparseImage
+{
+  vtkm::Bounds                 m_orig_bounds;
+  // the region of the image this message covers
+  vtkm::Bounds                 m_bounds;
+  // bounding rectangle of the active pixels, empty if there are none
+  vtkm::Bounds                 m_active_bounds;
+  // alternating background and active run lengths over the active
+  // rectangle, starting with background. Empty when not encoded
+  std::vector<int>             m_runs;
+  std::vector<unsigned char>   m_pixels;
+  std::vector<float>           m_depths;
+  int                          m_orig_rank;
+  int                          m_composite_order;
+
+  SparseImage()
+    : m_orig_rank(-1),
+      m_composite_order(-1)
+  {}
+
+  bool IsEmpty() const
+  {
+    return !m_active_bounds.X.IsNonEmpty() || !m_active_bounds.Y.IsNonEmpty();
+  }
+
+  bool IsRunLengthEncoded() const
+  {
+    return m_runs.size() > 0;
+  }
+
+  //
+  // Shrinks the image to its active pixels. If 'allow_rle' is set,
+  // background spans are encoded when less than 'rle_threshold' of the
+  // active rectangle is covered
+  //
+  void Encode(const Image &image, bool allow_rle, float rle_threshold = 0.75f)
+  {
+    m_orig_bounds = image.m_orig_bounds;
+    m_bounds = image.m_bounds;
+    m_active_bounds = vtkm::Bounds();
+    m_orig_rank = image.m_orig_rank;
+    m_composite_order = image.m_composite_order;
+    m_runs.clear();
+    m_pixels.clear();
+    m_depths.clear();
+
+    const int dx = image.m_bounds.X.Max - image.m_bounds.X.Min + 1;
+    const int dy = image.m_bounds.Y.Max - image.m_bounds.Y.Min + 1;
+    if(image.m_depths.size() == 0 || dx < 1 || dy < 1)
+    {
+      return;
+    }
+
+    int x_min = dx;
+    int y_min = dy;
+    int x_max = -1;
+    int y_max = -1;
+    int active = 0;
+#ifdef VTKH_USE_OPENMP
+    #pragma omp parallel for reduction(min:x_min,y_min) reduction(max:x_max,y_max) reduction(+:active)
+#endif
+    for(int y = 0; y < dy; ++y)
+    {
+      const int row = y * dx;
+      for(int x = 0; x < dx; ++x)
+      {
+        if(image.m_depths[row + x] <= 1.f)
+        {
+          x_min = std::min(x_min, x);
+          x_max = std::max(x_max, x);
+          y_min = std::min(y_min, y);
+          y_max = std::max(y_max, y);
+          active++;
+        }
+      }
+    }
+
+    if(active == 0)
+    {
+      return;
+    }
+
+    m_active_bounds.X.Min = image.m_bounds.X.Min + x_min;
+    m_active_bounds.X.Max = image.m_bounds.X.Min + x_max;
+    m_active_bounds.Y.Min = image.m_bounds.Y.Min + y_min;
+    m_active_bounds.Y.Max = image.m_bounds.Y.Min + y_max;
+
+    const int a_dx = x_max - x_min + 1;
+    const int a_dy = y_max - y_min + 1;
+    const int area = a_dx * a_dy;
+    const bool rle = allow_rle && active < rle_threshold * area;
+
+    if(!rle)
+    {
+      m_pixels.resize(area * 4);
+      m_depths.resize(area);
+#ifdef VTKH_USE_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int y = 0; y < a_dy; ++y)
+      {
+        const int copy_from = (y + y_min) * dx + x_min;
+        const int copy_to = y * a_dx;
+        std::copy(&image.m_pixels[copy_from * 4],
+                  &image.m_pixels[copy_from * 4] + a_dx * 4,
+                  &m_pixels[copy_to * 4]);
+        std::copy(&image.m_depths[copy_from],
+                  &image.m_depths[copy_from] + a_dx,
+                  &m_depths[copy_to]);
+      }
+      return;
+    }
+
+    m_pixels.reserve(active * 4);
+    m_depths.reserve(active);
+    bool in_active = false;
+    int run = 0;
+    for(int y = 0; y < a_dy; ++y)
+    {
+      const int row = (y + y_min) * dx + x_min;
+      for(int x = 0; x < a_dx; ++x)
+      {
+        const int index = row + x;
+        const bool is_active = image.m_depths[index] <= 1.f;
+        if(is_active != in_active)
+        {
+          m_runs.push_back(run);
+          run = 0;
+          in_active = is_active;
+        }
+        run++;
+        if(is_active)
+        {
+          m_pixels.insert(m_pixels.end(),
+                          &image.m_pixels[index * 4],
+                          &image.m_pixels[index * 4] + 4);
+          m_depths.push_back(image.m_depths[index]);
+        }
+      }
+    }
+    m_runs.push_back(run);
+  }
+
+  //
+  // Z-buffer composites the active pixels into 'image', which must
+  // contain the active bounds
+  //
+  void CompositeInto(Image &image) const
+  {
+    if(IsEmpty())
+    {
+      return;
+    }
+
+    assert(m_active_bounds.X.Min >= image.m_bounds.X.Min);
+    assert(m_active_bounds.Y.Min >= image.m_bounds.Y.Min);
+    assert(m_active_bounds.X.Max <= image.m_bounds.X.Max);
+    assert(m_active_bounds.Y.Max <= image.m_bounds.Y.Max);
+
+    const int dx = image.m_bounds.X.Max - image.m_bounds.X.Min + 1;
+    const int a_dx = m_active_bounds.X.Max - m_active_bounds.X.Min + 1;
+    const int a_dy = m_active_bounds.Y.Max - m_active_bounds.Y.Min + 1;
+    const int start_x = m_active_bounds.X.Min - image.m_bounds.X.Min;
+    const int start_y = m_active_bounds.Y.Min - image.m_bounds.Y.Min;
+
+    if(!IsRunLengthEncoded())
+    {
+#ifdef VTKH_USE_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int y = 0; y < a_dy; ++y)
+      {
+        const int row = (y + start_y) * dx + start_x;
+        for(int x = 0; x < a_dx; ++x)
+        {
+          Composite(image, row + x, y * a_dx + x);
+        }
+      }
+      return;
+    }
+
+    const int num_runs = static_cast<int>(m_runs.size());
+    int index = 0;
+    int pixel = 0;
+    for(int i = 0; i < num_runs; ++i)
+    {
+      // even runs are background
+      if(i % 2 == 0)
+      {
+        index += m_runs[i];
+        continue;
+      }
+
+      const int run_end = index + m_runs[i];
+      for(; index < run_end; ++index, ++pixel)
+      {
+        const int x = index % a_dx;
+        const int y = index / a_dx;
+        Composite(image, (y + start_y) * dx + start_x + x, pixel);
+      }
+    }
+  }
+
+protected:
+  void Composite(Image &image, const int &dest, const int &src) const
+  {
+    const float depth = m_depths[src];
+    if(depth > 1.f || image.m_depths[dest] < depth)
+    {
+      return;
+    }
+    image.m_depths[dest] = depth;
+    image.m_pixels[dest * 4 + 0] = m_pixels[src * 4 + 0];
+    image.m_pixels[dest * 4 + 1] = m_pixels[src * 4 + 1];
+    image.m_pixels[dest * 4 + 2] = m_pixels[src * 4 + 2];
+    image.m_pixels[dest * 4 + 3] = m_pixels[src * 4 + 3];
+  }
+};
+
+} //namespace  vtkh
+#endif
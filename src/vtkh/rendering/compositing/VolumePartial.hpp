@@ -53,11 +53,15 @@ struct VolumePartial
   float                  m_depth;
   float                  m_pixel[3];
   float                  m_alpha;
+  // nearest scene depth of the fragments blended into this one. m_depth
+  // only orders the blend and need not be a scene depth
+  float                  m_front_depth;
 
   VolumePartial()
     : m_pixel_id(0),
       m_depth(0.f),
-      m_alpha(0.f)
+      m_alpha(0.f),
+      m_front_depth(std::numeric_limits<float>::max())
   {
     m_pixel[0] = 0;
     m_pixel[1] = 0;
@@ -85,6 +89,7 @@ struct VolumePartial
 
   inline void blend(const VolumePartial &other)
   {
+    m_front_depth = other.m_front_depth < m_front_depth ? other.m_front_depth : m_front_depth;
     if(m_alpha >= 1.f || other.m_alpha == 0.f) return;
     const float opacity = (1.f - m_alpha);
     m_pixel[0] +=  opacity * other.m_pixel[0];
@@ -2,6 +2,8 @@
 #define VTKH_DIY_IMAGE_BLOCK_HPP
 
 #include <vtkh/rendering/Image.hpp>
+#include <vtkh/rendering/compositing/SparseImage.hpp>
+#include <vtkh/rendering/compositing/vtkh_diy_image_codec.hpp>
 #include <diy/master.hpp>
 
 namespace vtkh
@@ -101,8 +103,7 @@ struct Serialization<vtkh::Image>
     vtkhdiy::save(bb, image.m_bounds.Y.Max);
     vtkhdiy::save(bb, image.m_bounds.Z.Max);
 
-    vtkhdiy::save(bb, image.m_pixels);
-    vtkhdiy::save(bb, image.m_depths);
+    vtkh::ImageCodec::SavePayload(bb, image.m_pixels, image.m_depths);
     vtkhdiy::save(bb, image.m_orig_rank);
     vtkhdiy::save(bb, image.m_composite_order);
   }
@@ -123,8 +124,33 @@ struct Serialization<vtkh::Image>
     vtkhdiy::load(bb, image.m_bounds.Y.Max);
     vtkhdiy::load(bb, image.m_bounds.Z.Max);
 
-    vtkhdiy::load(bb, image.m_pixels);
-    vtkhdiy::load(bb, image.m_depths);
+    vtkh::ImageCodec::LoadPayload(bb, image.m_pixels, image.m_depths);
+    vtkhdiy::load(bb, image.m_orig_rank);
+    vtkhdiy::load(bb, image.m_composite_order);
+  }
+};
+
+template<>
+struct Serialization<vtkh::SparseImage>
+{
+  static void save(BinaryBuffer &bb, const vtkh::SparseImage &image)
+  {
+    vtkhdiy::save(bb, image.m_orig_bounds);
+    vtkhdiy::save(bb, image.m_bounds);
+    vtkhdiy::save(bb, image.m_active_bounds);
+    vtkhdiy::save(bb, image.m_runs);
+    vtkh::ImageCodec::SavePayload(bb, image.m_pixels, image.m_depths);
+    vtkhdiy::save(bb, image.m_orig_rank);
+    vtkhdiy::save(bb, image.m_composite_order);
+  }
+
+  static void load(BinaryBuffer &bb, vtkh::SparseImage &image)
+  {
+    vtkhdiy::load(bb, image.m_orig_bounds);
+    vtkhdiy::load(bb, image.m_bounds);
+    vtkhdiy::load(bb, image.m_active_bounds);
+    vtkhdiy::load(bb, image.m_runs);
+    vtkh::ImageCodec::LoadPayload(bb, image.m_pixels, image.m_depths);
     vtkhdiy::load(bb, image.m_orig_rank);
     vtkhdiy::load(bb, image.m_composite_order);
   }
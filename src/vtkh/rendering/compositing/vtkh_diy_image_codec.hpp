@@ -0,0 +1,277 @@
+#ifndef VTKH_DIY_IMAGE_CODEC_HPP
+#define VTKH_DIY_IMAGE_CODEC_HPP
+
+#include <diy/serialization.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+namespace vtkh
+{
+
+//
+// Optional compression of the color and depth payloads of images sent
+// during compositing. Colors are run length encoded as 32-bit rgba
+// values. Depths are either sent losslessly or quantized to 24 or 16
+// bits first, with background (depth > 1) mapped to the largest code.
+// Each stream of each message picks raw or run length encoding based
+// on its run count, so the choice adapts as images get smaller and
+// denser every round. Settings are process wide since diy serialization
+// is static.
+//
+struct ImageCodec
+{
+  enum StreamMode
+  {
+    RAW = 0,
+    RUN_LENGTH = 1
+  };
+
+  static bool &Enabled()
+  {
+    static bool enabled = false;
+    return enabled;
+  }
+
+  // 32 is lossless, 24 or 16 quantize depths in [0,1]
+  static int &DepthBits()
+  {
+    static int bits = 32;
+    return bits;
+  }
+
+  static int CountRuns(const std::vector<uint32_t> &codes)
+  {
+    const int size = static_cast<int>(codes.size());
+    int runs = size > 0 ? 1 : 0;
+#ifdef VTKH_USE_OPENMP
+    #pragma omp parallel for reduction(+:runs)
+#endif
+    for(int i = 1; i < size; ++i)
+    {
+      if(codes[i] != codes[i-1])
+      {
+        runs++;
+      }
+    }
+    return runs;
+  }
+
+  // writes 'width' low order bytes of each code
+  static void SaveStream(vtkhdiy::BinaryBuffer &bb,
+                         const std::vector<uint32_t> &codes,
+                         const int width)
+  {
+    const int size = static_cast<int>(codes.size());
+    const int runs = CountRuns(codes);
+    // a run costs an int length on top of the value
+    const long long int run_bytes = width + static_cast<long long int>(sizeof(int));
+    const bool use_rle = static_cast<long long int>(runs) * run_bytes <
+                         static_cast<long long int>(size) * width;
+
+    unsigned char mode = use_rle ? RUN_LENGTH : RAW;
+    vtkhdiy::save(bb, mode);
+    vtkhdiy::save(bb, size);
+
+    std::vector<uint32_t> values;
+    if(use_rle)
+    {
+      std::vector<int> lengths;
+      lengths.reserve(runs);
+      values.reserve(runs);
+      for(int i = 0; i < size; ++i)
+      {
+        if(i == 0 || codes[i] != codes[i-1])
+        {
+          values.push_back(codes[i]);
+          lengths.push_back(0);
+        }
+        lengths.back()++;
+      }
+      vtkhdiy::save(bb, lengths);
+    }
+
+    const std::vector<uint32_t> &out = use_rle ? values : codes;
+    const int num_values = static_cast<int>(out.size());
+    std::vector<unsigned char> bytes(num_values * width);
+    for(int i = 0; i < num_values; ++i)
+    {
+      for(int b = 0; b < width; ++b)
+      {
+        bytes[i * width + b] = static_cast<unsigned char>((out[i] >> (8 * b)) & 0xff);
+      }
+    }
+    vtkhdiy::save(bb, bytes);
+  }
+
+  static void LoadStream(vtkhdiy::BinaryBuffer &bb,
+                         std::vector<uint32_t> &codes,
+                         const int width)
+  {
+    unsigned char mode;
+    int size;
+    vtkhdiy::load(bb, mode);
+    vtkhdiy::load(bb, size);
+
+    std::vector<int> lengths;
+    if(mode == RUN_LENGTH)
+    {
+      vtkhdiy::load(bb, lengths);
+    }
+
+    std::vector<unsigned char> bytes;
+    vtkhdiy::load(bb, bytes);
+    const int num_values = static_cast<int>(bytes.size()) / width;
+    std::vector<uint32_t> values(num_values, 0);
+    for(int i = 0; i < num_values; ++i)
+    {
+      for(int b = 0; b < width; ++b)
+      {
+        values[i] |= static_cast<uint32_t>(bytes[i * width + b]) << (8 * b);
+      }
+    }
+
+    if(mode == RAW)
+    {
+      codes.swap(values);
+      return;
+    }
+
+    codes.resize(size);
+    int index = 0;
+    for(int i = 0; i < num_values; ++i)
+    {
+      std::fill(codes.begin() + index, codes.begin() + index + lengths[i], values[i]);
+      index += lengths[i];
+    }
+  }
+
+  static void SaveColors(vtkhdiy::BinaryBuffer &bb, const std::vector<unsigned char> &pixels)
+  {
+    std::vector<uint32_t> codes(pixels.size() / 4);
+    if(codes.size() > 0)
+    {
+      std::memcpy(&codes[0], &pixels[0], pixels.size());
+    }
+    SaveStream(bb, codes, 4);
+  }
+
+  static void LoadColors(vtkhdiy::BinaryBuffer &bb, std::vector<unsigned char> &pixels)
+  {
+    std::vector<uint32_t> codes;
+    LoadStream(bb, codes, 4);
+    pixels.resize(codes.size() * 4);
+    if(codes.size() > 0)
+    {
+      std::memcpy(&pixels[0], &codes[0], pixels.size());
+    }
+  }
+
+  static void SaveDepths(vtkhdiy::BinaryBuffer &bb, const std::vector<float> &depths)
+  {
+    int bits = DepthBits();
+    if(bits != 16 && bits != 24)
+    {
+      bits = 32;
+    }
+    vtkhdiy::save(bb, bits);
+
+    const int size = static_cast<int>(depths.size());
+    std::vector<uint32_t> codes(size);
+    if(bits == 32)
+    {
+      if(size > 0)
+      {
+        std::memcpy(&codes[0], &depths[0], size * sizeof(float));
+      }
+    }
+    else
+    {
+      const uint32_t background = (1u << bits) - 1u;
+      const float scale = static_cast<float>(background - 1u);
+#ifdef VTKH_USE_OPENMP
+      #pragma omp parallel for
+#endif
+      for(int i = 0; i < size; ++i)
+      {
+        const float depth = depths[i];
+        codes[i] = depth > 1.f ? background
+                               : static_cast<uint32_t>(std::max(depth, 0.f) * scale + 0.5f);
+      }
+    }
+    SaveStream(bb, codes, bits / 8);
+  }
+
+  static void LoadDepths(vtkhdiy::BinaryBuffer &bb, std::vector<float> &depths)
+  {
+    int bits;
+    vtkhdiy::load(bb, bits);
+    std::vector<uint32_t> codes;
+    LoadStream(bb, codes, bits / 8);
+
+    const int size = static_cast<int>(codes.size());
+    depths.resize(size);
+    if(bits == 32)
+    {
+      if(size > 0)
+      {
+        std::memcpy(&depths[0], &codes[0], size * sizeof(float));
+      }
+      return;
+    }
+
+    const uint32_t background = (1u << bits) - 1u;
+    const float inv_scale = 1.f / static_cast<float>(background - 1u);
+#ifdef VTKH_USE_OPENMP
+    #pragma omp parallel for
+#endif
+    for(int i = 0; i < size; ++i)
+    {
+      // background goes back to the value Image::Init uses
+      depths[i] = codes[i] == background ? 2.f : static_cast<float>(codes[i]) * inv_scale;
+    }
+  }
+
+  static void SavePayload(vtkhdiy::BinaryBuffer &bb,
+                          const std::vector<unsigned char> &pixels,
+                          const std::vector<float> &depths)
+  {
+    const bool compress = Enabled();
+    vtkhdiy::save(bb, compress);
+    if(compress)
+    {
+      SaveColors(bb, pixels);
+      SaveDepths(bb, depths);
+    }
+    else
+    {
+      vtkhdiy::save(bb, pixels);
+      vtkhdiy::save(bb, depths);
+    }
+  }
+
+  static void LoadPayload(vtkhdiy::BinaryBuffer &bb,
+                          std::vector<unsigned char> &pixels,
+                          std::vector<float> &depths)
+  {
+    // the sender decides, so mixed settings still decode
+    bool compressed;
+    vtkhdiy::load(bb, compressed);
+    if(compressed)
+    {
+      LoadColors(bb, pixels);
+      LoadDepths(bb, depths);
+    }
+    else
+    {
+      vtkhdiy::load(bb, pixels);
+      vtkhdiy::load(bb, depths);
+    }
+  }
+};
+
+} //namespace vtkh
+
+#endif
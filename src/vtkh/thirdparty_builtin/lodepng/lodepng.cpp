@@ -2034,6 +2034,63 @@ unsigned lodepng_deflate(unsigned char** out, size_t* outsize,
   return error;
 }
 
+unsigned lodepng_deflate_chunk(unsigned char** out, size_t* outsize,
+                               const unsigned char* in, size_t insize,
+                               const LodePNGCompressSettings* settings,
+                               unsigned is_final)
+{
+  unsigned error = 0;
+  size_t i, blocksize, numdeflateblocks;
+  size_t bp = 0; /*the bit pointer*/
+  Hash hash;
+  ucvector v;
+
+  if(settings->btype != 1 && settings->btype != 2) return 61;
+  else if(settings->btype == 1) blocksize = insize;
+  else /*if(settings->btype == 2)*/
+  {
+    blocksize = insize / 8 + 8;
+    if(blocksize < 65536) blocksize = 65536;
+    if(blocksize > 262144) blocksize = 262144;
+  }
+
+  numdeflateblocks = (insize + blocksize - 1) / blocksize;
+  if(numdeflateblocks == 0) numdeflateblocks = 1;
+
+  error = hash_init(&hash, settings->windowsize);
+  if(error) return error;
+
+  ucvector_init_buffer(&v, *out, *outsize);
+
+  for(i = 0; i != numdeflateblocks && !error; ++i)
+  {
+    unsigned final = is_final && (i == numdeflateblocks - 1);
+    size_t start = i * blocksize;
+    size_t end = start + blocksize;
+    if(end > insize) end = insize;
+
+    if(settings->btype == 1) error = deflateFixed(&v, &bp, &hash, in, start, end, settings, final);
+    else error = deflateDynamic(&v, &bp, &hash, in, start, end, settings, final);
+  }
+
+  if(!error && !is_final)
+  {
+    /*empty stored block: BFINAL 0, BTYPE 00, pad to a byte, LEN 0, NLEN 0xffff*/
+    ucvector* pv = &v;
+    addBitToStream(&bp, pv, 0);
+    addBitToStream(&bp, pv, 0);
+    addBitToStream(&bp, pv, 0);
+    if(!ucvector_push_back(&v, 0) || !ucvector_push_back(&v, 0) ||
+       !ucvector_push_back(&v, 255) || !ucvector_push_back(&v, 255)) error = 83; /*alloc fail*/
+  }
+
+  hash_cleanup(&hash);
+
+  *out = v.data;
+  *outsize = v.size;
+  return error;
+}
+
 static unsigned deflate(unsigned char** out, size_t* outsize,
                         const unsigned char* in, size_t insize,
                         const LodePNGCompressSettings* settings)
@@ -789,6 +789,18 @@ unsigned lodepng_deflate(unsigned char** out, size_t* outsize,
                          const unsigned char* in, size_t insize,
                          const LodePNGCompressSettings* settings);
 
+/*
+VTK-h addition: compress one piece of a larger deflate stream. If is_final is
+0 the last block is not marked final and the output ends with an empty stored
+block (a zlib "sync flush"), so it is byte aligned and the compressed pieces
+of consecutive input chunks can be concatenated into one valid stream. Only
+btype 1 and 2 are supported.
+*/
+unsigned lodepng_deflate_chunk(unsigned char** out, size_t* outsize,
+                               const unsigned char* in, size_t insize,
+                               const LodePNGCompressSettings* settings,
+                               unsigned is_final);
+
 #endif /*LODEPNG_COMPILE_ENCODER*/
 #endif /*LODEPNG_COMPILE_ZLIB*/
 
@@ -0,0 +1,182 @@
+#include <vtkh/utils/AsyncQueue.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace vtkh
+{
+
+struct AsyncQueue::InternalsType
+{
+  std::thread             m_worker;
+  mutable std::mutex      m_lock;
+  std::condition_variable m_has_job;
+  std::condition_variable m_has_room;
+  std::condition_variable m_done;
+  std::deque<Job>         m_jobs;
+  std::exception_ptr      m_error;
+  int                     m_max_size;
+  int                     m_running;
+  int                     m_peak_size;
+  double                  m_wait_time;
+  bool                    m_stop;
+
+  InternalsType()
+    : m_max_size(4),
+      m_running(0),
+      m_peak_size(0),
+      m_wait_time(0.),
+      m_stop(false)
+  {
+  }
+
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+    while(true)
+    {
+      m_has_job.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+      if(m_jobs.empty())
+      {
+        // stop was requested and there is nothing left to do
+        return;
+      }
+
+      Job job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+      m_running = 1;
+      lock.unlock();
+      m_has_room.notify_one();
+
+      std::exception_ptr error;
+      try
+      {
+        job();
+      }
+      catch(...)
+      {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      // the first failure is kept for Flush, later ones are dropped
+      if(error && !m_error)
+      {
+        m_error = error;
+      }
+      m_running = 0;
+      if(m_jobs.empty())
+      {
+        m_done.notify_all();
+      }
+    }
+  }
+};
+
+AsyncQueue::AsyncQueue()
+  : m_internals(new InternalsType)
+{
+}
+
+AsyncQueue::~AsyncQueue()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_internals->m_lock);
+    m_internals->m_stop = true;
+  }
+  m_internals->m_has_job.notify_one();
+  if(m_internals->m_worker.joinable())
+  {
+    m_internals->m_worker.join();
+  }
+}
+
+void
+AsyncQueue::SetMaxSize(const int max_size)
+{
+  std::lock_guard<std::mutex> lock(m_internals->m_lock);
+  m_internals->m_max_size = std::max(1, max_size);
+}
+
+int
+AsyncQueue::GetMaxSize() const
+{
+  std::lock_guard<std::mutex> lock(m_internals->m_lock);
+  return m_internals->m_max_size;
+}
+
+void
+AsyncQueue::Push(Job job)
+{
+  InternalsType &in = *m_internals;
+  std::unique_lock<std::mutex> lock(in.m_lock);
+
+  if(!in.m_worker.joinable())
+  {
+    in.m_worker = std::thread(&InternalsType::Run, m_internals.get());
+  }
+
+  if(static_cast<int>(in.m_jobs.size()) >= in.m_max_size)
+  {
+    auto start = std::chrono::steady_clock::now();
+    in.m_has_room.wait(lock, [&in] { return static_cast<int>(in.m_jobs.size()) < in.m_max_size; });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    in.m_wait_time += elapsed.count();
+  }
+
+  in.m_jobs.push_back(std::move(job));
+  in.m_peak_size = std::max(in.m_peak_size,
+                            static_cast<int>(in.m_jobs.size()) + in.m_running);
+  lock.unlock();
+  in.m_has_job.notify_one();
+}
+
+void
+AsyncQueue::Flush()
+{
+  InternalsType &in = *m_internals;
+  std::unique_lock<std::mutex> lock(in.m_lock);
+  in.m_done.wait(lock, [&in] { return in.m_jobs.empty() && in.m_running == 0; });
+  if(in.m_error)
+  {
+    std::exception_ptr error = in.m_error;
+    in.m_error = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+int
+AsyncQueue::GetSize() const
+{
+  std::lock_guard<std::mutex> lock(m_internals->m_lock);
+  return static_cast<int>(m_internals->m_jobs.size()) + m_internals->m_running;
+}
+
+int
+AsyncQueue::GetPeakSize() const
+{
+  std::lock_guard<std::mutex> lock(m_internals->m_lock);
+  return m_internals->m_peak_size;
+}
+
+double
+AsyncQueue::GetWaitTime() const
+{
+  std::lock_guard<std::mutex> lock(m_internals->m_lock);
+  return m_internals->m_wait_time;
+}
+
+void
+AsyncQueue::ResetStatistics()
+{
+  std::lock_guard<std::mutex> lock(m_internals->m_lock);
+  m_internals->m_peak_size = 0;
+  m_internals->m_wait_time = 0.;
+}
+
+} //namespace vtkh
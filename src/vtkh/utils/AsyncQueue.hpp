@@ -0,0 +1,50 @@
+#ifndef VTK_H_ASYNC_QUEUE_HPP
+#define VTK_H_ASYNC_QUEUE_HPP
+
+#include <vtkh/vtkh_exports.h>
+#include <functional>
+#include <memory>
+
+namespace vtkh
+{
+
+//
+// A bounded job queue drained by one background thread. Push returns as
+// soon as there is room in the queue, so slow work (e.g. encoding and
+// writing images) overlaps with whatever the caller does next. When the
+// queue is full Push blocks, which bounds the memory held by pending jobs.
+// The worker starts with the first job and is joined on destruction after
+// the remaining jobs have run. A job that throws does not stop the worker;
+// the exception is handed back to the caller by Flush.
+//
+class VTKH_API AsyncQueue
+{
+public:
+  typedef std::function<void()> Job;
+
+  AsyncQueue();
+  ~AsyncQueue();
+
+  void   SetMaxSize(const int max_size);
+  int    GetMaxSize() const;
+
+  void   Push(Job job);
+  // blocks until every pushed job has finished, then rethrows the first
+  // exception a job threw since the last flush
+  void   Flush();
+
+  // jobs waiting or running
+  int    GetSize() const;
+  // largest size seen since the last reset
+  int    GetPeakSize() const;
+  // seconds Push spent blocked on a full queue since the last reset
+  double GetWaitTime() const;
+  void   ResetStatistics();
+private:
+  struct InternalsType;
+  std::shared_ptr<InternalsType> m_internals;
+};
+
+} //namespace vtkh
+
+#endif //VTK_H_ASYNC_QUEUE_HPP
@@ -0,0 +1,311 @@
+#include "ImageEncoders.hpp"
+
+#include <string.h>
+#include <fstream>
+#include <iostream>
+
+namespace vtkh
+{
+
+namespace detail
+{
+
+enum QOIOps
+{
+  QOI_OP_INDEX = 0x00,
+  QOI_OP_DIFF  = 0x40,
+  QOI_OP_LUMA  = 0x80,
+  QOI_OP_RUN   = 0xc0,
+  QOI_OP_RGB   = 0xfe,
+  QOI_OP_RGBA  = 0xff,
+  QOI_MASK_2   = 0xc0
+};
+
+const int qoi_header_size = 14;
+const unsigned char qoi_padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+inline int qoi_hash(const unsigned char *px)
+{
+  return (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+}
+
+inline void write_be32(std::vector<unsigned char> &out, const unsigned int v)
+{
+  out.push_back(static_cast<unsigned char>(v >> 24));
+  out.push_back(static_cast<unsigned char>(v >> 16));
+  out.push_back(static_cast<unsigned char>(v >> 8));
+  out.push_back(static_cast<unsigned char>(v));
+}
+
+inline unsigned int read_be32(const unsigned char *in)
+{
+  return (static_cast<unsigned int>(in[0]) << 24) |
+         (static_cast<unsigned int>(in[1]) << 16) |
+         (static_cast<unsigned int>(in[2]) << 8) |
+          static_cast<unsigned int>(in[3]);
+}
+
+inline void write_le32(unsigned char *out, const unsigned int v)
+{
+  out[0] = static_cast<unsigned char>(v);
+  out[1] = static_cast<unsigned char>(v >> 8);
+  out[2] = static_cast<unsigned char>(v >> 16);
+  out[3] = static_cast<unsigned char>(v >> 24);
+}
+
+bool save_buffer(const std::vector<unsigned char> &buffer, const std::string &filename)
+{
+  if(buffer.empty())
+  {
+    std::cerr<<"Save must be called after encode()\n";
+    return false;
+  }
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+  file.write(reinterpret_cast<const char*>(&buffer[0]), buffer.size());
+  if(!file)
+  {
+    std::cerr<<"Error saving image buffer to file: "<<filename<<"\n";
+    return false;
+  }
+  return true;
+}
+
+} // namespace detail
+
+void
+QOIEncoder::Encode(const unsigned char *rgba_in,
+                   const int width,
+                   const int height)
+{
+  m_buffer.clear();
+  // worst case is 5 bytes a pixel
+  m_buffer.reserve(detail::qoi_header_size + width * height * 5 + 8);
+
+  m_buffer.push_back('q');
+  m_buffer.push_back('o');
+  m_buffer.push_back('i');
+  m_buffer.push_back('f');
+  detail::write_be32(m_buffer, width);
+  detail::write_be32(m_buffer, height);
+  m_buffer.push_back(4); // channels
+  m_buffer.push_back(0); // sRGB with linear alpha
+
+  unsigned char index[64 * 4];
+  memset(index, 0, sizeof(index));
+  unsigned char prev[4] = {0, 0, 0, 255};
+  int run = 0;
+
+  for(int y = 0; y < height; ++y)
+  {
+    // upside down relative to what the file wants
+    const unsigned char *row = rgba_in + (height - y - 1) * width * 4;
+    for(int x = 0; x < width; ++x)
+    {
+      const unsigned char *px = row + x * 4;
+      if(memcmp(px, prev, 4) == 0)
+      {
+        run++;
+        if(run == 62)
+        {
+          m_buffer.push_back(detail::QOI_OP_RUN | (run - 1));
+          run = 0;
+        }
+        continue;
+      }
+
+      if(run > 0)
+      {
+        m_buffer.push_back(detail::QOI_OP_RUN | (run - 1));
+        run = 0;
+      }
+
+      const int hash = detail::qoi_hash(px);
+      if(memcmp(index + hash * 4, px, 4) == 0)
+      {
+        m_buffer.push_back(detail::QOI_OP_INDEX | hash);
+      }
+      else
+      {
+        memcpy(index + hash * 4, px, 4);
+        if(px[3] == prev[3])
+        {
+          const signed char vr = static_cast<signed char>(px[0] - prev[0]);
+          const signed char vg = static_cast<signed char>(px[1] - prev[1]);
+          const signed char vb = static_cast<signed char>(px[2] - prev[2]);
+          const signed char vg_r = static_cast<signed char>(vr - vg);
+          const signed char vg_b = static_cast<signed char>(vb - vg);
+
+          if(vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+          {
+            m_buffer.push_back(detail::QOI_OP_DIFF |
+                               (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+          }
+          else if(vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+          {
+            m_buffer.push_back(detail::QOI_OP_LUMA | (vg + 32));
+            m_buffer.push_back((vg_r + 8) << 4 | (vg_b + 8));
+          }
+          else
+          {
+            m_buffer.push_back(detail::QOI_OP_RGB);
+            m_buffer.push_back(px[0]);
+            m_buffer.push_back(px[1]);
+            m_buffer.push_back(px[2]);
+          }
+        }
+        else
+        {
+          m_buffer.push_back(detail::QOI_OP_RGBA);
+          m_buffer.insert(m_buffer.end(), px, px + 4);
+        }
+      }
+      memcpy(prev, px, 4);
+    }
+  }
+
+  if(run > 0)
+  {
+    m_buffer.push_back(detail::QOI_OP_RUN | (run - 1));
+  }
+  m_buffer.insert(m_buffer.end(), detail::qoi_padding, detail::qoi_padding + 8);
+}
+
+bool
+QOIEncoder::Decode(const unsigned char *qoi,
+                   const size_t size,
+                   std::vector<unsigned char> &rgba_out,
+                   int &width,
+                   int &height)
+{
+  if(size < detail::qoi_header_size + 8 || memcmp(qoi, "qoif", 4) != 0)
+  {
+    return false;
+  }
+  width = static_cast<int>(detail::read_be32(qoi + 4));
+  height = static_cast<int>(detail::read_be32(qoi + 8));
+  const size_t pixels = static_cast<size_t>(width) * height;
+  rgba_out.resize(pixels * 4);
+
+  unsigned char index[64 * 4];
+  memset(index, 0, sizeof(index));
+  unsigned char px[4] = {0, 0, 0, 255};
+  size_t pos = detail::qoi_header_size;
+  const size_t end = size - 8;
+  int run = 0;
+
+  for(size_t i = 0; i < pixels; ++i)
+  {
+    if(run > 0)
+    {
+      run--;
+    }
+    else if(pos < end)
+    {
+      const unsigned char b1 = qoi[pos++];
+      if(b1 == detail::QOI_OP_RGB)
+      {
+        if(pos + 3 > end) return false;
+        px[0] = qoi[pos++];
+        px[1] = qoi[pos++];
+        px[2] = qoi[pos++];
+      }
+      else if(b1 == detail::QOI_OP_RGBA)
+      {
+        if(pos + 4 > end) return false;
+        memcpy(px, qoi + pos, 4);
+        pos += 4;
+      }
+      else if((b1 & detail::QOI_MASK_2) == detail::QOI_OP_INDEX)
+      {
+        memcpy(px, index + b1 * 4, 4);
+      }
+      else if((b1 & detail::QOI_MASK_2) == detail::QOI_OP_DIFF)
+      {
+        px[0] += ((b1 >> 4) & 0x03) - 2;
+        px[1] += ((b1 >> 2) & 0x03) - 2;
+        px[2] += (b1 & 0x03) - 2;
+      }
+      else if((b1 & detail::QOI_MASK_2) == detail::QOI_OP_LUMA)
+      {
+        if(pos + 1 > end) return false;
+        const unsigned char b2 = qoi[pos++];
+        const int vg = (b1 & 0x3f) - 32;
+        px[0] += vg - 8 + ((b2 >> 4) & 0x0f);
+        px[1] += vg;
+        px[2] += vg - 8 + (b2 & 0x0f);
+      }
+      else // QOI_OP_RUN
+      {
+        run = b1 & 0x3f;
+      }
+      memcpy(index + detail::qoi_hash(px) * 4, px, 4);
+    }
+    else
+    {
+      return false;
+    }
+    memcpy(&rgba_out[i * 4], px, 4);
+  }
+  return true;
+}
+
+bool
+QOIEncoder::Save(const std::string &filename)
+{
+  return detail::save_buffer(m_buffer, filename);
+}
+
+const std::vector<unsigned char>&
+QOIEncoder::GetBuffer() const
+{
+  return m_buffer;
+}
+
+void
+RawImageEncoder::Encode(const unsigned char *rgba_in,
+                        const float *depth_in,
+                        const int width,
+                        const int height)
+{
+  const size_t header_size = 24;
+  const size_t pixels = static_cast<size_t>(width) * height;
+  const size_t depth_size = depth_in != NULL ? pixels * sizeof(float) : 0;
+  m_buffer.resize(header_size + pixels * 4 + depth_size);
+
+  unsigned char *out = &m_buffer[0];
+  memcpy(out, "VTKHRAW1", 8);
+  detail::write_le32(out + 8, width);
+  detail::write_le32(out + 12, height);
+  detail::write_le32(out + 16, 4);
+  detail::write_le32(out + 20, depth_in != NULL ? 1 : 0);
+
+  unsigned char *color = out + header_size;
+  unsigned char *depth = color + pixels * 4;
+  const int row_size = width * 4;
+  for(int y = 0; y < height; ++y)
+  {
+    const int src_row = height - y - 1;
+    memcpy(color + y * row_size, rgba_in + src_row * row_size, row_size);
+    if(depth_in != NULL)
+    {
+      // x86 and the GPUs we run on are little endian
+      memcpy(depth + y * width * sizeof(float),
+             depth_in + src_row * width,
+             width * sizeof(float));
+    }
+  }
+}
+
+bool
+RawImageEncoder::Save(const std::string &filename)
+{
+  return detail::save_buffer(m_buffer, filename);
+}
+
+const std::vector<unsigned char>&
+RawImageEncoder::GetBuffer() const
+{
+  return m_buffer;
+}
+
+} // namespace vtkh
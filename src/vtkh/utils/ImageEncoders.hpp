@@ -0,0 +1,72 @@
+#ifndef VTKH_IMAGE_ENCODERS_HPP
+#define VTKH_IMAGE_ENCODERS_HPP
+
+#include <vtkh/vtkh_exports.h>
+#include <string>
+#include <vector>
+
+namespace vtkh
+{
+
+//
+// Lossless encoders that are much cheaper than PNG when the images go to
+// another program instead of a person. Like PNGEncoder, the input is
+// bottom-up RGBA and the output is stored top-down.
+//
+
+//
+// QOI (https://qoiformat.org): single pass, byte oriented run / index /
+// delta coding. Typically several times faster than deflate with files
+// 20-50% larger than PNG.
+//
+class VTKH_API QOIEncoder
+{
+public:
+  void Encode(const unsigned char *rgba_in,
+              const int width,
+              const int height);
+  // false if the file could not be written
+  bool Save(const std::string &filename);
+
+  const std::vector<unsigned char>& GetBuffer() const;
+
+  // decodes a QOI stream into top-down RGBA, returns false on bad input
+  static bool Decode(const unsigned char *qoi,
+                     const size_t size,
+                     std::vector<unsigned char> &rgba_out,
+                     int &width,
+                     int &height);
+private:
+  std::vector<unsigned char> m_buffer;
+};
+
+//
+// Uncompressed color and optional depth behind a 24 byte header:
+//   char[8]  magic "VTKHRAW1"
+//   uint32   width
+//   uint32   height
+//   uint32   channels (4, RGBA8)
+//   uint32   has depth (0 or 1)
+// followed by width * height * 4 bytes of color and, if present,
+// width * height little endian float32 depths. All integers are little
+// endian.
+//
+class VTKH_API RawImageEncoder
+{
+public:
+  // depth_in may be null
+  void Encode(const unsigned char *rgba_in,
+              const float *depth_in,
+              const int width,
+              const int height);
+  // false if the file could not be written
+  bool Save(const std::string &filename);
+
+  const std::vector<unsigned char>& GetBuffer() const;
+private:
+  std::vector<unsigned char> m_buffer;
+};
+
+} // namespace vtkh
+
+#endif
@@ -1,8 +1,14 @@
 #include "PNGEncoder.hpp"
+#include "PixelKernels.hpp"
 
 // standard includes
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 // thirdparty includes
 #include <lodepng.h>
@@ -10,11 +16,240 @@
 namespace vtkh
 {
 
+namespace detail
+{
+
+struct DeflateContext
+{
+  int m_num_threads;
+};
+
+// pigz style deflate: the filtered scanlines are split into chunks that are
+// compressed independently and joined with sync flushes. Chunks do not see
+// the previous chunk's window, which costs a little compression.
+unsigned parallel_deflate(unsigned char **out,
+                          size_t *outsize,
+                          const unsigned char *in,
+                          size_t insize,
+                          const LodePNGCompressSettings *settings)
+{
+  const DeflateContext *context =
+    reinterpret_cast<const DeflateContext*>(settings->custom_context);
+
+  LodePNGCompressSettings chunk_settings = *settings;
+  chunk_settings.custom_deflate = 0;
+  chunk_settings.custom_context = 0;
+
+  const size_t min_chunk = 128 * 1024;
+  const size_t num_threads = static_cast<size_t>(context->m_num_threads);
+  size_t num_chunks = std::min(num_threads * 2, (insize + min_chunk - 1) / min_chunk);
+
+  if(num_chunks < 2 || num_threads < 2 || settings->btype == 0)
+  {
+    return lodepng_deflate(out, outsize, in, insize, &chunk_settings);
+  }
+
+  const size_t chunk_size = (insize + num_chunks - 1) / num_chunks;
+  num_chunks = (insize + chunk_size - 1) / chunk_size;
+
+  std::vector<unsigned char*> chunks(num_chunks, NULL);
+  std::vector<size_t> chunk_sizes(num_chunks, 0);
+  std::vector<unsigned> errors(num_chunks, 0);
+  std::atomic<size_t> next_chunk(0);
+
+  auto worker = [&]()
+  {
+    size_t i;
+    while((i = next_chunk++) < num_chunks)
+    {
+      const size_t begin = i * chunk_size;
+      const size_t size = std::min(chunk_size, insize - begin);
+      const unsigned is_final = i == num_chunks - 1;
+      errors[i] = lodepng_deflate_chunk(&chunks[i],
+                                        &chunk_sizes[i],
+                                        in + begin,
+                                        size,
+                                        &chunk_settings,
+                                        is_final);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const size_t num_workers = std::min(num_threads, num_chunks);
+  for(size_t i = 1; i < num_workers; ++i)
+  {
+    threads.push_back(std::thread(worker));
+  }
+  worker();
+  for(size_t i = 0; i < threads.size(); ++i)
+  {
+    threads[i].join();
+  }
+
+  unsigned error = 0;
+  size_t total_size = 0;
+  for(size_t i = 0; i < num_chunks; ++i)
+  {
+    if(errors[i] != 0) error = errors[i];
+    total_size += chunk_sizes[i];
+  }
+
+  if(error == 0)
+  {
+    *out = static_cast<unsigned char*>(malloc(total_size));
+    *outsize = total_size;
+    if(*out == NULL)
+    {
+      error = 83; // lodepng alloc failure
+    }
+    else
+    {
+      size_t offset = 0;
+      for(size_t i = 0; i < num_chunks; ++i)
+      {
+        memcpy(*out + offset, chunks[i], chunk_sizes[i]);
+        offset += chunk_sizes[i];
+      }
+    }
+  }
+
+  for(size_t i = 0; i < num_chunks; ++i)
+  {
+    free(chunks[i]);
+  }
+  return error;
+}
+
+void set_compression_level(LodePNGCompressSettings &settings, const int level)
+{
+  lodepng_compress_settings_init(&settings);
+  if(level <= 0)
+  {
+    settings.btype = 0;
+  }
+  else if(level <= 3)
+  {
+    settings.windowsize = 256 << (level - 1);
+    settings.nicematch = 32 << (level - 1);
+    settings.lazymatching = 0;
+  }
+  else if(level <= 6)
+  {
+    // level 6 is the lodepng default
+    settings.windowsize = 2048;
+    settings.nicematch = 32 << (level - 4);
+    settings.lazymatching = 1;
+  }
+  else
+  {
+    settings.windowsize = 8192 << (std::min(level, 9) - 7);
+    settings.nicematch = 258;
+    settings.lazymatching = 1;
+  }
+}
+
+unsigned adler32(unsigned adler, const unsigned char *data, size_t size)
+{
+  unsigned s1 = adler & 0xffff;
+  unsigned s2 = adler >> 16;
+  while(size > 0)
+  {
+    // largest run before s2 can overflow
+    const size_t run = std::min(size, size_t(5552));
+    for(size_t i = 0; i < run; ++i)
+    {
+      s1 += data[i];
+      s2 += s1;
+    }
+    s1 %= 65521;
+    s2 %= 65521;
+    data += run;
+    size -= run;
+  }
+  return (s2 << 16) | s1;
+}
+
+void put32(unsigned char *out, const unsigned value)
+{
+  out[0] = static_cast<unsigned char>(value >> 24);
+  out[1] = static_cast<unsigned char>(value >> 16);
+  out[2] = static_cast<unsigned char>(value >> 8);
+  out[3] = static_cast<unsigned char>(value);
+}
+
+unsigned char paeth(const int a, const int b, const int c)
+{
+  const int p = a + b - c;
+  const int pa = abs(p - a);
+  const int pb = abs(p - b);
+  const int pc = abs(p - c);
+  if(pa <= pb && pa <= pc) return static_cast<unsigned char>(a);
+  if(pb <= pc) return static_cast<unsigned char>(b);
+  return static_cast<unsigned char>(c);
+}
+
+// filters one rgba8 scanline into out (filter byte + row), picking the
+// filter with the smallest sum of signed residuals like lodepng does
+void filter_row(unsigned char *out,
+                const unsigned char *row,
+                const unsigned char *prev,
+                const size_t row_bytes,
+                std::vector<unsigned char> &scratch)
+{
+  const size_t bpp = 4;
+  scratch.resize(row_bytes);
+  size_t best_sum = ~size_t(0);
+  for(unsigned char type = 0; type < 5; ++type)
+  {
+    size_t sum = 0;
+    for(size_t i = 0; i < row_bytes; ++i)
+    {
+      const int a = i >= bpp ? row[i - bpp] : 0;
+      const int b = prev[i];
+      const int c = i >= bpp ? prev[i - bpp] : 0;
+      int predict = 0;
+      switch(type)
+      {
+        case 1: predict = a; break;
+        case 2: predict = b; break;
+        case 3: predict = (a + b) / 2; break;
+        case 4: predict = paeth(a, b, c); break;
+        default: break;
+      }
+      const unsigned char value = static_cast<unsigned char>(row[i] - predict);
+      scratch[i] = value;
+      sum += value < 128 ? value : 256 - value;
+    }
+    if(sum < best_sum)
+    {
+      best_sum = sum;
+      out[0] = type;
+      memcpy(out + 1, &scratch[0], row_bytes);
+    }
+  }
+}
+
+} // namespace detail
+
 PNGEncoder::PNGEncoder()
 :m_buffer(NULL),
- m_buffer_size(0)
+ m_buffer_size(0),
+ m_compression_level(6),
+ m_num_threads(0)
 {}
 
+void
+PNGEncoder::SetCompressionLevel(const int level)
+{
+    m_compression_level = level;
+}
+
+void
+PNGEncoder::SetNumThreads(const int num_threads)
+{
+    m_num_threads = num_threads;
+}
+
 PNGEncoder::~PNGEncoder()
 {
     Cleanup();
@@ -37,20 +272,9 @@ PNGEncoder::Encode(const unsigned char *rgba_in,
                width*4);
     }
 
-     unsigned error = lodepng_encode_memory(&m_buffer,
-                                            &m_buffer_size,
-                                            &rgba_flip[0],
-                                            width,
-                                            height,
-                                            LCT_RGBA, // these settings match those for
-                                            8);       // lodepng_encode32_file
+    EncodeFlipped(rgba_flip, width, height);
 
     delete [] rgba_flip;
-
-    if(error)
-    {
-      std::cerr<<"lodepng_encode_memory failed\n";
-    }
 }
 
 void
@@ -64,45 +288,57 @@ PNGEncoder::Encode(const float *rgba_in,
     unsigned char *rgba_flip = new unsigned char[width * height *4];
 
 
-    for(int x = 0; x < width; ++x)
-
-#ifdef VTKH_USE_OPENMP
-        #pragma omp parallel for
-#endif
-        for (int y = 0; y < height; ++y)
-        {
-            int inOffset = (y * width + x) * 4;
-            int outOffset = ((height - y - 1) * width + x) * 4;
-            rgba_flip[outOffset + 0] = (unsigned char)(rgba_in[inOffset + 0] * 255.f);
-            rgba_flip[outOffset + 1] = (unsigned char)(rgba_in[inOffset + 1] * 255.f);
-            rgba_flip[outOffset + 2] = (unsigned char)(rgba_in[inOffset + 2] * 255.f);
-            rgba_flip[outOffset + 3] = (unsigned char)(rgba_in[inOffset + 3] * 255.f);
-        }
-
-     unsigned error = lodepng_encode_memory(&m_buffer,
-                                            &m_buffer_size,
-                                            &rgba_flip[0],
-                                            width,
-                                            height,
-                                            LCT_RGBA, // these settings match those for
-                                            8);       // lodepng_encode32_file
+    for (int y = 0; y < height; ++y)
+    {
+        PixelKernels::FloatToUChar(&(rgba_in[y*width*4]),
+                                   &(rgba_flip[(height-y-1)*width*4]),
+                                   width*4);
+    }
+
+    EncodeFlipped(rgba_flip, width, height);
 
     delete [] rgba_flip;
+}
+
+void
+PNGEncoder::EncodeFlipped(const unsigned char *rgba_flip,
+                          const int width,
+                          const int height)
+{
+    detail::DeflateContext context;
+    context.m_num_threads = m_num_threads > 0
+                          ? m_num_threads
+                          : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    LodePNGState state;
+    lodepng_state_init(&state);
+    // these settings match those for lodepng_encode32_file
+    state.info_raw.colortype = LCT_RGBA;
+    state.info_raw.bitdepth = 8;
+    state.info_png.color.colortype = LCT_RGBA;
+    state.info_png.color.bitdepth = 8;
+    detail::set_compression_level(state.encoder.zlibsettings, m_compression_level);
+    state.encoder.zlibsettings.custom_deflate = detail::parallel_deflate;
+    state.encoder.zlibsettings.custom_context = &context;
+
+    lodepng_encode(&m_buffer, &m_buffer_size, rgba_flip, width, height, &state);
+    unsigned error = state.error;
+    lodepng_state_cleanup(&state);
 
     if(error)
     {
-      std::cerr<<"lodepng_encode_memory failed\n";
+      std::cerr<<"lodepng_encode failed: "<<lodepng_error_text(error)<<"\n";
     }
 }
 
-void
+bool
 PNGEncoder::Save(const std::string &filename)
 {
     if(m_buffer == NULL)
     {
       std::cerr<<"Save must be called after encode()\n";
         /// we have a problem ...!
-        return;
+        return false;
     }
 
     unsigned error = lodepng_save_file(m_buffer,
@@ -111,7 +347,9 @@ PNGEncoder::Save(const std::string &filename)
     if(error)
     {
       std::cerr<<"Error saving PNG buffer to file: " << filename<<"\n";
+      return false;
     }
+    return true;
 }
 
 void *
@@ -140,7 +378,194 @@ PNGEncoder::Cleanup()
     }
 }
 
-};
+TiledPNGWriter::TiledPNGWriter()
+  : m_file(NULL),
+    m_width(0),
+    m_height(0),
+    m_rows_written(0),
+    m_compression_level(6),
+    m_adler(1)
+{}
+
+TiledPNGWriter::~TiledPNGWriter()
+{
+    if(m_file != NULL)
+    {
+      fclose(m_file);
+    }
+}
+
+void
+TiledPNGWriter::SetCompressionLevel(const int level)
+{
+    m_compression_level = level;
+}
+
+bool
+TiledPNGWriter::WriteChunk(const char *type,
+                           const unsigned char *data,
+                           const size_t size)
+{
+    unsigned char *chunk = NULL;
+    size_t chunk_size = 0;
+    unsigned error = lodepng_chunk_create(&chunk,
+                                          &chunk_size,
+                                          static_cast<unsigned>(size),
+                                          type,
+                                          data);
+    bool ok = error == 0 && fwrite(chunk, 1, chunk_size, m_file) == chunk_size;
+    free(chunk);
+    if(!ok)
+    {
+      std::cerr<<"Error writing PNG chunk to file: "<<m_filename<<"\n";
+    }
+    return ok;
+}
+
+bool
+TiledPNGWriter::Open(const std::string &filename,
+                     const int width,
+                     const int height)
+{
+    if(m_file != NULL)
+    {
+      fclose(m_file);
+    }
+    m_filename = filename;
+    m_width = width;
+    m_height = height;
+    m_rows_written = 0;
+    m_adler = 1;
+    m_prev_row.assign(size_t(width) * 4, 0);
+
+    m_file = fopen(filename.c_str(), "wb");
+    if(m_file == NULL)
+    {
+      std::cerr<<"Error opening PNG file: "<<filename<<"\n";
+      return false;
+    }
+
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    if(fwrite(signature, 1, 8, m_file) != 8)
+    {
+      std::cerr<<"Error writing PNG file: "<<filename<<"\n";
+      return false;
+    }
+
+    unsigned char header[13];
+    detail::put32(header, static_cast<unsigned>(width));
+    detail::put32(header + 4, static_cast<unsigned>(height));
+    header[8] = 8;  // bit depth
+    header[9] = 6;  // rgba
+    header[10] = 0; // deflate
+    header[11] = 0; // adaptive filtering
+    header[12] = 0; // not interlaced
+    return WriteChunk("IHDR", header, 13);
+}
+
+bool
+TiledPNGWriter::AddBand(const unsigned char *rgba_in,
+                        const int band_height)
+{
+    if(m_file == NULL) return false;
+    if(band_height < 1 || m_rows_written + band_height > m_height)
+    {
+      std::cerr<<"TiledPNGWriter: band of "<<band_height<<" rows does not fit in "
+               <<m_filename<<"\n";
+      return false;
+    }
+
+    const size_t row_bytes = size_t(m_width) * 4;
+    const size_t filtered_row = row_bytes + 1;
+    std::vector<unsigned char> filtered(filtered_row * band_height);
+    std::vector<unsigned char> scratch;
+    // canvas rows are bottom up, png rows top down
+    for(int y = 0; y < band_height; ++y)
+    {
+      const unsigned char *row = rgba_in + (band_height - y - 1) * row_bytes;
+      detail::filter_row(&filtered[y * filtered_row], row, &m_prev_row[0], row_bytes, scratch);
+      memcpy(&m_prev_row[0], row, row_bytes);
+    }
+    m_adler = detail::adler32(m_adler, &filtered[0], filtered.size());
 
+    const bool is_first = m_rows_written == 0;
+    m_rows_written += band_height;
+    const bool is_final = m_rows_written == m_height;
 
+    unsigned char *deflated = NULL;
+    size_t deflated_size = 0;
+    LodePNGCompressSettings settings;
+    detail::set_compression_level(settings, m_compression_level);
+    if(settings.btype != 0)
+    {
+      unsigned error = lodepng_deflate_chunk(&deflated,
+                                             &deflated_size,
+                                             &filtered[0],
+                                             filtered.size(),
+                                             &settings,
+                                             is_final);
+      if(error)
+      {
+        free(deflated);
+        std::cerr<<"lodepng_deflate_chunk failed: "<<lodepng_error_text(error)<<"\n";
+        return false;
+      }
+    }
 
+    // zlib header, then either the deflated band or stored blocks
+    std::vector<unsigned char> data;
+    if(is_first)
+    {
+      data.push_back(0x78);
+      data.push_back(0x01);
+    }
+    if(deflated != NULL)
+    {
+      data.insert(data.end(), deflated, deflated + deflated_size);
+      free(deflated);
+    }
+    else
+    {
+      const size_t max_block = 65535;
+      for(size_t offset = 0; offset < filtered.size(); offset += max_block)
+      {
+        const size_t size = std::min(max_block, filtered.size() - offset);
+        const bool last = is_final && offset + size == filtered.size();
+        data.push_back(last ? 1 : 0);
+        data.push_back(static_cast<unsigned char>(size & 0xff));
+        data.push_back(static_cast<unsigned char>(size >> 8));
+        data.push_back(static_cast<unsigned char>(~size & 0xff));
+        data.push_back(static_cast<unsigned char>((~size >> 8) & 0xff));
+        data.insert(data.end(), &filtered[offset], &filtered[offset] + size);
+      }
+    }
+    if(is_final)
+    {
+      unsigned char adler[4];
+      detail::put32(adler, m_adler);
+      data.insert(data.end(), adler, adler + 4);
+    }
+
+    return WriteChunk("IDAT", &data[0], data.size());
+}
+
+bool
+TiledPNGWriter::Close()
+{
+    if(m_file == NULL) return false;
+    bool ok = m_rows_written == m_height;
+    if(!ok)
+    {
+      std::cerr<<"TiledPNGWriter: "<<m_rows_written<<" of "<<m_height
+               <<" rows were written to "<<m_filename<<"\n";
+    }
+    else
+    {
+      ok = WriteChunk("IEND", NULL, 0);
+    }
+    fclose(m_file);
+    m_file = NULL;
+    return ok;
+}
+
+};
@@ -2,7 +2,9 @@
 #define VTKH_PNG_ENCODER_HPP
 
 #include <vtkh/vtkh_exports.h>
+#include <stdio.h>
 #include <string>
+#include <vector>
 
 namespace vtkh
 {
@@ -13,13 +15,19 @@ public:
     PNGEncoder();
     ~PNGEncoder();
 
+    // zlib style level: 0 stores, 1 is fastest, 9 is smallest. Default 6
+    void           SetCompressionLevel(const int level);
+    // threads used to deflate row chunks. <= 0 uses all hardware threads
+    void           SetNumThreads(const int num_threads);
+
     void           Encode(const unsigned char *rgba_in,
                           const int width,
                           const int height);
     void           Encode(const float *rgba_in,
                           const int width,
                           const int height);
-    void           Save(const std::string &filename);
+    // false if there is nothing encoded or the file could not be written
+    bool           Save(const std::string &filename);
 
     void          *PngBuffer();
     size_t         PngBufferSize();
@@ -27,8 +35,52 @@ public:
     void           Cleanup();
 
 private:
+    void           EncodeFlipped(const unsigned char *rgba_flip,
+                                 const int width,
+                                 const int height);
+
     unsigned char *m_buffer;
     size_t         m_buffer_size;
+    int            m_compression_level;
+    int            m_num_threads;
+};
+
+//
+// Writes a png one band of full width rows at a time, so the image is
+// never in memory as a whole. Bands are added from the top of the image
+// down, each with its rows bottom up like a canvas. Every band becomes
+// its own IDAT chunk, deflated without the previous band's window.
+//
+class VTKH_API TiledPNGWriter
+{
+public:
+    TiledPNGWriter();
+    ~TiledPNGWriter();
+
+    // see PNGEncoder::SetCompressionLevel
+    void           SetCompressionLevel(const int level);
+
+    bool           Open(const std::string &filename,
+                        const int width,
+                        const int height);
+    bool           AddBand(const unsigned char *rgba_in,
+                           const int band_height);
+    // finishes the file. Fails if fewer rows than the height were added
+    bool           Close();
+
+private:
+    bool           WriteChunk(const char *type,
+                              const unsigned char *data,
+                              const size_t size);
+
+    FILE                      *m_file;
+    std::string                m_filename;
+    int                        m_width;
+    int                        m_height;
+    int                        m_rows_written;
+    int                        m_compression_level;
+    unsigned                   m_adler;
+    std::vector<unsigned char> m_prev_row;
 };
 
 } // namespace vtkh
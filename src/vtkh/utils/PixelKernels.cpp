@@ -0,0 +1,589 @@
+#include "PixelKernels.hpp"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VTKH_PIXEL_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace vtkh
+{
+
+namespace detail
+{
+
+typedef void (*PixelPairKernel)(unsigned char *,
+                                float *,
+                                const unsigned char *,
+                                const float *,
+                                const int);
+typedef void (*BackgroundKernel)(unsigned char *, const unsigned char *, const int);
+typedef void (*ToUCharKernel)(const float *, unsigned char *, const int);
+typedef void (*ToFloatKernel)(const unsigned char *, float *, const int);
+
+//-----------------------------------------------------------------------------
+// scalar versions
+//-----------------------------------------------------------------------------
+inline unsigned char under(const unsigned int opacity, const unsigned char back)
+{
+  return static_cast<unsigned char>(opacity * back / 255);
+}
+
+void blend_under_scalar(unsigned char *front,
+                        float *front_depths,
+                        const unsigned char *back,
+                        const float *back_depths,
+                        const int num_pixels)
+{
+  for(int i = 0; i < num_pixels; ++i)
+  {
+    const int offset = i * 4;
+    const unsigned int opacity = 255 - front[offset + 3];
+    front[offset + 0] += under(opacity, back[offset + 0]);
+    front[offset + 1] += under(opacity, back[offset + 1]);
+    front[offset + 2] += under(opacity, back[offset + 2]);
+    front[offset + 3] += under(opacity, back[offset + 3]);
+
+    const float d1 = std::min(front_depths[i], 1.001f);
+    const float d2 = std::min(back_depths[i], 1.001f);
+    front_depths[i] = std::min(d1, d2);
+  }
+}
+
+void blend_background_scalar(unsigned char *pixels,
+                             const unsigned char *color,
+                             const int num_pixels)
+{
+  for(int i = 0; i < num_pixels; ++i)
+  {
+    const int offset = i * 4;
+    const unsigned int opacity = 255 - pixels[offset + 3];
+    pixels[offset + 0] += under(opacity, color[0]);
+    pixels[offset + 1] += under(opacity, color[1]);
+    pixels[offset + 2] += under(opacity, color[2]);
+    pixels[offset + 3] += under(opacity, color[3]);
+  }
+}
+
+void zbuffer_scalar(unsigned char *front,
+                    float *front_depths,
+                    const unsigned char *back,
+                    const float *back_depths,
+                    const int num_pixels)
+{
+  for(int i = 0; i < num_pixels; ++i)
+  {
+    const float depth = back_depths[i];
+    if(depth > 1.f || front_depths[i] < depth)
+    {
+      continue;
+    }
+    const int offset = i * 4;
+    front_depths[i] = depth;
+    front[offset + 0] = back[offset + 0];
+    front[offset + 1] = back[offset + 1];
+    front[offset + 2] = back[offset + 2];
+    front[offset + 3] = back[offset + 3];
+  }
+}
+
+void to_uchar_scalar(const float *in, unsigned char *out, const int size)
+{
+  for(int i = 0; i < size; ++i)
+  {
+    out[i] = static_cast<unsigned char>(in[i] * 255.f);
+  }
+}
+
+void to_float_scalar(const unsigned char *in, float *out, const int size)
+{
+  const float one_over_255 = 1.f / 255.f;
+  for(int i = 0; i < size; ++i)
+  {
+    out[i] = static_cast<float>(in[i]) * one_over_255;
+  }
+}
+
+#ifdef VTKH_PIXEL_KERNELS_X86
+//-----------------------------------------------------------------------------
+// SSE2 versions: 4 pixels per iteration. Products of two bytes fit in
+// 16 bits and x / 255 == (x + 1 + (x >> 8)) >> 8 for all of them, so the
+// integer math matches the scalar division exactly.
+//-----------------------------------------------------------------------------
+__attribute__((target("sse2")))
+inline __m128i div255_sse2(const __m128i x)
+{
+  const __m128i one = _mm_set1_epi16(1);
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+}
+
+// returns front + (255 - front alpha) * back / 255 for 4 pixels
+__attribute__((target("sse2")))
+inline __m128i under_sse2(const __m128i front, const __m128i back)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max = _mm_set1_epi16(255);
+  // alpha of each pixel repeated for its 4 channels
+  const __m128i alpha32 = _mm_srli_epi32(front, 24);
+  __m128i alpha16 = _mm_packs_epi32(alpha32, alpha32);
+  alpha16 = _mm_unpacklo_epi16(alpha16, alpha16);
+  const __m128i op_lo = _mm_sub_epi16(max, _mm_unpacklo_epi32(alpha16, alpha16));
+  const __m128i op_hi = _mm_sub_epi16(max, _mm_unpackhi_epi32(alpha16, alpha16));
+
+  const __m128i back_lo = _mm_unpacklo_epi8(back, zero);
+  const __m128i back_hi = _mm_unpackhi_epi8(back, zero);
+  const __m128i res_lo = div255_sse2(_mm_mullo_epi16(op_lo, back_lo));
+  const __m128i res_hi = div255_sse2(_mm_mullo_epi16(op_hi, back_hi));
+  // byte adds wrap like the scalar unsigned char +=
+  return _mm_add_epi8(front, _mm_packus_epi16(res_lo, res_hi));
+}
+
+__attribute__((target("sse2")))
+void blend_under_sse2(unsigned char *front,
+                      float *front_depths,
+                      const unsigned char *back,
+                      const float *back_depths,
+                      const int num_pixels)
+{
+  const __m128 clamp = _mm_set1_ps(1.001f);
+  const int simd_pixels = num_pixels - num_pixels % 4;
+  for(int i = 0; i < simd_pixels; i += 4)
+  {
+    __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(front + i * 4));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(back + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(front + i * 4), under_sse2(f, b));
+
+    __m128 d1 = _mm_min_ps(_mm_loadu_ps(front_depths + i), clamp);
+    __m128 d2 = _mm_min_ps(_mm_loadu_ps(back_depths + i), clamp);
+    _mm_storeu_ps(front_depths + i, _mm_min_ps(d1, d2));
+  }
+  blend_under_scalar(front + simd_pixels * 4,
+                     front_depths + simd_pixels,
+                     back + simd_pixels * 4,
+                     back_depths + simd_pixels,
+                     num_pixels - simd_pixels);
+}
+
+__attribute__((target("sse2")))
+void blend_background_sse2(unsigned char *pixels,
+                           const unsigned char *color,
+                           const int num_pixels)
+{
+  int packed;
+  std::copy(color, color + 4, reinterpret_cast<unsigned char*>(&packed));
+  const __m128i b = _mm_set1_epi32(packed);
+  const int simd_pixels = num_pixels - num_pixels % 4;
+  for(int i = 0; i < simd_pixels; i += 4)
+  {
+    __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), under_sse2(f, b));
+  }
+  blend_background_scalar(pixels + simd_pixels * 4, color, num_pixels - simd_pixels);
+}
+
+__attribute__((target("sse2")))
+void zbuffer_sse2(unsigned char *front,
+                  float *front_depths,
+                  const unsigned char *back,
+                  const float *back_depths,
+                  const int num_pixels)
+{
+  const __m128 one = _mm_set1_ps(1.f);
+  const int simd_pixels = num_pixels - num_pixels % 4;
+  for(int i = 0; i < simd_pixels; i += 4)
+  {
+    const __m128 fd = _mm_loadu_ps(front_depths + i);
+    const __m128 bd = _mm_loadu_ps(back_depths + i);
+    // same predicate as the scalar loop, one rgba pixel per depth lane
+    const __m128 keep = _mm_or_ps(_mm_cmpgt_ps(bd, one), _mm_cmplt_ps(fd, bd));
+    const __m128i keep_i = _mm_castps_si128(keep);
+
+    _mm_storeu_ps(front_depths + i,
+                  _mm_or_ps(_mm_and_ps(keep, fd), _mm_andnot_ps(keep, bd)));
+
+    __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(front + i * 4));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(back + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(front + i * 4),
+                     _mm_or_si128(_mm_and_si128(keep_i, f), _mm_andnot_si128(keep_i, b)));
+  }
+  zbuffer_scalar(front + simd_pixels * 4,
+                 front_depths + simd_pixels,
+                 back + simd_pixels * 4,
+                 back_depths + simd_pixels,
+                 num_pixels - simd_pixels);
+}
+
+__attribute__((target("sse2")))
+void to_uchar_sse2(const float *in, unsigned char *out, const int size)
+{
+  const __m128 scale = _mm_set1_ps(255.f);
+  const int simd_size = size - size % 16;
+  for(int i = 0; i < simd_size; i += 16)
+  {
+    __m128i c0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 0), scale));
+    __m128i c1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale));
+    __m128i c2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 8), scale));
+    __m128i c3 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 12), scale));
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+  }
+  to_uchar_scalar(in + simd_size, out + simd_size, size - simd_size);
+}
+
+__attribute__((target("sse2")))
+void to_float_sse2(const unsigned char *in, float *out, const int size)
+{
+  const __m128 scale = _mm_set1_ps(1.f / 255.f);
+  const __m128i zero = _mm_setzero_si128();
+  const int simd_size = size - size % 16;
+  for(int i = 0; i < simd_size; i += 16)
+  {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_ps(out + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+    _mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+    _mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+  }
+  to_float_scalar(in + simd_size, out + simd_size, size - simd_size);
+}
+
+//-----------------------------------------------------------------------------
+// AVX2 versions: 8 pixels per iteration. Unpacks work inside each 128 bit
+// lane, so the lo / hi halves hold pixels {0,1,4,5} / {2,3,6,7} and the
+// final pack puts them back in order.
+//-----------------------------------------------------------------------------
+__attribute__((target("avx2")))
+inline __m256i div255_avx2(const __m256i x)
+{
+  const __m256i one = _mm256_set1_epi16(1);
+  return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, one),
+                                            _mm256_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+inline __m256i under_avx2(const __m256i front, const __m256i back)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max = _mm256_set1_epi16(255);
+  const __m256i alpha32 = _mm256_srli_epi32(front, 24);
+  __m256i alpha16 = _mm256_packs_epi32(alpha32, alpha32);
+  alpha16 = _mm256_unpacklo_epi16(alpha16, alpha16);
+  const __m256i op_lo = _mm256_sub_epi16(max, _mm256_unpacklo_epi32(alpha16, alpha16));
+  const __m256i op_hi = _mm256_sub_epi16(max, _mm256_unpackhi_epi32(alpha16, alpha16));
+
+  const __m256i back_lo = _mm256_unpacklo_epi8(back, zero);
+  const __m256i back_hi = _mm256_unpackhi_epi8(back, zero);
+  const __m256i res_lo = div255_avx2(_mm256_mullo_epi16(op_lo, back_lo));
+  const __m256i res_hi = div255_avx2(_mm256_mullo_epi16(op_hi, back_hi));
+  return _mm256_add_epi8(front, _mm256_packus_epi16(res_lo, res_hi));
+}
+
+__attribute__((target("avx2")))
+void blend_under_avx2(unsigned char *front,
+                      float *front_depths,
+                      const unsigned char *back,
+                      const float *back_depths,
+                      const int num_pixels)
+{
+  const __m256 clamp = _mm256_set1_ps(1.001f);
+  const int simd_pixels = num_pixels - num_pixels % 8;
+  for(int i = 0; i < simd_pixels; i += 8)
+  {
+    __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(front + i * 4));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(back + i * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(front + i * 4), under_avx2(f, b));
+
+    __m256 d1 = _mm256_min_ps(_mm256_loadu_ps(front_depths + i), clamp);
+    __m256 d2 = _mm256_min_ps(_mm256_loadu_ps(back_depths + i), clamp);
+    _mm256_storeu_ps(front_depths + i, _mm256_min_ps(d1, d2));
+  }
+  blend_under_scalar(front + simd_pixels * 4,
+                     front_depths + simd_pixels,
+                     back + simd_pixels * 4,
+                     back_depths + simd_pixels,
+                     num_pixels - simd_pixels);
+}
+
+__attribute__((target("avx2")))
+void blend_background_avx2(unsigned char *pixels,
+                           const unsigned char *color,
+                           const int num_pixels)
+{
+  int packed;
+  std::copy(color, color + 4, reinterpret_cast<unsigned char*>(&packed));
+  const __m256i b = _mm256_set1_epi32(packed);
+  const int simd_pixels = num_pixels - num_pixels % 8;
+  for(int i = 0; i < simd_pixels; i += 8)
+  {
+    __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4), under_avx2(f, b));
+  }
+  blend_background_scalar(pixels + simd_pixels * 4, color, num_pixels - simd_pixels);
+}
+
+__attribute__((target("avx2")))
+void zbuffer_avx2(unsigned char *front,
+                  float *front_depths,
+                  const unsigned char *back,
+                  const float *back_depths,
+                  const int num_pixels)
+{
+  const __m256 one = _mm256_set1_ps(1.f);
+  const int simd_pixels = num_pixels - num_pixels % 8;
+  for(int i = 0; i < simd_pixels; i += 8)
+  {
+    const __m256 fd = _mm256_loadu_ps(front_depths + i);
+    const __m256 bd = _mm256_loadu_ps(back_depths + i);
+    const __m256 keep = _mm256_or_ps(_mm256_cmp_ps(bd, one, _CMP_GT_OQ),
+                                     _mm256_cmp_ps(fd, bd, _CMP_LT_OQ));
+    _mm256_storeu_ps(front_depths + i, _mm256_blendv_ps(bd, fd, keep));
+
+    __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(front + i * 4));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(back + i * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(front + i * 4),
+                        _mm256_blendv_epi8(b, f, _mm256_castps_si256(keep)));
+  }
+  zbuffer_scalar(front + simd_pixels * 4,
+                 front_depths + simd_pixels,
+                 back + simd_pixels * 4,
+                 back_depths + simd_pixels,
+                 num_pixels - simd_pixels);
+}
+
+__attribute__((target("avx2")))
+void to_uchar_avx2(const float *in, unsigned char *out, const int size)
+{
+  const __m256 scale = _mm256_set1_ps(255.f);
+  // undo the lane interleaving of the two packs
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  const int simd_size = size - size % 32;
+  for(int i = 0; i < simd_size; i += 32)
+  {
+    __m256i c0 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + i + 0), scale));
+    __m256i c1 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale));
+    __m256i c2 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + i + 16), scale));
+    __m256i c3 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + i + 24), scale));
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(c0, c1),
+                                         _mm256_packs_epi32(c2, c3));
+    packed = _mm256_permutevar8x32_epi32(packed, order);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+  }
+  to_uchar_scalar(in + simd_size, out + simd_size, size - simd_size);
+}
+
+__attribute__((target("avx2")))
+void to_float_avx2(const unsigned char *in, float *out, const int size)
+{
+  const __m256 scale = _mm256_set1_ps(1.f / 255.f);
+  const int simd_size = size - size % 8;
+  for(int i = 0; i < simd_size; i += 8)
+  {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+    __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(values, scale));
+  }
+  to_float_scalar(in + simd_size, out + simd_size, size - simd_size);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// dispatch
+//-----------------------------------------------------------------------------
+struct KernelTable
+{
+  PixelKernels::InstructionSet m_isa;
+  PixelPairKernel              m_blend_under;
+  BackgroundKernel             m_blend_background;
+  PixelPairKernel              m_zbuffer;
+  ToUCharKernel                m_to_uchar;
+  ToFloatKernel                m_to_float;
+
+  void Set(PixelKernels::InstructionSet isa)
+  {
+    m_isa = isa;
+    m_blend_under = blend_under_scalar;
+    m_blend_background = blend_background_scalar;
+    m_zbuffer = zbuffer_scalar;
+    m_to_uchar = to_uchar_scalar;
+    m_to_float = to_float_scalar;
+#ifdef VTKH_PIXEL_KERNELS_X86
+    if(isa == PixelKernels::SSE2)
+    {
+      m_blend_under = blend_under_sse2;
+      m_blend_background = blend_background_sse2;
+      m_zbuffer = zbuffer_sse2;
+      m_to_uchar = to_uchar_sse2;
+      m_to_float = to_float_sse2;
+    }
+    else if(isa == PixelKernels::AVX2)
+    {
+      m_blend_under = blend_under_avx2;
+      m_blend_background = blend_background_avx2;
+      m_zbuffer = zbuffer_avx2;
+      m_to_uchar = to_uchar_avx2;
+      m_to_float = to_float_avx2;
+    }
+#endif
+  }
+};
+
+KernelTable make_kernels()
+{
+  PixelKernels::InstructionSet best = PixelKernels::SCALAR;
+  if(PixelKernels::IsSupported(PixelKernels::AVX2))
+  {
+    best = PixelKernels::AVX2;
+  }
+  else if(PixelKernels::IsSupported(PixelKernels::SSE2))
+  {
+    best = PixelKernels::SSE2;
+  }
+  KernelTable table;
+  table.Set(best);
+  return table;
+}
+
+KernelTable &kernels()
+{
+  static KernelTable table = make_kernels();
+  return table;
+}
+
+// pixels per task when OpenMP is on, a multiple of every vector width
+const int chunk_size = 1 << 14;
+
+} // namespace detail
+
+PixelKernels::InstructionSet
+PixelKernels::GetInstructionSet()
+{
+  return detail::kernels().m_isa;
+}
+
+bool
+PixelKernels::SetInstructionSet(InstructionSet isa)
+{
+  if(!IsSupported(isa))
+  {
+    return false;
+  }
+  detail::kernels().Set(isa);
+  return true;
+}
+
+bool
+PixelKernels::IsSupported(InstructionSet isa)
+{
+  if(isa == SCALAR)
+  {
+    return true;
+  }
+#ifdef VTKH_PIXEL_KERNELS_X86
+  if(isa == SSE2)
+  {
+    return __builtin_cpu_supports("sse2");
+  }
+  if(isa == AVX2)
+  {
+    return __builtin_cpu_supports("avx2");
+  }
+#endif
+  return false;
+}
+
+const char*
+PixelKernels::GetName(InstructionSet isa)
+{
+  if(isa == SSE2) return "sse2";
+  if(isa == AVX2) return "avx2";
+  return "scalar";
+}
+
+void
+PixelKernels::BlendUnder(unsigned char *front,
+                         float *front_depths,
+                         const unsigned char *back,
+                         const float *back_depths,
+                         const int num_pixels)
+{
+  detail::PixelPairKernel kernel = detail::kernels().m_blend_under;
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < num_pixels; i += detail::chunk_size)
+  {
+    const int count = std::min(detail::chunk_size, num_pixels - i);
+    kernel(front + i * 4, front_depths + i, back + i * 4, back_depths + i, count);
+  }
+}
+
+void
+PixelKernels::BlendBackground(unsigned char *pixels,
+                              const unsigned char color[4],
+                              const int num_pixels)
+{
+  detail::BackgroundKernel kernel = detail::kernels().m_blend_background;
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < num_pixels; i += detail::chunk_size)
+  {
+    const int count = std::min(detail::chunk_size, num_pixels - i);
+    kernel(pixels + i * 4, color, count);
+  }
+}
+
+void
+PixelKernels::ZBufferComposite(unsigned char *front,
+                               float *front_depths,
+                               const unsigned char *back,
+                               const float *back_depths,
+                               const int num_pixels)
+{
+  detail::PixelPairKernel kernel = detail::kernels().m_zbuffer;
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < num_pixels; i += detail::chunk_size)
+  {
+    const int count = std::min(detail::chunk_size, num_pixels - i);
+    kernel(front + i * 4, front_depths + i, back + i * 4, back_depths + i, count);
+  }
+}
+
+void
+PixelKernels::FloatToUChar(const float *in,
+                           unsigned char *out,
+                           const int size)
+{
+  detail::ToUCharKernel kernel = detail::kernels().m_to_uchar;
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < size; i += detail::chunk_size)
+  {
+    const int count = std::min(detail::chunk_size, size - i);
+    kernel(in + i, out + i, count);
+  }
+}
+
+void
+PixelKernels::UCharToFloat(const unsigned char *in,
+                           float *out,
+                           const int size)
+{
+  detail::ToFloatKernel kernel = detail::kernels().m_to_float;
+#ifdef VTKH_USE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i = 0; i < size; i += detail::chunk_size)
+  {
+    const int count = std::min(detail::chunk_size, size - i);
+    kernel(in + i, out + i, count);
+  }
+}
+
+} // namespace vtkh
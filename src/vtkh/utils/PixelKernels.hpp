@@ -0,0 +1,64 @@
+#ifndef VTK_H_PIXEL_KERNELS_HPP
+#define VTK_H_PIXEL_KERNELS_HPP
+
+#include <vtkh/vtkh_exports.h>
+
+namespace vtkh
+{
+
+//
+// Per pixel loops shared by compositing and image conversion. Colors are
+// packed RGBA bytes and depths are floats where anything > 1 is background.
+// Each kernel has a scalar version and, on x86, SSE2 and AVX2 versions.
+// The widest one the cpu supports is picked the first time a kernel runs.
+// All versions produce bit identical results for colors in [0,1].
+//
+class VTKH_API PixelKernels
+{
+public:
+  enum InstructionSet
+  {
+    SCALAR = 0,
+    SSE2,
+    AVX2
+  };
+
+  static InstructionSet GetInstructionSet();
+  // returns false and leaves the current set if 'isa' is not supported
+  static bool SetInstructionSet(InstructionSet isa);
+  static bool IsSupported(InstructionSet isa);
+  static const char* GetName(InstructionSet isa);
+
+  // front = front + (1 - front alpha) * back, depth = min of both
+  static void BlendUnder(unsigned char *front,
+                         float *front_depths,
+                         const unsigned char *back,
+                         const float *back_depths,
+                         const int num_pixels);
+
+  // blends a constant color under every pixel
+  static void BlendBackground(unsigned char *pixels,
+                              const unsigned char color[4],
+                              const int num_pixels);
+
+  // keep the closer of the two pixels, background back pixels are ignored
+  static void ZBufferComposite(unsigned char *front,
+                               float *front_depths,
+                               const unsigned char *back,
+                               const float *back_depths,
+                               const int num_pixels);
+
+  // out = in * 255 truncated
+  static void FloatToUChar(const float *in,
+                           unsigned char *out,
+                           const int size);
+
+  // out = in / 255
+  static void UCharToFloat(const unsigned char *in,
+                           float *out,
+                           const int size);
+};
+
+} //namespace vtkh
+
+#endif //VTK_H_PIXEL_KERNELS_HPP